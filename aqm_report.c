@@ -0,0 +1,283 @@
+#include "shared.h"
+#include "host.h"
+#include "chip_emulator.h"
+#include "fq_codel.h"
+#include "phy_model.h"
+#include "aqm_report.h"
+#include "sim_device.h"
+#include "report_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define AQM_DEFAULT_LINK            "ax20-mcs7-1ss"
+#define AQM_DEFAULT_DURATION_MS     2000
+#define AQM_DEFAULT_BULK_FLOWS      4
+#define AQM_DEFAULT_BULK_MBPS       40     // Above what the default link and ring sustain
+#define AQM_DEFAULT_SPARSE_US       10000
+#define AQM_DEFAULT_FIFO_LIMIT      1000   // Frames, like a default txqueuelen
+#define AQM_MAX_FIFO                10000
+#define AQM_BULK_LEN                1500
+#define AQM_SPARSE_LEN              64
+#define AQM_SPARSE_FLOW             (FQ_CODEL_FLOWS - 1) // Own queue while bulk flows < 63
+
+// Every frame starts with its arrival time and class, so the TX sink can time it
+#define AQM_STAMP_LEN               9
+
+enum aqm_qdisc {
+    AQM_FIFO,
+    AQM_FQ_CODEL,
+    AQM_QDISCS,
+};
+
+static const char *const aqm_qdisc_names[AQM_QDISCS] = { "fifo", "fq_codel" };
+
+struct aqm_config {
+    const char *link;
+    struct phy_config phy;
+    uint32_t duration_ms;
+    uint32_t bulk_flows;
+    uint32_t bulk_mbps;
+    uint32_t sparse_us;
+    uint32_t fifo_limit;
+    enum host_txq_policy fifo_policy;
+    uint32_t ring_limit;       // FQ-CoDel in-flight limit (0: whole ring)
+    unsigned seed;
+};
+
+// Delays of the frames of one class that made it out
+struct aqm_samples {
+    uint64_t *ns;
+    size_t count;
+    size_t cap;
+};
+
+struct aqm_run {
+    const struct sim_device *dev;
+    struct aqm_samples delay[2];   // [0] bulk, [1] sparse
+    uint64_t bulk_bytes;
+    uint64_t offered;
+    uint64_t dropped;
+};
+
+static void aqm_samples_add(struct aqm_samples *s, uint64_t v) {
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 4096;
+        uint64_t *ns = realloc(s->ns, cap * sizeof(*ns));
+        if (ns == NULL) {
+            return; // Sample lost; the percentiles stay meaningful
+        }
+        s->ns = ns;
+        s->cap = cap;
+    }
+    s->ns[s->count++] = v;
+}
+
+// Percentile in ms of the sorted samples
+static double aqm_pct_ms(const struct aqm_samples *s, unsigned pct) {
+    return s->count ? s->ns[(s->count - 1) * pct / 100] / 1e6 : 0.0;
+}
+
+static void aqm_stamp_write(uint8_t *frame, uint64_t arrival_ns, int sparse) {
+    memcpy(frame, &arrival_ns, sizeof(arrival_ns));
+    frame[8] = (uint8_t)sparse;
+}
+
+static void aqm_on_tx(void *ctx, const uint8_t *first, uint32_t first_len,
+                      const uint8_t *second, uint32_t second_len) {
+    struct aqm_run *run = ctx;
+    uint8_t raw[AQM_STAMP_LEN];
+    uint32_t n = (first_len < AQM_STAMP_LEN) ? first_len : AQM_STAMP_LEN;
+    (void)second_len;
+    memcpy(raw, first, n);
+    memcpy(raw + n, second, AQM_STAMP_LEN - n); // The stamp may wrap the ring end
+
+    uint64_t arrival_ns;
+    memcpy(&arrival_ns, raw, sizeof(arrival_ns));
+    int sparse = raw[8];
+    aqm_samples_add(&run->delay[sparse], run->dev->time_ns - arrival_ns);
+    if (!sparse) {
+        run->bulk_bytes += first_len + second_len;
+    }
+}
+
+static void aqm_run_qdisc(enum aqm_qdisc qdisc, const struct aqm_config *cfg, struct aqm_run *run) {
+    static struct sim_device dev;
+    static struct host_chip host;
+    static struct chip_emulator chip;
+    static struct fq_codel fq;
+    uint8_t frame[AQM_BULK_LEN];
+
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_gen_percent = 0;
+    chip_cfg.seed = cfg->seed;
+    chip_cfg.phy = cfg->phy;
+
+    struct host_chip_bus bus;
+    sim_device_init(&dev);
+    sim_device_host_bus(&dev, &bus);
+    host_chip_driver_init(&host, &bus);
+    chip_emulator_init(&chip, &dev, &chip_cfg);
+    chip_emulator_set_tx_sink(&chip, aqm_on_tx, run);
+    run->dev = &dev;
+
+    struct fq_codel_config fq_cfg = FQ_CODEL_DEFAULT_CONFIG;
+    fq_cfg.ring_limit_bytes = cfg->ring_limit;
+    fq_codel_init(&fq, &fq_cfg);
+
+    // Reference qdisc: the driver's own software TX queue, a plain FIFO
+    uint8_t *fifo_buf = NULL;
+    if (qdisc == AQM_FIFO) {
+        struct host_txq_config txq_cfg = { cfg->fifo_limit, 0, cfg->fifo_policy };
+        uint32_t size = cfg->fifo_limit * (AQM_BULK_LEN + PACKET_LENGTH_FIELD_SIZE) + TX_BUFFER_SIZE;
+        fifo_buf = malloc(size);
+        if (fifo_buf == NULL || host_chip_enable_txq(&host, &txq_cfg, fifo_buf, size) != 0) {
+            free(fifo_buf);
+            return;
+        }
+    }
+
+    srand(cfg->seed);
+    double bulk_gap_ns = AQM_BULK_LEN * 8.0 * 1000.0 / cfg->bulk_mbps;
+    uint64_t next_bulk = report_next_gap(bulk_gap_ns);
+    uint64_t next_sparse = cfg->sparse_us * 1000ULL;
+    uint64_t end_ns = cfg->duration_ms * 1000000ULL;
+    uint32_t bulk_seq = 0;
+    memset(frame, 0xA5, sizeof(frame));
+
+    while (dev.time_ns < end_ns) {
+        uint64_t now = dev.time_ns;
+
+        // Arrivals: bulk flows round robin, and the periodic sparse flow
+        while (next_bulk <= now || next_sparse <= now) {
+            int sparse = (next_sparse <= next_bulk);
+            uint64_t arrival = sparse ? next_sparse : next_bulk;
+            uint32_t len = sparse ? AQM_SPARSE_LEN : AQM_BULK_LEN;
+            uint32_t flow = sparse ? AQM_SPARSE_FLOW : bulk_seq++ % cfg->bulk_flows;
+            if (sparse) {
+                next_sparse += cfg->sparse_us * 1000ULL;
+            } else {
+                next_bulk += report_next_gap(bulk_gap_ns);
+            }
+            run->offered++;
+
+            aqm_stamp_write(frame, arrival, sparse);
+            if (qdisc == AQM_FQ_CODEL) {
+                fq_codel_enqueue(&fq, flow, frame, len, now);
+            } else {
+                host_chip_send_packet(&host, frame, len); // Parked behind the ring when full
+            }
+        }
+
+        // HOST: feed the ring (the FIFO drains itself on sends and TX space interrupts)
+        if (qdisc == AQM_FQ_CODEL) {
+            fq_codel_feed(&fq, &host, now);
+        }
+
+        chip_emulator_run_cycle(&chip);
+        if (BUS_READ_REG(bus.regs, CHIP_REG_INT_STATUS) != 0) {
+            host_chip_irq_handler(&host);
+        }
+    }
+
+    if (qdisc == AQM_FQ_CODEL) {
+        run->dropped += fq.stats.codel_drops + fq.stats.overlimit_drops;
+    } else {
+        run->dropped += host.stats.tx_dropped;
+        host_chip_disable_txq(&host);
+        free(fifo_buf);
+    }
+}
+
+static void aqm_usage(void) {
+    fprintf(stderr,
+            "usage: wifi_ring_buffer_sim --aqm-report [--link NAME] [--duration-ms MS] [--bulk-flows N]\n"
+            "                                         [--bulk-mbps N] [--sparse-us US] [--fifo-limit N]\n"
+            "                                         [--fifo-drop new|oldest] [--ring-limit BYTES] [--seed N]\n");
+}
+
+int aqm_report_main(int argc, char **argv) {
+    struct aqm_config cfg = {
+        .link = AQM_DEFAULT_LINK,
+        .duration_ms = AQM_DEFAULT_DURATION_MS,
+        .bulk_flows = AQM_DEFAULT_BULK_FLOWS,
+        .bulk_mbps = AQM_DEFAULT_BULK_MBPS,
+        .sparse_us = AQM_DEFAULT_SPARSE_US,
+        .fifo_limit = AQM_DEFAULT_FIFO_LIMIT,
+        .fifo_policy = HOST_TXQ_DROP_NEW,
+        .ring_limit = 0,
+        .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (val == NULL) {
+            aqm_usage();
+            return 2;
+        }
+        if (strcmp(arg, "--link") == 0) {
+            cfg.link = val;
+        } else if (strcmp(arg, "--duration-ms") == 0) {
+            cfg.duration_ms = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--bulk-flows") == 0) {
+            cfg.bulk_flows = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--bulk-mbps") == 0) {
+            cfg.bulk_mbps = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--sparse-us") == 0) {
+            cfg.sparse_us = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--fifo-limit") == 0) {
+            cfg.fifo_limit = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--fifo-drop") == 0) {
+            if (strcmp(val, "new") == 0) {
+                cfg.fifo_policy = HOST_TXQ_DROP_NEW;
+            } else if (strcmp(val, "oldest") == 0) {
+                cfg.fifo_policy = HOST_TXQ_DROP_OLDEST;
+            } else {
+                aqm_usage();
+                return 2;
+            }
+        } else if (strcmp(arg, "--ring-limit") == 0) {
+            cfg.ring_limit = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--seed") == 0) {
+            cfg.seed = (unsigned)atoi(val);
+        } else {
+            aqm_usage();
+            return 2;
+        }
+        i++;
+    }
+    if (phy_config_parse(cfg.link, &cfg.phy) != 0) {
+        fprintf(stderr, "AQM: invalid link %s\n", cfg.link);
+        aqm_usage();
+        return 2;
+    }
+    if (cfg.duration_ms == 0 || cfg.duration_ms > 600000 || cfg.bulk_flows == 0 || cfg.bulk_mbps == 0 ||
+        cfg.sparse_us == 0 || cfg.fifo_limit == 0 || cfg.fifo_limit > AQM_MAX_FIFO) {
+        aqm_usage();
+        return 2;
+    }
+
+    sim_log_enabled = 0;
+    printf("AQM: link %s (%.1f Mb/s), %u bulk flows at %u Mb/s, %u-byte sparse frame every %u us, "
+           "%u ms, TX ring %lu bytes\n", cfg.link, phy_rate_kbps(&cfg.phy) / 1000.0, cfg.bulk_flows, cfg.bulk_mbps,
+           AQM_SPARSE_LEN, cfg.sparse_us, cfg.duration_ms, TX_BUFFER_SIZE);
+    printf("%-10s %10s %12s %12s %14s %14s %8s\n", "qdisc", "bulk_mbps", "bulk_p50_ms", "bulk_p99_ms",
+           "sparse_p50_ms", "sparse_p99_ms", "drops_%");
+
+    for (int q = 0; q < AQM_QDISCS; q++) {
+        struct aqm_run run;
+        memset(&run, 0, sizeof(run));
+        aqm_run_qdisc((enum aqm_qdisc)q, &cfg, &run);
+        for (int c = 0; c < 2; c++) {
+            qsort(run.delay[c].ns, run.delay[c].count, sizeof(uint64_t), report_cmp_u64);
+        }
+        printf("%-10s %10.1f %12.2f %12.2f %14.2f %14.2f %8.2f\n", aqm_qdisc_names[q],
+               run.bulk_bytes * 8.0 / (cfg.duration_ms * 1000.0), aqm_pct_ms(&run.delay[0], 50),
+               aqm_pct_ms(&run.delay[0], 99), aqm_pct_ms(&run.delay[1], 50), aqm_pct_ms(&run.delay[1], 99),
+               run.offered ? 100.0 * run.dropped / run.offered : 0.0);
+        free(run.delay[0].ns);
+        free(run.delay[1].ns);
+    }
+    return 0;
+}
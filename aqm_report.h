@@ -0,0 +1,15 @@
+#ifndef AQM_REPORT_H
+#define AQM_REPORT_H
+
+// --- TX Queue Management Report ---
+// Entry point for "wifi_ring_buffer_sim --aqm-report [options]". argv[0] is
+// "--aqm-report".
+//
+// Overloads an 802.11ax/be link (the CHIP paced by the airtime model) with several
+// bulk flows plus one sparse, latency-sensitive flow, and compares the HOST TX queue
+// in front of the ring: a tail-drop FIFO (the ring as a plain standing queue) against
+// FQ-CoDel. Prints bulk goodput, arrival-to-BlockAck delay per flow class and drops.
+// Returns 0 on success, 2 on usage errors.
+int aqm_report_main(int argc, char **argv);
+
+#endif // AQM_REPORT_H
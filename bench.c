@@ -0,0 +1,1468 @@
+#define _POSIX_C_SOURCE 200809L // For clock_gettime()
+
+#include "shared.h"
+#include "host.h"
+#include "chip_emulator.h"
+#include "bench.h"
+#include "cache_sim.h"
+#include "frame_verify.h"
+#include "sim_device.h"
+#include "report_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h> // For sysconf()
+
+// --- Benchmark Limits ---
+#define BENCH_MAX_RUNS              64
+#define BENCH_MAX_METRICS           256
+#define BENCH_MAX_PACKETS           200000
+#define BENCH_DEFAULT_RUNS          10
+#define BENCH_DEFAULT_PACKETS       100000
+#define BENCH_DEFAULT_TOLERANCE_PCT 5.0
+#define BENCH_BASELINE_FORMAT       "wifi_ring_buffer_sim-bench-1"
+#define BENCH_MT_MAX_DEVICES        64
+#define BENCH_MT_DEFAULT_DEVICES    8
+#define BENCH_MT_PAYLOAD_LEN        512
+#define BENCH_MT_BATCH              16  // TX frames per doorbell, RX frames per drain
+
+enum bench_better {
+    BENCH_HIGHER_IS_BETTER,
+    BENCH_LOWER_IS_BETTER,
+};
+
+struct bench_config {
+    unsigned runs;
+    unsigned packets;
+    double tolerance_pct;
+    const char *baseline_path;
+    const char *save_path;
+    const char *only_scenario;
+    int cache_sim;
+    int scaling;              // Run the multi-device scaling table instead of the scenarios
+    int verify;               // Stamp and check every TX/RX payload (frame_verify.h)
+    unsigned max_devices;
+    unsigned max_threads;     // 0: online CPUs
+    enum chip_rx_fill rx_fill; // Payload fill of emulator-generated RX frames
+};
+
+static const char *const bench_rx_fill_names[] = { "random", "none", "pattern", "template", "sequence", "verify" };
+
+// One metric of one scenario, with one sample per run
+struct bench_metric {
+    char scenario[32];
+    char name[32];
+    int better;
+    double samples[BENCH_MAX_RUNS];
+    unsigned n;
+    double mean;
+    double stddev;
+};
+
+// TX frames built as a BENCH_TX_HDR_LEN-byte header plus a payload in separate buffers
+// are either linearized by the caller into a temporary and sent from there, or gathered
+// by host_chip_send_packetv()
+#define BENCH_TX_HDR_LEN            54
+
+enum bench_tx_build {
+    BENCH_TX_CONTIG,         // One buffer
+    BENCH_TX_LINEARIZE,      // Header + payload copied into a temporary first
+    BENCH_TX_GATHER,         // Header + payload as two fragments
+    BENCH_TX_TCP_SEGMENT,    // TCP burst cut into MSS frames by the HOST stack
+    BENCH_TX_TCP_TSO,        // TCP burst handed over whole, segmented by the CHIP
+};
+
+enum bench_rx_mode {
+    BENCH_RX_RING,           // Frames delivered from the RX ring
+    BENCH_RX_GRO,            // Coalesced with host_chip_enable_gro()
+    BENCH_RX_SOCKET,         // From the RX ring; the stack copies payloads to its socket queue
+    BENCH_RX_SPLIT,          // Header split; the stack queues payload buffers uncopied
+};
+
+struct bench_scenario {
+    const char *name;
+    uint32_t payload_len; // 0 where the scenario picks its own lengths
+    uint32_t batch;       // TX: frames queued per doorbell (0/1: host_chip_send_packet)
+                          // RX, loopback: frames per delivery callback (0: no callback)
+    void (*run)(const struct bench_scenario *sc, const struct bench_config *cfg);
+    enum bench_tx_build tx_build; // TX: how the caller hands over each frame
+    enum bench_rx_mode rx_mode;   // RX: how frames reach the stack
+};
+
+static struct bench_metric bench_metrics[BENCH_MAX_METRICS];
+static unsigned bench_metric_count;
+static int bench_recording; // 0 during the warm-up pass
+
+// Per-packet cost samples of the current run (in bench_cycles() ticks)
+static uint64_t bench_lat[BENCH_MAX_PACKETS];
+
+// The device the single-threaded scenarios run on
+static struct sim_device bench_dev;
+static struct host_chip bench_host;
+static struct chip_emulator bench_chip;
+
+// --- Timing ---
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Cheapest monotonic tick source available; CPU cycles on x86, the generic timer on aarch64.
+static inline uint64_t bench_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm volatile ("mrs %0, cntvct_el0" : "=r" (v));
+    return v;
+#else
+    return bench_now_ns();
+#endif
+}
+
+// --- Metric Recording ---
+static void bench_record(const char *scenario, const char *name, int better, double value) {
+    if (!bench_recording) {
+        return;
+    }
+
+    struct bench_metric *m = NULL;
+    for (unsigned i = 0; i < bench_metric_count; i++) {
+        if (strcmp(bench_metrics[i].scenario, scenario) == 0 && strcmp(bench_metrics[i].name, name) == 0) {
+            m = &bench_metrics[i];
+            break;
+        }
+    }
+    if (m == NULL) {
+        if (bench_metric_count == BENCH_MAX_METRICS) {
+            // Dropping it would hide the metric from the report and the regression gate
+            fprintf(stderr, "BENCH: more than %d metrics (%s %s); raise BENCH_MAX_METRICS\n",
+                    BENCH_MAX_METRICS, scenario, name);
+            exit(2);
+        }
+        m = &bench_metrics[bench_metric_count++];
+        snprintf(m->scenario, sizeof(m->scenario), "%s", scenario);
+        snprintf(m->name, sizeof(m->name), "%s", name);
+        m->better = better;
+    }
+    if (m->n < BENCH_MAX_RUNS) {
+        m->samples[m->n++] = value;
+    }
+}
+
+static int bench_cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Driver-side cost, accumulated around HOST driver calls only (emulator work excluded)
+struct bench_cost {
+    uint64_t cycles;
+    uint64_t barriers;      // All barriers issued (audit counters from shared.h)
+    uint64_t sync_barriers; // DSB + ISB, the expensive pipeline-draining kinds
+};
+
+struct bench_mark {
+    uint64_t cycles;
+    uint64_t barriers;
+    uint64_t sync_barriers;
+};
+
+static inline void bench_mark(struct bench_mark *m) {
+    m->barriers = 0;
+    for (int k = 0; k < SIM_BARRIER_KINDS; k++) {
+        m->barriers += sim_barrier_counts[k];
+    }
+    m->sync_barriers = sim_barrier_counts[SIM_BARRIER_DSB] + sim_barrier_counts[SIM_BARRIER_ISB];
+    m->cycles = bench_cycles();
+}
+
+// Adds the cost between two marks; returns the cycles spent
+static inline uint64_t bench_charge(struct bench_cost *cost, const struct bench_mark *a, const struct bench_mark *b) {
+    cost->cycles += b->cycles - a->cycles;
+    cost->barriers += b->barriers - a->barriers;
+    cost->sync_barriers += b->sync_barriers - a->sync_barriers;
+    return b->cycles - a->cycles;
+}
+
+// Records throughput, per-packet cost and latency percentiles for one run
+static void bench_record_run(const char *scenario, uint64_t packets, uint64_t bytes,
+                             uint64_t elapsed_ns, const struct bench_cost *cost, unsigned lat_count) {
+    if (packets == 0 || elapsed_ns == 0) {
+        return;
+    }
+    bench_record(scenario, "throughput_mbps", BENCH_HIGHER_IS_BETTER, (double)bytes * 8.0 * 1000.0 / (double)elapsed_ns);
+    bench_record(scenario, "cycles_per_pkt", BENCH_LOWER_IS_BETTER, (double)cost->cycles / (double)packets);
+    bench_record(scenario, "barriers_per_pkt", BENCH_LOWER_IS_BETTER, (double)cost->barriers / (double)packets);
+    bench_record(scenario, "dsb_isb_per_pkt", BENCH_LOWER_IS_BETTER, (double)cost->sync_barriers / (double)packets);
+
+    if (bench_dev.cache.enabled) {
+        const struct cache_sim_side_stats *host = &bench_dev.cache.stats.side[CACHE_SIM_HOST];
+        bench_record(scenario, "cache_bytes_per_pkt", BENCH_LOWER_IS_BETTER,
+                     (double)(host->bytes_cleaned + host->bytes_invalidated) / (double)packets);
+        bench_record(scenario, "cache_redund_per_pkt", BENCH_LOWER_IS_BETTER,
+                     (double)(host->redundant_clean_lines + host->redundant_inval_lines) / (double)packets);
+        bench_record(scenario, "cache_cycles_per_pkt", BENCH_LOWER_IS_BETTER, (double)host->modelled_cycles / (double)packets);
+        bench_record(scenario, "cache_missed", BENCH_LOWER_IS_BETTER, (double)cache_sim_missed_total(&bench_dev.cache));
+    }
+
+    if (lat_count > 0) {
+        qsort(bench_lat, lat_count, sizeof(bench_lat[0]), report_cmp_u64);
+        bench_record(scenario, "lat_p50_cycles", BENCH_LOWER_IS_BETTER, (double)bench_lat[(lat_count * 50) / 100]);
+        bench_record(scenario, "lat_p99_cycles", BENCH_LOWER_IS_BETTER, (double)bench_lat[(lat_count * 99) / 100]);
+    }
+}
+
+// --- Scenarios ---
+// CHIP consumes everything the HOST has published
+static void bench_drain_tx(struct chip_emulator *chip) {
+    while (BUS_READ_REG(chip->regs, CHIP_REG_TX_TAIL_PTR) != BUS_READ_REG(chip->regs, CHIP_REG_HOST_TX_HEAD_PUB)) {
+        chip_emulator_process_tx(chip);
+    }
+}
+
+// CHIP generates RX frames until the ring is full, which costs the one frame that
+// found it so. With lossless set it stops while any frame would still fit instead,
+// so that verification sees no loss the run did not cause itself.
+static void bench_fill_rx(struct chip_emulator *chip, int lossless) {
+    for (;;) {
+        if (lossless && rx_ring_free(BUS_READ_REG(chip->regs, CHIP_REG_RX_HEAD_PTR),
+                                     BUS_READ_REG(chip->regs, CHIP_REG_HOST_RX_TAIL_PUB)) <
+                        CHIP_RX_GEN_MAX_LEN + PACKET_LENGTH_FIELD_SIZE) {
+            break;
+        }
+        uint32_t head_before = BUS_READ_REG(chip->regs, CHIP_REG_RX_HEAD_PTR);
+        chip_emulator_generate_rx(chip);
+        if (BUS_READ_REG(chip->regs, CHIP_REG_RX_HEAD_PTR) == head_before) {
+            break; // Ring full
+        }
+    }
+}
+
+// Same emulator traffic in every run: the emulator reseeds its generator on init.
+// chip_cfg NULL selects the default emulator config.
+static void bench_reset(const struct chip_emulator_config *chip_cfg) {
+    struct host_chip_bus bus;
+    sim_device_init(&bench_dev);
+    sim_device_host_bus(&bench_dev, &bus);
+    host_chip_driver_init(&bench_host, &bus);
+    chip_emulator_init(&bench_chip, &bench_dev, chip_cfg);
+}
+
+// --- Payload Verification ---
+// With --verify (and always in the loopback scenarios) payloads are stamped by
+// frame_verify_fill() and checked where they come out: by the CHIP as it consumes TX
+// frames (uncharged, like all emulator work) and by the RX delivery callback (charged
+// with the drain, as an upper stack's own check would be). The pattern seed is the
+// emulator's traffic seed.
+struct bench_verify {
+    struct frame_verify v;
+    const uint8_t *tx_ring;
+    int deliver;               // Pass RX batches on to bench_rx_deliver()
+    uint8_t frame[TX_BUFFER_SIZE]; // Contiguous copy of a TX frame that wraps the ring
+};
+
+static struct bench_verify bench_verify;
+
+static void bench_verify_reset(const char *name, int deliver) {
+    frame_verify_init(&bench_verify.v, name, bench_chip.cfg.seed);
+    bench_verify.tx_ring = bench_chip.tx_ring;
+    bench_verify.deliver = deliver;
+}
+
+// TX sink: reports frames by the ring offset of their length header, as RX does
+static void bench_verify_tx(void *ctx, const uint8_t *first, uint32_t first_len,
+                            const uint8_t *second, uint32_t second_len) {
+    struct bench_verify *bv = ctx;
+    uint32_t off = tx_ring_wrap((uint32_t)(first - bv->tx_ring) + TX_BUFFER_SIZE - PACKET_LENGTH_FIELD_SIZE);
+    if (second_len > 0) {
+        memcpy(bv->frame, first, first_len);
+        memcpy(bv->frame + first_len, second, second_len);
+        first = bv->frame;
+    }
+    frame_verify_check(&bv->v, first, first_len + second_len, off);
+}
+
+static void bench_rx_deliver(void *ctx, const struct host_rx_desc *descs, unsigned count);
+
+static void bench_verify_rx(void *ctx, const struct host_rx_desc *descs, unsigned count) {
+    struct bench_verify *bv = ctx;
+    for (unsigned i = 0; i < count; i++) {
+        frame_verify_check(&bv->v, descs[i].data, descs[i].len, descs[i].ring_off);
+    }
+    if (bv->deliver) {
+        bench_rx_deliver(NULL, descs, count);
+    }
+}
+
+// HOST pushes fixed-size frames; whenever the ring is full the CHIP drains all of it.
+// Only the cost of successful driver calls is attributed to the driver. Batched
+// scenarios queue sc->batch frames per doorbell; the kick is charged to the batch.
+static void bench_run_tx(const struct bench_scenario *sc, const struct bench_config *cfg) {
+    uint8_t payload[TX_BUFFER_SIZE];
+    for (uint32_t i = 0; i < sc->payload_len; i++) {
+        payload[i] = (uint8_t)i;
+    }
+    // Split frames: the header in a buffer of its own, the payload in place after it
+    uint8_t hdr[BENCH_TX_HDR_LEN];
+    uint8_t linear[TX_BUFFER_SIZE];
+    const uint8_t *body = payload + BENCH_TX_HDR_LEN;
+    memcpy(hdr, payload, BENCH_TX_HDR_LEN);
+    struct host_tx_frag frags[2] = {
+        { hdr, BENCH_TX_HDR_LEN },
+        { body, sc->payload_len - BENCH_TX_HDR_LEN },
+    };
+
+    bench_reset(NULL);
+    if (cfg->verify) {
+        bench_verify_reset(sc->name, 0);
+        chip_emulator_set_tx_sink(&bench_chip, bench_verify_tx, &bench_verify);
+    }
+
+    struct bench_cost cost = { 0 };
+    unsigned sent = 0;
+    uint64_t start_ns = bench_now_ns();
+    unsigned queued = 0;
+    uint32_t stamped = UINT32_MAX;
+    while (sent < cfg->packets) {
+        if (cfg->verify && stamped != sent) {
+            frame_verify_fill(payload, sc->payload_len, sent, bench_chip.cfg.seed);
+            memcpy(hdr, payload, BENCH_TX_HDR_LEN);
+            stamped = sent;
+        }
+        struct bench_mark m0, m1;
+        bench_mark(&m0);
+        int rc;
+        if (sc->tx_build == BENCH_TX_LINEARIZE) {
+            memcpy(linear, hdr, BENCH_TX_HDR_LEN);
+            memcpy(linear + BENCH_TX_HDR_LEN, body, sc->payload_len - BENCH_TX_HDR_LEN);
+            rc = host_chip_send_packet(&bench_host, linear, sc->payload_len);
+        } else if (sc->tx_build == BENCH_TX_GATHER) {
+            rc = host_chip_send_packetv(&bench_host, frags, 2);
+        } else {
+            rc = (sc->batch > 1) ? host_chip_queue_packet(&bench_host, payload, sc->payload_len)
+                                 : host_chip_send_packet(&bench_host, payload, sc->payload_len);
+        }
+        if (rc == 0 && sc->batch > 1 && (++queued == sc->batch || sent + 1 == cfg->packets)) {
+            host_chip_tx_kick(&bench_host);
+            queued = 0;
+        }
+        bench_mark(&m1);
+
+        if (rc == 0) {
+            bench_lat[sent++] = bench_charge(&cost, &m0, &m1);
+        } else if (rc == -2) {
+            // Ring full: publish what is queued so the CHIP can make room
+            if (queued > 0) {
+                bench_mark(&m0);
+                host_chip_tx_kick(&bench_host);
+                bench_mark(&m1);
+                bench_charge(&cost, &m0, &m1);
+                queued = 0;
+            }
+            bench_drain_tx(&bench_chip);
+        } else {
+            fprintf(stderr, "BENCH: %s: send failed (%d)\n", sc->name, rc);
+            return;
+        }
+    }
+    // Let the CHIP finish so every run covers the complete path
+    bench_drain_tx(&bench_chip);
+    uint64_t elapsed_ns = bench_now_ns() - start_ns;
+
+    bench_record_run(sc->name, bench_host.stats.tx_packets, bench_host.stats.tx_bytes,
+                     elapsed_ns, &cost, sent);
+    if (cfg->verify) {
+        bench_record(sc->name, "verify_errors", BENCH_LOWER_IS_BETTER, (double)frame_verify_errors(&bench_verify.v));
+    }
+}
+
+// --- TCP Segmentation ---
+// A bulk TCP sender writes the same stream buffer over and over in bursts of up to
+// 64KB (as much as one super-frame the TX ring can hold). Without offload the stack
+// builds a header per MSS segment and sends header and payload as two fragments; with
+// it the burst goes out as one super-frame behind a single header and the CHIP cuts
+// it up. Either way the wire carries identical frames, which the TX sink checks.
+#define BENCH_TCP_HDR_LEN           54     // Ethernet + IPv4 + TCP, no options
+#define BENCH_TCP_MSS               1460
+#define BENCH_TCP_MAX_SEGS          44     // 64KB send
+#define BENCH_TCP_IP_LEN_OFF        16     // IPv4 total length
+#define BENCH_TCP_SEQ_OFF           38     // TCP sequence number
+#define BENCH_TCP_L2_LEN            14
+
+struct bench_tcp {
+    uint8_t tmpl[BENCH_TCP_HDR_LEN];
+    uint8_t stream[BENCH_TCP_MAX_SEGS * BENCH_TCP_MSS];
+    uint32_t burst;            // Stream bytes per burst
+    uint32_t next_seq;         // Sequence number the sink expects next
+    uint64_t frames;           // Frames the sink saw
+    struct frame_verify *v;    // Counts the errors and limits the reports
+    uint8_t frame[TX_BUFFER_SIZE];
+};
+
+static struct bench_tcp bench_tcp;
+
+static void bench_put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void bench_put_be16(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static uint32_t bench_get_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void bench_tcp_reset(void) {
+    static const uint8_t tmpl[BENCH_TCP_HDR_LEN] = {
+        0x02, 0, 0, 0, 0, 0x02, 0x02, 0, 0, 0, 0, 0x01, 0x08, 0x00,        // Ethernet, IPv4
+        0x45, 0, 0, 0, 0, 0, 0x40, 0, 64, 6, 0, 0, 10, 0, 0, 1, 10, 0, 0, 2, // IPv4, TCP
+        0x9c, 0x40, 0x13, 0x89, 0, 0, 0, 0, 0, 0, 0, 0, 0x50, 0x10, 0xff, 0xff, 0, 0, 0, 0,
+    };
+    memcpy(bench_tcp.tmpl, tmpl, sizeof(tmpl));
+    for (uint32_t i = 0; i < sizeof(bench_tcp.stream); i++) {
+        bench_tcp.stream[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+    uint32_t segs = (uint32_t)(TX_BUFFER_SIZE - 1 - TX_TSO_RECORD_OVERHEAD - BENCH_TCP_HDR_LEN) / BENCH_TCP_MSS;
+    bench_tcp.burst = ((segs < BENCH_TCP_MAX_SEGS) ? segs : BENCH_TCP_MAX_SEGS) * BENCH_TCP_MSS;
+    bench_tcp.next_seq = 0;
+    bench_tcp.frames = 0;
+    bench_tcp.v = &bench_verify.v;
+}
+
+// Counts one wire frame as corrupt and reports it while reports are left
+static void bench_tcp_bad(struct bench_tcp *t, uint32_t len, const char *what) {
+    t->v->corrupt++;
+    if (t->v->reports < FRAME_VERIFY_MAX_REPORTS) {
+        t->v->reports++;
+        fprintf(stderr, "VERIFY %s: frame %llu (len %u): %s\n", t->v->name, (unsigned long long)t->frames, len, what);
+    }
+}
+
+// Checks that frame carries the next stream bytes (at most max_payload of them) behind
+// a header with matching sequence number and IPv4 length
+static void bench_tcp_check_frame(struct bench_tcp *t, const uint8_t *frame, uint32_t len, uint32_t max_payload) {
+    t->frames++;
+    t->v->frames++;
+    if (len <= BENCH_TCP_HDR_LEN || len > BENCH_TCP_HDR_LEN + max_payload) {
+        bench_tcp_bad(t, len, "bad length");
+        return;
+    }
+    uint32_t n = len - BENCH_TCP_HDR_LEN;
+    uint32_t seq = bench_get_be32(frame + BENCH_TCP_SEQ_OFF);
+    uint32_t ip_len = ((uint32_t)frame[BENCH_TCP_IP_LEN_OFF] << 8) | frame[BENCH_TCP_IP_LEN_OFF + 1];
+    if (seq != t->next_seq) {
+        bench_tcp_bad(t, len, "out of sequence");
+    } else if (ip_len != len - BENCH_TCP_L2_LEN) {
+        bench_tcp_bad(t, len, "bad IPv4 length");
+    } else {
+        // The stream repeats every burst bytes
+        for (uint32_t done = 0; done < n;) {
+            uint32_t off = (seq + done) % t->burst;
+            uint32_t chunk = (n - done < t->burst - off) ? n - done : t->burst - off;
+            if (memcmp(frame + BENCH_TCP_HDR_LEN + done, t->stream + off, chunk) != 0) {
+                bench_tcp_bad(t, len, "payload mismatch");
+                break;
+            }
+            done += chunk;
+        }
+    }
+    t->next_seq = seq + n;
+}
+
+// TX sink: every wire frame must carry the next MSS of the stream
+static void bench_tcp_check(void *ctx, const uint8_t *first, uint32_t first_len,
+                            const uint8_t *second, uint32_t second_len) {
+    struct bench_tcp *t = ctx;
+    if (second_len > 0) {
+        memcpy(t->frame, first, first_len);
+        memcpy(t->frame + first_len, second, second_len);
+        first = t->frame;
+    }
+    bench_tcp_check_frame(t, first, first_len + second_len, BENCH_TCP_MSS);
+}
+
+// The per-packet metrics count wire frames (segments) in both modes; cycles_per_byte
+// is host cost per stream byte. Latency samples are per send call.
+static void bench_run_tcp(const struct bench_scenario *sc, const struct bench_config *cfg) {
+    bench_reset(NULL);
+    bench_verify_reset(sc->name, 0);
+    bench_tcp_reset();
+    if (cfg->verify) {
+        chip_emulator_set_tx_sink(&bench_chip, bench_tcp_check, &bench_tcp);
+    }
+    const struct tx_tso_params tso = {
+        BENCH_TCP_MSS, BENCH_TCP_HDR_LEN, BENCH_TCP_SEQ_OFF, BENCH_TCP_IP_LEN_OFF, BENCH_TCP_L2_LEN,
+    };
+
+    struct bench_cost cost = { 0 };
+    uint64_t segments = 0;
+    uint64_t bytes = 0;
+    unsigned calls = 0;
+    uint32_t seq = 0;
+    uint32_t burst_off = 0;    // Stream bytes of the current burst already sent
+    uint8_t hdr[BENCH_TCP_HDR_LEN];
+    uint64_t start_ns = bench_now_ns();
+    while (segments < cfg->packets) {
+        struct bench_mark m0, m1;
+        int rc;
+        uint32_t n;
+        bench_mark(&m0);
+        memcpy(hdr, bench_tcp.tmpl, BENCH_TCP_HDR_LEN);
+        bench_put_be32(hdr + BENCH_TCP_SEQ_OFF, seq);
+        if (sc->tx_build == BENCH_TX_TCP_TSO) {
+            n = bench_tcp.burst;
+            struct host_tx_frag frags[2] = { { hdr, BENCH_TCP_HDR_LEN }, { bench_tcp.stream, n } };
+            rc = host_chip_send_packet_tso(&bench_host, frags, 2, &tso);
+        } else {
+            n = bench_tcp.burst - burst_off;
+            if (n > BENCH_TCP_MSS) {
+                n = BENCH_TCP_MSS;
+            }
+            bench_put_be16(hdr + BENCH_TCP_IP_LEN_OFF, BENCH_TCP_HDR_LEN + n - BENCH_TCP_L2_LEN);
+            struct host_tx_frag frags[2] = { { hdr, BENCH_TCP_HDR_LEN }, { bench_tcp.stream + burst_off, n } };
+            rc = host_chip_send_packetv(&bench_host, frags, 2);
+        }
+        bench_mark(&m1);
+
+        if (rc == 0) {
+            uint64_t c = bench_charge(&cost, &m0, &m1);
+            if (calls < BENCH_MAX_PACKETS) {
+                bench_lat[calls++] = c;
+            }
+            segments += (n + BENCH_TCP_MSS - 1) / BENCH_TCP_MSS;
+            bytes += n;
+            seq += n;
+            burst_off = (burst_off + n) % bench_tcp.burst;
+        } else if (rc == -2) {
+            bench_drain_tx(&bench_chip);
+        } else {
+            fprintf(stderr, "BENCH: %s: send failed (%d)\n", sc->name, rc);
+            return;
+        }
+    }
+    bench_drain_tx(&bench_chip);
+    uint64_t elapsed_ns = bench_now_ns() - start_ns;
+
+    bench_record_run(sc->name, segments, bytes, elapsed_ns, &cost, calls);
+    bench_record(sc->name, "cycles_per_byte", BENCH_LOWER_IS_BETTER, (double)cost.cycles / (double)bytes);
+    if (cfg->verify) {
+        if (bench_tcp.frames != segments) {
+            bench_tcp_bad(&bench_tcp, 0, "wrong number of frames on the wire");
+        }
+        bench_record(sc->name, "verify_errors", BENCH_LOWER_IS_BETTER, (double)frame_verify_errors(&bench_verify.v));
+    }
+}
+
+// Upper-stack stand-in for the rx_cb scenarios: a fixed per-call cost (entering the
+// stack, taking its queue lock) plus a look at each frame's first byte
+#define BENCH_RX_CALL_WORK          200
+
+static volatile uint32_t bench_rx_sink;
+
+static void bench_rx_deliver(void *ctx, const struct host_rx_desc *descs, unsigned count) {
+    (void)ctx;
+    for (unsigned i = 0; i < BENCH_RX_CALL_WORK; i++) {
+        bench_rx_sink++;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        bench_rx_sink += descs[i].data[0] + descs[i].len;
+    }
+}
+
+// CHIP fills the RX ring with its usual random-length frames, then the HOST drains it.
+// Filling is outside the charged driver cost but inside throughput_mbps, which is why
+// the payload fill defaults to a template copy rather than per-byte random data.
+// With sc->batch > 0 frames are delivered to bench_rx_deliver() in batches of that size.
+// The per-packet latency sample is the drain cost divided by the frames it delivered.
+static void bench_run_rx(const struct bench_scenario *sc, const struct bench_config *cfg) {
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_fill = cfg->verify ? CHIP_RX_FILL_VERIFY : cfg->rx_fill;
+    bench_reset(&chip_cfg);
+    if (cfg->verify) {
+        bench_verify_reset(sc->name, sc->batch > 0);
+        host_chip_set_rx_handler(&bench_host, bench_verify_rx, &bench_verify,
+                                 (sc->batch > 0) ? sc->batch : HOST_RX_BATCH_MAX);
+    } else if (sc->batch > 0) {
+        host_chip_set_rx_handler(&bench_host, bench_rx_deliver, NULL, sc->batch);
+    }
+
+    struct bench_cost cost = { 0 };
+    unsigned lat_count = 0;
+    uint64_t start_ns = bench_now_ns();
+    while (bench_host.stats.rx_packets < cfg->packets) {
+        bench_fill_rx(&bench_chip, cfg->verify);
+
+        uint64_t packets_before = bench_host.stats.rx_packets;
+        struct bench_mark m0, m1;
+        bench_mark(&m0);
+        host_chip_process_received_data(&bench_host);
+        bench_mark(&m1);
+        uint64_t delivered = bench_host.stats.rx_packets - packets_before;
+
+        if (delivered == 0) {
+            fprintf(stderr, "BENCH: %s: RX ring stalled\n", sc->name);
+            return;
+        }
+        uint64_t drain_cycles = bench_charge(&cost, &m0, &m1);
+        for (uint64_t i = 0; i < delivered && lat_count < BENCH_MAX_PACKETS; i++) {
+            bench_lat[lat_count++] = drain_cycles / delivered;
+        }
+    }
+    uint64_t elapsed_ns = bench_now_ns() - start_ns;
+
+    bench_record_run(sc->name, bench_host.stats.rx_packets, bench_host.stats.rx_bytes,
+                     elapsed_ns, &cost, lat_count);
+    if (cfg->verify) {
+        bench_record(sc->name, "verify_errors", BENCH_LOWER_IS_BETTER, (double)frame_verify_errors(&bench_verify.v));
+    }
+}
+
+// RX side of the TCP stream: the CHIP receives BENCH_TCP_MSS segments of one flow
+// (injected, uncharged) until the ring is full, then the HOST drains it into a stack
+// that pays BENCH_RX_CALL_WORK per callback and BENCH_RX_PKT_WORK per descriptor
+// (protocol processing), with or without GRO merging the segments first. The
+// per-packet metrics count wire frames; descs_per_pkt shows what the stack saw.
+// In the socket modes the stack also keeps each payload for the application past the
+// callback: copied to its socket queue from the RX ring, or, with header split, by
+// taking the pool buffer, which the application releases after the drain.
+#define BENCH_RX_PKT_WORK           150
+#define BENCH_RX_SOCK_SEGS          64     // Socket queue: at least a drain of a 64KB RX ring
+
+static uint8_t bench_gro_storage[HOST_GRO_FLOWS * 65535U];
+
+struct bench_tcp_rx {
+    int verify;
+    enum bench_rx_mode mode;
+    uint64_t descs;
+    unsigned queued;                                  // Payloads in the socket queue
+    uint8_t sock[BENCH_RX_SOCK_SEGS][BENCH_TCP_MSS];  // BENCH_RX_SOCKET payload copies
+    uint32_t bufs[RX_SPLIT_BUFS];                     // BENCH_RX_SPLIT pool buffers taken
+};
+
+static struct bench_tcp_rx bench_tcp_rx;
+
+static void bench_tcp_deliver(void *ctx, const struct host_rx_desc *descs, unsigned count) {
+    struct bench_tcp_rx *r = ctx;
+    for (unsigned i = 0; i < BENCH_RX_CALL_WORK; i++) {
+        bench_rx_sink++;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        const struct host_rx_desc *d = &descs[i];
+        for (unsigned k = 0; k < BENCH_RX_PKT_WORK; k++) {
+            bench_rx_sink++;
+        }
+        bench_rx_sink += d->data[BENCH_TCP_SEQ_OFF] + d->len;
+        if (r->verify && d->payload != NULL) {
+            uint8_t frame[BENCH_TCP_HDR_LEN + BENCH_TCP_MSS];
+            if (d->len + d->payload_len > sizeof(frame)) {
+                bench_tcp_bad(&bench_tcp, 0, "split frame too long");
+            } else {
+                memcpy(frame, d->data, d->len);
+                memcpy(frame + d->len, d->payload, d->payload_len);
+                bench_tcp_check_frame(&bench_tcp, frame, d->len + d->payload_len, UINT16_MAX);
+            }
+        } else if (r->verify) {
+            bench_tcp_check_frame(&bench_tcp, d->data, d->len, UINT16_MAX);
+        }
+
+        if (r->mode == BENCH_RX_SOCKET && d->len > BENCH_TCP_HDR_LEN && r->queued < BENCH_RX_SOCK_SEGS) {
+            uint32_t n = d->len - BENCH_TCP_HDR_LEN;
+            memcpy(r->sock[r->queued++], d->data + BENCH_TCP_HDR_LEN, (n < BENCH_TCP_MSS) ? n : BENCH_TCP_MSS);
+        } else if (r->mode == BENCH_RX_SPLIT && d->payload != NULL &&
+                   host_chip_rx_split_take(&bench_host, d->buf) == 0) {
+            r->bufs[r->queued++] = d->buf;
+        }
+    }
+    r->descs += count;
+}
+
+// The application consumes the socket queue
+static void bench_tcp_consume(struct bench_tcp_rx *r) {
+    if (r->mode == BENCH_RX_SPLIT) {
+        host_chip_rx_split_release(&bench_host, r->bufs, r->queued);
+    }
+    r->queued = 0;
+}
+
+static void bench_run_rx_tcp(const struct bench_scenario *sc, const struct bench_config *cfg) {
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_gen_percent = 0;
+    bench_reset(&chip_cfg);
+    bench_verify_reset(sc->name, 0);
+    bench_tcp_reset();
+    bench_tcp.burst = sizeof(bench_tcp.stream);
+    struct bench_tcp_rx *rx = &bench_tcp_rx;
+    rx->verify = cfg->verify;
+    rx->mode = sc->rx_mode;
+    rx->descs = 0;
+    rx->queued = 0;
+    host_chip_set_rx_handler(&bench_host, bench_tcp_deliver, rx, sc->batch);
+    if (sc->rx_mode == BENCH_RX_GRO &&
+        host_chip_enable_gro(&bench_host, NULL, bench_gro_storage, sizeof(bench_gro_storage)) != 0) {
+        fprintf(stderr, "BENCH: %s: cannot enable GRO\n", sc->name);
+        return;
+    }
+    if (sc->rx_mode == BENCH_RX_SPLIT && host_chip_enable_rx_split(&bench_host, BENCH_TCP_HDR_LEN) != 0) {
+        fprintf(stderr, "BENCH: %s: cannot enable header split\n", sc->name);
+        return;
+    }
+
+    uint8_t frame[BENCH_TCP_HDR_LEN + BENCH_TCP_MSS];
+    memcpy(frame, bench_tcp.tmpl, BENCH_TCP_HDR_LEN);
+    bench_put_be16(frame + BENCH_TCP_IP_LEN_OFF, sizeof(frame) - BENCH_TCP_L2_LEN);
+    uint32_t seq = 0;
+
+    struct bench_cost cost = { 0 };
+    unsigned lat_count = 0;
+    uint64_t start_ns = bench_now_ns();
+    while (bench_host.stats.rx_packets < cfg->packets) {
+        for (;;) {
+            bench_put_be32(frame + BENCH_TCP_SEQ_OFF, seq);
+            memcpy(frame + BENCH_TCP_HDR_LEN, bench_tcp.stream + seq % bench_tcp.burst, BENCH_TCP_MSS);
+            if (chip_emulator_inject_rx(&bench_chip, frame, sizeof(frame)) != 0) {
+                break;
+            }
+            seq += BENCH_TCP_MSS;
+        }
+
+        uint64_t packets_before = bench_host.stats.rx_packets;
+        struct bench_mark m0, m1;
+        bench_mark(&m0);
+        host_chip_process_received_data(&bench_host);
+        bench_tcp_consume(rx);
+        bench_mark(&m1);
+        uint64_t delivered = bench_host.stats.rx_packets - packets_before;
+
+        if (delivered == 0) {
+            fprintf(stderr, "BENCH: %s: RX ring stalled\n", sc->name);
+            return;
+        }
+        uint64_t drain_cycles = bench_charge(&cost, &m0, &m1);
+        for (uint64_t i = 0; i < delivered && lat_count < BENCH_MAX_PACKETS; i++) {
+            bench_lat[lat_count++] = drain_cycles / delivered;
+        }
+    }
+    uint64_t elapsed_ns = bench_now_ns() - start_ns;
+
+    bench_record_run(sc->name, bench_host.stats.rx_packets, bench_host.stats.rx_bytes,
+                     elapsed_ns, &cost, lat_count);
+    bench_record(sc->name, "descs_per_pkt", BENCH_LOWER_IS_BETTER,
+                 (double)rx->descs / (double)bench_host.stats.rx_packets);
+    if (cfg->verify) {
+        bench_record(sc->name, "verify_errors", BENCH_LOWER_IS_BETTER, (double)frame_verify_errors(&bench_verify.v));
+    }
+}
+
+// --- Loopback Scenarios ---
+// The CHIP loops every TX frame back to RX after BENCH_LB_DELAY_NS of device time.
+// Frames are stamped with frame_verify_fill(), so whatever comes back is checked byte
+// by byte; any mismatch, loss or reordering is a verify error.
+#define BENCH_LB_DELAY_NS           2000
+#define BENCH_LB_STALL_CYCLES       100000
+
+static void bench_reset_loopback(const char *name, unsigned rx_batch) {
+    struct chip_emulator_config lb = CHIP_EMULATOR_DEFAULT_CONFIG;
+    lb.loopback = 1;
+    lb.loopback_delay_ns = BENCH_LB_DELAY_NS;
+    bench_reset(&lb);
+    bench_verify_reset(name, 0);
+    host_chip_set_rx_handler(&bench_host, bench_verify_rx, &bench_verify, rx_batch);
+}
+
+// One frame in flight: send, run the CHIP and poll RX until it is back. Reports the
+// round trip in HOST cycles (driver + emulator work) and in device time.
+static void bench_run_lb_pingpong(const struct bench_scenario *sc, const struct bench_config *cfg) {
+    uint8_t payload[TX_BUFFER_SIZE];
+    bench_reset_loopback(sc->name, sc->batch);
+
+    unsigned rounds = cfg->packets / 10; // Each round trip spans ~20 emulator cycles
+    uint64_t virt_ns = 0;
+    for (unsigned r = 0; r < rounds; r++) {
+        frame_verify_fill(payload, sc->payload_len, r, bench_chip.cfg.seed);
+        uint64_t c0 = bench_cycles();
+        uint64_t t0 = bench_dev.time_ns;
+        if (host_chip_send_packet(&bench_host, payload, sc->payload_len) != 0) {
+            fprintf(stderr, "BENCH: %s: send failed\n", sc->name);
+            return;
+        }
+        while (bench_verify.v.frames == r) {
+            chip_emulator_run_cycle(&bench_chip);
+            host_chip_process_received_data(&bench_host);
+            if (bench_dev.time_ns - t0 > (uint64_t)BENCH_LB_STALL_CYCLES * CHIP_CYCLE_NS) {
+                fprintf(stderr, "BENCH: %s: frame %u did not come back\n", sc->name, r);
+                return;
+            }
+        }
+        bench_lat[r] = bench_cycles() - c0;
+        virt_ns += bench_dev.time_ns - t0;
+    }
+    if (rounds == 0) {
+        return;
+    }
+
+    qsort(bench_lat, rounds, sizeof(bench_lat[0]), report_cmp_u64);
+    bench_record(sc->name, "rtt_p50_cycles", BENCH_LOWER_IS_BETTER, (double)bench_lat[(rounds * 50) / 100]);
+    bench_record(sc->name, "rtt_p99_cycles", BENCH_LOWER_IS_BETTER, (double)bench_lat[(rounds * 99) / 100]);
+    bench_record(sc->name, "rtt_device_ns", BENCH_LOWER_IS_BETTER, (double)virt_ns / rounds);
+    bench_record(sc->name, "verify_errors", BENCH_LOWER_IS_BETTER, (double)frame_verify_errors(&bench_verify.v));
+}
+
+// Keeps the TX ring full while draining RX in batches: full-duplex throughput over
+// the whole HOST -> CHIP -> HOST path, every returned payload verified.
+static void bench_run_lb_duplex(const struct bench_scenario *sc, const struct bench_config *cfg) {
+    uint8_t payload[TX_BUFFER_SIZE];
+    bench_reset_loopback(sc->name, sc->batch);
+
+    uint32_t seq = 0;
+    unsigned idle_rounds = 0;
+    uint64_t start_ns = bench_now_ns();
+    uint64_t c0 = bench_cycles();
+    while (bench_verify.v.frames < cfg->packets) {
+        uint64_t frames_before = bench_verify.v.frames;
+        while (seq < cfg->packets) {
+            frame_verify_fill(payload, sc->payload_len, seq, bench_chip.cfg.seed);
+            if (host_chip_queue_packet(&bench_host, payload, sc->payload_len) != 0) {
+                break; // Ring full
+            }
+            seq++;
+        }
+        host_chip_tx_kick(&bench_host);
+        for (unsigned c = 0; c < 16; c++) {
+            chip_emulator_run_cycle(&bench_chip);
+        }
+        host_chip_process_received_data(&bench_host);
+
+        idle_rounds = (bench_verify.v.frames == frames_before) ? idle_rounds + 1 : 0;
+        if (idle_rounds * 16 > BENCH_LB_STALL_CYCLES) {
+            fprintf(stderr, "BENCH: %s: loopback stalled\n", sc->name);
+            return;
+        }
+    }
+    uint64_t cycles = bench_cycles() - c0;
+    uint64_t elapsed_ns = bench_now_ns() - start_ns;
+
+    uint64_t bytes = bench_host.stats.tx_bytes + bench_host.stats.rx_bytes;
+    bench_record(sc->name, "throughput_mbps", BENCH_HIGHER_IS_BETTER, (double)bytes * 8.0 * 1000.0 / (double)elapsed_ns);
+    bench_record(sc->name, "path_cycles_per_pkt", BENCH_LOWER_IS_BETTER, (double)cycles / (double)bench_verify.v.frames);
+    bench_record(sc->name, "verify_errors", BENCH_LOWER_IS_BETTER, (double)frame_verify_errors(&bench_verify.v));
+}
+
+static const struct bench_scenario bench_scenarios[] = {
+    { "tx_64",       64,   1,  bench_run_tx, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "tx_512",      512,  1,  bench_run_tx, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "tx_1500",     1500, 1,  bench_run_tx, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "tx_64_b16",   64,   16, bench_run_tx, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "tx_1500_lin", 1500, 1,  bench_run_tx, BENCH_TX_LINEARIZE, BENCH_RX_RING },
+    { "tx_1500_sg",  1500, 1,  bench_run_tx, BENCH_TX_GATHER, BENCH_RX_RING },
+    { "tx_tcp_seg",  0,    1,  bench_run_tcp, BENCH_TX_TCP_SEGMENT, BENCH_RX_RING },
+    { "tx_tcp_tso",  0,    1,  bench_run_tcp, BENCH_TX_TCP_TSO, BENCH_RX_RING },
+    { "rx_mixed",    0,    0,  bench_run_rx, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "rx_cb_1",     0,    1,  bench_run_rx, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "rx_cb_32",    0,    32, bench_run_rx, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "rx_tcp",      0,    32, bench_run_rx_tcp, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "rx_tcp_gro",  0,    32, bench_run_rx_tcp, BENCH_TX_CONTIG, BENCH_RX_GRO },
+    { "rx_tcp_sock", 0,    32, bench_run_rx_tcp, BENCH_TX_CONTIG, BENCH_RX_SOCKET },
+    { "rx_tcp_split", 0,   32, bench_run_rx_tcp, BENCH_TX_CONTIG, BENCH_RX_SPLIT },
+    { "lb_pingpong", 64,   1,  bench_run_lb_pingpong, BENCH_TX_CONTIG, BENCH_RX_RING },
+    { "lb_duplex",   512,  32, bench_run_lb_duplex, BENCH_TX_CONTIG, BENCH_RX_RING },
+};
+#define BENCH_NUM_SCENARIOS (sizeof(bench_scenarios) / sizeof(bench_scenarios[0]))
+
+// --- Statistics ---
+static void bench_compute_stats(struct bench_metric *m) {
+    double sum = 0.0;
+    for (unsigned i = 0; i < m->n; i++) {
+        sum += m->samples[i];
+    }
+    m->mean = (m->n > 0) ? sum / m->n : 0.0;
+
+    double sq = 0.0;
+    for (unsigned i = 0; i < m->n; i++) {
+        sq += (m->samples[i] - m->mean) * (m->samples[i] - m->mean);
+    }
+    m->stddev = (m->n > 1) ? sqrt(sq / (m->n - 1)) : 0.0;
+}
+
+// Two-sided 95% critical value of Student's t distribution (df rounded down, conservative)
+static double bench_t_crit_95(double df) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    if (df < 1.0) {
+        return table[0];
+    }
+    if (df <= 30.0) {
+        return table[(int)df - 1];
+    }
+    if (df <= 40.0) {
+        return 2.021;
+    }
+    if (df <= 60.0) {
+        return 2.000;
+    }
+    if (df <= 120.0) {
+        return 1.980;
+    }
+    return 1.960;
+}
+
+static double bench_ci95(const struct bench_metric *m) {
+    if (m->n < 2) {
+        return 0.0;
+    }
+    return bench_t_crit_95(m->n - 1) * m->stddev / sqrt((double)m->n);
+}
+
+// Welch's t-test: is the difference between the two means significant at 95%?
+static int bench_significant(double mean_a, double sd_a, unsigned n_a,
+                             double mean_b, double sd_b, unsigned n_b) {
+    if (n_a < 2 || n_b < 2) {
+        return 0;
+    }
+    double va = sd_a * sd_a / n_a;
+    double vb = sd_b * sd_b / n_b;
+    if (va + vb == 0.0) {
+        return mean_a != mean_b;
+    }
+    double t = fabs(mean_a - mean_b) / sqrt(va + vb);
+    double df = (va + vb) * (va + vb) / ((va * va) / (n_a - 1) + (vb * vb) / (n_b - 1));
+    return t > bench_t_crit_95(df);
+}
+
+// --- Baseline JSON ---
+static int bench_save_baseline(const char *path, const struct bench_config *cfg) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "BENCH: cannot write baseline '%s'\n", path);
+        return -1;
+    }
+
+    fprintf(f, "{\n  \"format\": \"%s\",\n  \"runs\": %u,\n  \"packets\": %u,\n  \"rx_fill\": \"%s\",\n"
+               "  \"metrics\": [\n", BENCH_BASELINE_FORMAT, cfg->runs, cfg->packets, bench_rx_fill_names[cfg->rx_fill]);
+    for (unsigned i = 0; i < bench_metric_count; i++) {
+        const struct bench_metric *m = &bench_metrics[i];
+        fprintf(f, "    {\"scenario\": \"%s\", \"metric\": \"%s\", \"better\": \"%s\", "
+                   "\"mean\": %.6g, \"stddev\": %.6g, \"n\": %u}%s\n",
+                m->scenario, m->name, (m->better == BENCH_HIGHER_IS_BETTER) ? "higher" : "lower",
+                m->mean, m->stddev, m->n, (i + 1 < bench_metric_count) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    printf("BENCH: baseline written to %s\n", path);
+    return 0;
+}
+
+// Baseline entry as loaded from disk
+struct bench_baseline_entry {
+    char scenario[32];
+    char name[32];
+    double mean;
+    double stddev;
+    unsigned n;
+};
+
+// Copies the string value of "key" within [obj, end) into out; returns 0 on success
+static int bench_json_string(const char *obj, const char *key, char *out, size_t out_len) {
+    char pattern[48];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *p = strstr(obj, pattern);
+    if (p == NULL || (p = strchr(p + strlen(pattern), ':')) == NULL || (p = strchr(p, '"')) == NULL) {
+        return -1;
+    }
+    p++;
+    const char *q = strchr(p, '"');
+    if (q == NULL || (size_t)(q - p) >= out_len) {
+        return -1;
+    }
+    memcpy(out, p, q - p);
+    out[q - p] = '\0';
+    return 0;
+}
+
+static int bench_json_number(const char *obj, const char *key, double *out) {
+    char pattern[48];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *p = strstr(obj, pattern);
+    if (p == NULL || (p = strchr(p + strlen(pattern), ':')) == NULL) {
+        return -1;
+    }
+    char *endp;
+    *out = strtod(p + 1, &endp);
+    return (endp == p + 1) ? -1 : 0;
+}
+
+// Checks the header fields written by bench_save_baseline() against this run: a
+// baseline from another format, packet count or RX fill mode is not comparable.
+// The number of runs may differ; Welch's test accounts for it.
+static int bench_check_baseline_header(const char *path, const char *header, const struct bench_config *cfg) {
+    char format[48];
+    char rx_fill[16];
+    double packets;
+    if (bench_json_string(header, "format", format, sizeof(format)) != 0 ||
+        bench_json_number(header, "packets", &packets) != 0 ||
+        bench_json_string(header, "rx_fill", rx_fill, sizeof(rx_fill)) != 0) {
+        fprintf(stderr, "BENCH: baseline '%s' has a malformed header\n", path);
+        return -1;
+    }
+    if (strcmp(format, BENCH_BASELINE_FORMAT) != 0) {
+        fprintf(stderr, "BENCH: baseline '%s' has format '%s', expected '%s'\n", path, format, BENCH_BASELINE_FORMAT);
+        return -1;
+    }
+    if (packets != (double)cfg->packets || strcmp(rx_fill, bench_rx_fill_names[cfg->rx_fill]) != 0) {
+        fprintf(stderr, "BENCH: baseline '%s' was taken with --packets %.0f --rx-fill %s, "
+                        "this run uses --packets %u --rx-fill %s\n",
+                path, packets, rx_fill, cfg->packets, bench_rx_fill_names[cfg->rx_fill]);
+        return -1;
+    }
+    return 0;
+}
+
+// Minimal reader for the format written by bench_save_baseline(): one flat object per metric
+static int bench_load_baseline(const char *path, const struct bench_config *cfg,
+                               struct bench_baseline_entry *entries, unsigned max, unsigned *count) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "BENCH: cannot read baseline '%s'\n", path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = malloc((size_t)size + 1);
+    if (text == NULL || fread(text, 1, (size_t)size, f) != (size_t)size) {
+        fclose(f);
+        free(text);
+        return -1;
+    }
+    text[size] = '\0';
+    fclose(f);
+
+    // The header is everything before "metrics"; cut it off there so that its keys
+    // are not looked up inside the metric objects
+    char *p = strstr(text, "\"metrics\"");
+    if (p == NULL) {
+        fprintf(stderr, "BENCH: baseline '%s' has no metrics list\n", path);
+        free(text);
+        return -1;
+    }
+    *p = '\0';
+    if (bench_check_baseline_header(path, text, cfg) != 0) {
+        free(text);
+        return -1;
+    }
+    *p = '"';
+
+    *count = 0;
+    while ((p = strchr(p, '{')) != NULL) {
+        char *end = strchr(p, '}');
+        if (end == NULL) {
+            fprintf(stderr, "BENCH: baseline '%s' ends inside metric %u\n", path, *count + 1);
+            free(text);
+            return -1;
+        }
+        *end = '\0';
+        if (*count == max) {
+            fprintf(stderr, "BENCH: baseline '%s' has more than %u metrics\n", path, max);
+            free(text);
+            return -1;
+        }
+
+        struct bench_baseline_entry *e = &entries[*count];
+        double n;
+        if (bench_json_string(p, "scenario", e->scenario, sizeof(e->scenario)) == 0 &&
+            bench_json_string(p, "metric", e->name, sizeof(e->name)) == 0 &&
+            bench_json_number(p, "mean", &e->mean) == 0 &&
+            bench_json_number(p, "stddev", &e->stddev) == 0 &&
+            bench_json_number(p, "n", &n) == 0) {
+            e->n = (unsigned)n;
+            (*count)++;
+        } else {
+            fprintf(stderr, "BENCH: baseline '%s' has a malformed metric %u: {%s}\n", path, *count + 1, p + 1);
+            free(text);
+            return -1;
+        }
+        p = end + 1;
+    }
+    free(text);
+
+    if (*count == 0) {
+        fprintf(stderr, "BENCH: baseline '%s' contains no metrics\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Prints the comparison table; returns the number of regressions
+static unsigned bench_compare(const struct bench_baseline_entry *base, unsigned base_count, double tolerance_pct,
+                              const char *only_scenario, unsigned *missing) {
+    unsigned regressions = 0;
+
+    printf("\n%-12s %-22s %14s %14s %8s  %s\n", "scenario", "metric", "baseline", "current", "delta", "verdict");
+    for (unsigned i = 0; i < bench_metric_count; i++) {
+        const struct bench_metric *m = &bench_metrics[i];
+        const struct bench_baseline_entry *b = NULL;
+        for (unsigned j = 0; j < base_count; j++) {
+            if (strcmp(base[j].scenario, m->scenario) == 0 && strcmp(base[j].name, m->name) == 0) {
+                b = &base[j];
+                break;
+            }
+        }
+        if (b == NULL) {
+            printf("%-12s %-22s %14s %14.2f %8s  new\n", m->scenario, m->name, "-", m->mean, "-");
+            continue;
+        }
+
+        // A zero baseline (no verify errors, no barriers) has no relative delta: any
+        // move counts as infinitely large, so a significant worsening always fails
+        double delta = m->mean - b->mean;
+        double delta_pct = (b->mean != 0.0) ? delta * 100.0 / b->mean : (delta > 0.0 ? INFINITY : -INFINITY);
+        double worse_pct = (m->better == BENCH_HIGHER_IS_BETTER) ? -delta_pct : delta_pct;
+        const char *verdict = "ok";
+        if (bench_significant(m->mean, m->stddev, m->n, b->mean, b->stddev, b->n)) {
+            if (worse_pct > tolerance_pct) {
+                verdict = "REGRESSION";
+                regressions++;
+            } else if (worse_pct < -tolerance_pct) {
+                verdict = "improved";
+            }
+        }
+        if (b->mean != 0.0) {
+            printf("%-12s %-22s %14.2f %14.2f %+7.1f%%  %s\n",
+                   m->scenario, m->name, b->mean, m->mean, delta_pct, verdict);
+        } else {
+            printf("%-12s %-22s %14.2f %14.2f %8s  %s\n",
+                   m->scenario, m->name, b->mean, m->mean, "n/a", verdict);
+        }
+    }
+
+    // Baseline metrics the run did not produce (a scenario renamed or removed, or a
+    // metric no longer recorded) fail the gate; with --scenario only that one counts
+    *missing = 0;
+    for (unsigned j = 0; j < base_count; j++) {
+        const struct bench_baseline_entry *b = &base[j];
+        if (only_scenario != NULL && strcmp(only_scenario, b->scenario) != 0) {
+            continue;
+        }
+        int found = 0;
+        for (unsigned i = 0; i < bench_metric_count && !found; i++) {
+            found = strcmp(bench_metrics[i].scenario, b->scenario) == 0 && strcmp(bench_metrics[i].name, b->name) == 0;
+        }
+        if (!found) {
+            printf("%-12s %-22s %14.2f %14s %8s  MISSING\n", b->scenario, b->name, b->mean, "-", "-");
+            (*missing)++;
+        }
+    }
+    return regressions;
+}
+
+// --- Multi-Device Scaling ---
+// N independent CHIPs, each with its own driver and emulator instance, spread
+// round-robin over T HOST threads. Every thread owns its devices outright (HOST and
+// CHIP side run on the same thread), so the only shared state is the code; the
+// table shows how aggregate throughput grows with devices and threads.
+struct bench_mt_device {
+    struct sim_device dev;
+    struct host_chip host;
+    struct chip_emulator chip;
+};
+
+struct bench_mt_thread {
+    pthread_t tid;
+    struct bench_mt_device *devs;
+    unsigned first;           // Devices first, first + stride, ... below count
+    unsigned stride;
+    unsigned count;
+    unsigned packets;         // TX frames per device (as many RX frames again)
+};
+
+static void *bench_mt_worker(void *arg) {
+    struct bench_mt_thread *t = arg;
+    uint8_t payload[BENCH_MT_PAYLOAD_LEN];
+    memset(payload, 0xA5, sizeof(payload));
+
+    for (unsigned sent = 0; sent < t->packets; sent += BENCH_MT_BATCH) {
+        for (unsigned d = t->first; d < t->count; d += t->stride) {
+            struct bench_mt_device *md = &t->devs[d];
+            for (unsigned queued = 0; queued < BENCH_MT_BATCH; ) {
+                if (host_chip_queue_packet(&md->host, payload, sizeof(payload)) == 0) {
+                    queued++;
+                } else {
+                    // Ring full: publish and let the CHIP make room
+                    host_chip_tx_kick(&md->host);
+                    bench_drain_tx(&md->chip);
+                }
+            }
+            host_chip_tx_kick(&md->host);
+            bench_drain_tx(&md->chip);
+
+            for (unsigned i = 0; i < BENCH_MT_BATCH; i++) {
+                chip_emulator_generate_rx(&md->chip);
+            }
+            host_chip_process_received_data(&md->host);
+        }
+    }
+    return NULL;
+}
+
+// Runs devices x threads once; returns frames per second (TX + RX) or <0 on error
+static double bench_mt_run(struct bench_mt_device *devs, unsigned devices, unsigned threads, unsigned packets,
+                           const struct chip_emulator_config *chip_cfg) {
+    struct bench_mt_thread workers[BENCH_MT_MAX_DEVICES];
+    for (unsigned d = 0; d < devices; d++) {
+        struct host_chip_bus bus;
+        sim_device_init(&devs[d].dev);
+        sim_device_host_bus(&devs[d].dev, &bus);
+        host_chip_driver_init(&devs[d].host, &bus);
+        chip_emulator_init(&devs[d].chip, &devs[d].dev, chip_cfg);
+    }
+
+    uint64_t start_ns = bench_now_ns();
+    for (unsigned t = 0; t < threads; t++) {
+        workers[t] = (struct bench_mt_thread){ .devs = devs, .first = t, .stride = threads,
+                                               .count = devices, .packets = packets };
+        if (pthread_create(&workers[t].tid, NULL, bench_mt_worker, &workers[t]) != 0) {
+            fprintf(stderr, "BENCH: pthread_create failed\n");
+            while (t-- > 0) {
+                pthread_join(workers[t].tid, NULL);
+            }
+            return -1.0;
+        }
+    }
+    for (unsigned t = 0; t < threads; t++) {
+        pthread_join(workers[t].tid, NULL);
+    }
+    uint64_t elapsed_ns = bench_now_ns() - start_ns;
+
+    uint64_t frames = 0;
+    for (unsigned d = 0; d < devices; d++) {
+        frames += devs[d].host.stats.tx_packets + devs[d].host.stats.rx_packets;
+    }
+    return (elapsed_ns > 0) ? (double)frames * 1e9 / (double)elapsed_ns : -1.0;
+}
+
+static int bench_scaling(const struct bench_config *cfg) {
+    unsigned max_threads = cfg->max_threads;
+    if (max_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        max_threads = (cpus > 0) ? (unsigned)cpus : 1;
+    }
+    if (max_threads > cfg->max_devices) {
+        max_threads = cfg->max_devices;
+    }
+
+    struct bench_mt_device *devs = calloc(cfg->max_devices, sizeof(*devs));
+    if (devs == NULL) {
+        return 2;
+    }
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_fill = cfg->rx_fill;
+
+    // Median of --runs samples per cell; the first (1 device, 1 thread) is the reference
+    double samples[BENCH_MAX_RUNS];
+    double reference = 0.0;
+    printf("BENCH: %u x %u-byte TX + RX frames per device, median of %u runs\n",
+           cfg->packets, BENCH_MT_PAYLOAD_LEN, cfg->runs);
+    printf("%-8s %-8s %12s %10s %10s\n", "devices", "threads", "Mframes/s", "speedup", "per_thread");
+    for (unsigned devices = 1; devices <= cfg->max_devices; devices *= 2) {
+        for (unsigned threads = 1; threads <= devices && threads <= max_threads; threads *= 2) {
+            for (unsigned r = 0; r < cfg->runs; r++) {
+                samples[r] = bench_mt_run(devs, devices, threads, cfg->packets, &chip_cfg);
+                if (samples[r] < 0.0) {
+                    free(devs);
+                    return 2;
+                }
+            }
+            qsort(samples, cfg->runs, sizeof(samples[0]), bench_cmp_double);
+            double rate = samples[cfg->runs / 2];
+            if (reference == 0.0) {
+                reference = rate;
+            }
+            printf("%-8u %-8u %12.2f %10.2f %10.2f\n", devices, threads, rate / 1e6,
+                   rate / reference, rate / reference / threads);
+        }
+    }
+
+    free(devs);
+    return 0;
+}
+
+// --- Runner ---
+static void bench_usage(void) {
+    fprintf(stderr,
+            "usage: wifi_ring_buffer_sim --bench [--runs N] [--packets N] [--scenario NAME]\n"
+            "                                    [--save-baseline FILE] [--baseline FILE] [--tolerance PCT]\n"
+            "                                    [--cache-sim] [--verify]\n"
+            "                                    [--rx-fill random|none|pattern|template|sequence|verify]\n"
+            "       wifi_ring_buffer_sim --bench --scaling [--devices N] [--threads N] [--runs N] [--packets N]\n"
+            "                                              [--rx-fill MODE]\n");
+}
+
+static int bench_parse_rx_fill(const char *val, enum chip_rx_fill *out) {
+    for (int m = CHIP_RX_FILL_RANDOM; m <= CHIP_RX_FILL_VERIFY; m++) {
+        if (strcmp(val, bench_rx_fill_names[m]) == 0) {
+            *out = (enum chip_rx_fill)m;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int bench_main(int argc, char **argv) {
+    struct bench_config cfg = {
+        .runs = BENCH_DEFAULT_RUNS,
+        .packets = BENCH_DEFAULT_PACKETS,
+        .tolerance_pct = BENCH_DEFAULT_TOLERANCE_PCT,
+        .max_devices = BENCH_MT_DEFAULT_DEVICES,
+        .rx_fill = CHIP_RX_FILL_TEMPLATE,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        // Flags without a value
+        if (strcmp(arg, "--cache-sim") == 0) {
+            cfg.cache_sim = 1;
+            continue;
+        }
+        if (strcmp(arg, "--scaling") == 0) {
+            cfg.scaling = 1;
+            continue;
+        }
+        if (strcmp(arg, "--verify") == 0) {
+            cfg.verify = 1;
+            continue;
+        }
+
+        if (val == NULL) {
+            bench_usage();
+            return 2;
+        }
+        if (strcmp(arg, "--runs") == 0) {
+            cfg.runs = (unsigned)atoi(val);
+        } else if (strcmp(arg, "--packets") == 0) {
+            cfg.packets = (unsigned)atoi(val);
+        } else if (strcmp(arg, "--tolerance") == 0) {
+            cfg.tolerance_pct = atof(val);
+        } else if (strcmp(arg, "--baseline") == 0) {
+            cfg.baseline_path = val;
+        } else if (strcmp(arg, "--save-baseline") == 0) {
+            cfg.save_path = val;
+        } else if (strcmp(arg, "--scenario") == 0) {
+            cfg.only_scenario = val;
+        } else if (strcmp(arg, "--devices") == 0) {
+            cfg.max_devices = (unsigned)atoi(val);
+        } else if (strcmp(arg, "--threads") == 0) {
+            cfg.max_threads = (unsigned)atoi(val);
+        } else if (strcmp(arg, "--rx-fill") == 0) {
+            if (bench_parse_rx_fill(val, &cfg.rx_fill) != 0) {
+                bench_usage();
+                return 2;
+            }
+        } else {
+            bench_usage();
+            return 2;
+        }
+        i++;
+    }
+    if (cfg.runs < 2 || cfg.runs > BENCH_MAX_RUNS || cfg.packets == 0 || cfg.packets > BENCH_MAX_PACKETS) {
+        fprintf(stderr, "BENCH: --runs must be 2..%d and --packets 1..%d\n", BENCH_MAX_RUNS, BENCH_MAX_PACKETS);
+        return 2;
+    }
+
+    // bench_run_tx() cuts split frames at BENCH_TX_HDR_LEN; the body must not go negative
+    for (unsigned s = 0; s < BENCH_NUM_SCENARIOS; s++) {
+        const struct bench_scenario *sc = &bench_scenarios[s];
+        if ((sc->tx_build == BENCH_TX_LINEARIZE || sc->tx_build == BENCH_TX_GATHER) &&
+            sc->payload_len < BENCH_TX_HDR_LEN) {
+            fprintf(stderr, "BENCH: scenario '%s' splits a %u-byte frame at %d bytes\n", sc->name,
+                    sc->payload_len, BENCH_TX_HDR_LEN);
+            return 2;
+        }
+    }
+
+    if (cfg.only_scenario != NULL) {
+        unsigned s = 0;
+        while (s < BENCH_NUM_SCENARIOS && strcmp(cfg.only_scenario, bench_scenarios[s].name) != 0) {
+            s++;
+        }
+        if (s == BENCH_NUM_SCENARIOS) {
+            fprintf(stderr, "BENCH: unknown scenario '%s'\n", cfg.only_scenario);
+            return 2;
+        }
+    }
+
+    if (cfg.max_devices == 0 || cfg.max_devices > BENCH_MT_MAX_DEVICES) {
+        fprintf(stderr, "BENCH: --devices must be 1..%d\n", BENCH_MT_MAX_DEVICES);
+        return 2;
+    }
+
+    // Load the baseline up front so that a missing or incomparable one fails before
+    // the runs rather than after them
+    static struct bench_baseline_entry base[BENCH_MAX_METRICS];
+    unsigned base_count = 0;
+    if (cfg.baseline_path != NULL &&
+        bench_load_baseline(cfg.baseline_path, &cfg, base, BENCH_MAX_METRICS, &base_count) != 0) {
+        return 2;
+    }
+
+    sim_log_enabled = 0;
+    if (cfg.scaling) {
+        return bench_scaling(&cfg);
+    }
+    if (cfg.cache_sim && cache_sim_enable(&bench_dev.cache, NULL) != 0) {
+        return 2;
+    }
+
+    // One unrecorded warm-up pass, then interleave the scenarios run by run so slow
+    // drift of the machine (frequency, thermal) spreads over all of them equally.
+    for (unsigned run = 0; run <= cfg.runs; run++) {
+        bench_recording = (run > 0);
+        for (unsigned s = 0; s < BENCH_NUM_SCENARIOS; s++) {
+            const struct bench_scenario *sc = &bench_scenarios[s];
+            if (cfg.only_scenario != NULL && strcmp(cfg.only_scenario, sc->name) != 0) {
+                continue;
+            }
+            sc->run(sc, &cfg);
+        }
+    }
+
+    if (cfg.verify) {
+        printf("BENCH: payloads verified (%s compare)\n", frame_verify_impl());
+    }
+    printf("%-12s %-22s %14s %12s\n", "scenario", "metric", "mean", "95% CI");
+    for (unsigned i = 0; i < bench_metric_count; i++) {
+        struct bench_metric *m = &bench_metrics[i];
+        bench_compute_stats(m);
+        printf("%-12s %-22s %14.2f %12.2f\n", m->scenario, m->name, m->mean, bench_ci95(m));
+    }
+
+    if (cfg.save_path != NULL && bench_save_baseline(cfg.save_path, &cfg) != 0) {
+        return 2;
+    }
+
+    if (cfg.baseline_path != NULL) {
+        unsigned missing;
+        unsigned regressions = bench_compare(base, base_count, cfg.tolerance_pct, cfg.only_scenario, &missing);
+        if (regressions > 0 || missing > 0) {
+            printf("\nBENCH: %u significant regression(s), %u missing metric(s) against %s\n", regressions, missing,
+                   cfg.baseline_path);
+            return 1;
+        }
+        printf("\nBENCH: no significant regressions against %s\n", cfg.baseline_path);
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// --- Benchmark Runner ---
+// Entry point for "wifi_ring_buffer_sim --bench [options]". argv[0] is "--bench".
+//
+// Runs every scenario --runs times (after one warm-up pass), reports mean and 95%
+// confidence interval per metric, and optionally:
+//   --save-baseline FILE  writes the results as a JSON baseline
+//   --baseline FILE       compares against a stored baseline; metrics that are
+//                         significantly worse (Welch t-test) by more than
+//                         --tolerance percent are reported as regressions
+// Returns 0 when no regression was found, 1 on regression, 2 on usage/IO errors.
+int bench_main(int argc, char **argv);
+
+#endif // BENCH_H
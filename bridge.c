@@ -0,0 +1,486 @@
+#define _GNU_SOURCE // For recvmmsg(), sendmmsg()
+
+#include "shared.h"
+#include "host.h"
+#include "chip_emulator.h"
+#include "sim_device.h"
+#include "bridge.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+// --- Bridge Limits ---
+#define BRIDGE_BATCH                64          // Datagrams per recvmmsg()/sendmmsg()
+#define BRIDGE_MAX_FRAME            2048        // Largest frame accepted from outside
+#define BRIDGE_STREAM_BUF           (64 * 1024) // Pipe read/write chunk
+#define BRIDGE_SOCK_BUF             (1 << 20)   // Socket buffer requested from the kernel
+#define BRIDGE_RX_BATCH             32          // HOST RX delivery batch
+#define BRIDGE_POLL_MS              100
+
+enum bridge_kind {
+    BRIDGE_NONE,
+    BRIDGE_UNIX,
+    BRIDGE_PIPE,
+};
+
+struct bridge_stats {
+    uint64_t frames_in;       // Frames read from --rx-from
+    uint64_t frames_dropped;  // Oversized frames (truncated datagrams)
+    uint64_t frames_out;      // Frames written to --tx-to (or discarded without one)
+    uint64_t bytes_out;
+    uint64_t in_calls;        // recvmmsg()/read() calls that returned data
+    uint64_t out_calls;       // sendmmsg()/write() calls
+};
+
+// Input side: a batch of datagrams, or a chunk of the length-prefixed stream
+struct bridge_in {
+    enum bridge_kind kind;
+    int fd;
+    int eof;
+    struct mmsghdr msgs[BRIDGE_BATCH];
+    struct iovec iov[BRIDGE_BATCH];
+    uint8_t frames[BRIDGE_BATCH][BRIDGE_MAX_FRAME];
+    unsigned count;           // Datagrams in the current batch
+    unsigned next;
+    uint8_t buf[BRIDGE_STREAM_BUF];
+    uint32_t start;           // Unparsed stream bytes are buf[start, end)
+    uint32_t end;
+};
+
+// Output side: frames are copied out of the TX ring into arena until it is flushed
+struct bridge_out {
+    enum bridge_kind kind;
+    int fd;
+    uint8_t arena[BRIDGE_STREAM_BUF];
+    uint32_t used;
+    struct mmsghdr msgs[BRIDGE_BATCH];
+    struct iovec iov[BRIDGE_BATCH];
+    unsigned count;
+};
+
+struct bridge {
+    struct sim_device dev;
+    struct host_chip host;
+    struct chip_emulator chip;
+    struct bridge_in in;
+    struct bridge_out out;
+    struct bridge_stats stats;
+    int error;
+};
+
+static volatile sig_atomic_t bridge_stop;
+
+static void bridge_on_signal(int sig) {
+    (void)sig;
+    bridge_stop = 1;
+}
+
+// --- Endpoints ---
+// Splits "unix:PATH" / "pipe:PATH"; returns the kind and points *path at PATH
+static enum bridge_kind bridge_parse_endpoint(const char *spec, const char **path) {
+    if (strncmp(spec, "unix:", 5) == 0 && spec[5] != '\0') {
+        *path = spec + 5;
+        return BRIDGE_UNIX;
+    }
+    if (strncmp(spec, "pipe:", 5) == 0 && spec[5] != '\0') {
+        *path = spec + 5;
+        return BRIDGE_PIPE;
+    }
+    return BRIDGE_NONE;
+}
+
+static int bridge_unix_socket(const char *path, int bind_it) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "BRIDGE: socket path too long: %s\n", path);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("BRIDGE: socket");
+        return -1;
+    }
+    int size = BRIDGE_SOCK_BUF;
+    setsockopt(fd, SOL_SOCKET, bind_it ? SO_RCVBUF : SO_SNDBUF, &size, sizeof(size));
+
+    int rc;
+    if (bind_it) {
+        unlink(path); // Stale socket from an earlier run
+        rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    } else {
+        rc = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    }
+    if (rc != 0) {
+        fprintf(stderr, "BRIDGE: %s %s: %s\n", bind_it ? "bind" : "connect", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int bridge_open_in(struct bridge_in *in, const char *spec) {
+    const char *path;
+    in->kind = bridge_parse_endpoint(spec, &path);
+    if (in->kind == BRIDGE_UNIX) {
+        in->fd = bridge_unix_socket(path, 1);
+        for (unsigned i = 0; i < BRIDGE_BATCH; i++) {
+            in->iov[i].iov_base = in->frames[i];
+            in->iov[i].iov_len = BRIDGE_MAX_FRAME;
+        }
+    } else if (in->kind == BRIDGE_PIPE) {
+        in->fd = (strcmp(path, "-") == 0) ? STDIN_FILENO : open(path, O_RDONLY);
+        if (in->fd < 0) {
+            fprintf(stderr, "BRIDGE: open %s: %s\n", path, strerror(errno));
+        }
+    } else {
+        return -1;
+    }
+    if (in->fd < 0) {
+        return -1;
+    }
+    // Never block on input: the simulation keeps running while it waits
+    fcntl(in->fd, F_SETFL, fcntl(in->fd, F_GETFL) | O_NONBLOCK);
+    return 0;
+}
+
+static int bridge_open_out(struct bridge_out *out, const char *spec) {
+    const char *path;
+    if (spec == NULL) {
+        out->kind = BRIDGE_NONE; // Count and discard
+        out->fd = -1;
+        return 0;
+    }
+    out->kind = bridge_parse_endpoint(spec, &path);
+    if (out->kind == BRIDGE_UNIX) {
+        out->fd = bridge_unix_socket(path, 0);
+    } else if (out->kind == BRIDGE_PIPE) {
+        out->fd = (strcmp(path, "-") == 0) ? STDOUT_FILENO : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out->fd < 0) {
+            fprintf(stderr, "BRIDGE: open %s: %s\n", path, strerror(errno));
+        }
+    } else {
+        return -1;
+    }
+    return (out->fd < 0) ? -1 : 0;
+}
+
+// --- Input ---
+// Refills the input batch without blocking; returns 0, or -1 on a read error
+static int bridge_in_fill(struct bridge *br) {
+    struct bridge_in *in = &br->in;
+
+    if (in->kind == BRIDGE_UNIX) {
+        for (unsigned i = 0; i < BRIDGE_BATCH; i++) {
+            memset(&in->msgs[i].msg_hdr, 0, sizeof(in->msgs[i].msg_hdr));
+            in->msgs[i].msg_hdr.msg_iov = &in->iov[i];
+            in->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n = recvmmsg(in->fd, in->msgs, BRIDGE_BATCH, MSG_DONTWAIT, NULL);
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+        }
+        in->count = (unsigned)n;
+        in->next = 0;
+        br->stats.in_calls++;
+        return 0;
+    }
+
+    // Stream: keep the partial frame, append a large read behind it
+    if (in->start > 0) {
+        memmove(in->buf, in->buf + in->start, in->end - in->start);
+        in->end -= in->start;
+        in->start = 0;
+    }
+    ssize_t n = read(in->fd, in->buf + in->end, sizeof(in->buf) - in->end);
+    if (n == 0) {
+        in->eof = 1;
+    } else if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    } else {
+        in->end += (uint32_t)n;
+        br->stats.in_calls++;
+    }
+    return 0;
+}
+
+// Points at the next complete input frame; returns 1 if there is one, 0 if not (yet),
+// -1 on an input error, including pipe input that ends partway through a frame. The
+// frame stays current until bridge_in_consume().
+static int bridge_in_peek(struct bridge *br, const uint8_t **data, uint32_t *len) {
+    struct bridge_in *in = &br->in;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (in->kind == BRIDGE_UNIX) {
+            while (in->next < in->count) {
+                struct mmsghdr *m = &in->msgs[in->next];
+                if ((m->msg_hdr.msg_flags & MSG_TRUNC) == 0) {
+                    *data = in->frames[in->next];
+                    *len = m->msg_len;
+                    return 1;
+                }
+                br->stats.frames_in++;
+                br->stats.frames_dropped++;
+                in->next++;
+            }
+        } else if (in->end - in->start >= PACKET_LENGTH_FIELD_SIZE) {
+            uint32_t frame_len = in->buf[in->start] | ((uint32_t)in->buf[in->start + 1] << 8);
+            if (frame_len > BRIDGE_MAX_FRAME) {
+                fprintf(stderr, "BRIDGE: input frame of %u bytes exceeds %u\n", frame_len, BRIDGE_MAX_FRAME);
+                return -1;
+            }
+            if (in->end - in->start >= PACKET_LENGTH_FIELD_SIZE + frame_len) {
+                *data = in->buf + in->start + PACKET_LENGTH_FIELD_SIZE;
+                *len = frame_len;
+                return 1;
+            }
+        }
+        if (attempt == 0 && !in->eof && bridge_in_fill(br) != 0) {
+            perror("BRIDGE: input");
+            return -1;
+        }
+    }
+    if (in->kind != BRIDGE_UNIX && in->eof && in->start != in->end) {
+        // No more bytes will come to complete the frame
+        fprintf(stderr, "BRIDGE: input ended inside a frame (%u trailing bytes)\n", in->end - in->start);
+        return -1;
+    }
+    return 0;
+}
+
+static void bridge_in_consume(struct bridge *br, uint32_t len) {
+    struct bridge_in *in = &br->in;
+    if (in->kind == BRIDGE_UNIX) {
+        in->next++;
+    } else {
+        in->start += PACKET_LENGTH_FIELD_SIZE + len;
+    }
+    br->stats.frames_in++;
+}
+
+// --- Output ---
+static int bridge_write_all(int fd, const uint8_t *buf, uint32_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        len -= (uint32_t)n;
+    }
+    return 0;
+}
+
+static void bridge_out_flush(struct bridge *br) {
+    struct bridge_out *out = &br->out;
+
+    if (out->kind == BRIDGE_UNIX) {
+        unsigned sent = 0;
+        while (sent < out->count) {
+            int n = sendmmsg(out->fd, out->msgs + sent, out->count - sent, 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("BRIDGE: sendmmsg");
+                br->error = 1;
+                break;
+            }
+            sent += (unsigned)n;
+            br->stats.out_calls++;
+        }
+    } else if (out->kind == BRIDGE_PIPE && out->used > 0) {
+        if (bridge_write_all(out->fd, out->arena, out->used) != 0) {
+            perror("BRIDGE: write");
+            br->error = 1;
+        }
+        br->stats.out_calls++;
+    }
+    out->used = 0;
+    out->count = 0;
+}
+
+// CHIP TX sink: copies the frame out of the ring before the CHIP releases it
+static void bridge_emit(void *ctx, const uint8_t *first, uint32_t first_len,
+                        const uint8_t *second, uint32_t second_len) {
+    struct bridge *br = ctx;
+    struct bridge_out *out = &br->out;
+    uint32_t len = first_len + second_len;
+
+    br->stats.frames_out++;
+    br->stats.bytes_out += len;
+    if (out->kind == BRIDGE_NONE) {
+        return;
+    }
+
+    uint32_t need = len + ((out->kind == BRIDGE_PIPE) ? PACKET_LENGTH_FIELD_SIZE : 0);
+    if (out->used + need > sizeof(out->arena) || out->count == BRIDGE_BATCH) {
+        bridge_out_flush(br);
+    }
+
+    uint8_t *dst = out->arena + out->used;
+    if (out->kind == BRIDGE_PIPE) {
+        dst[0] = (uint8_t)(len & 0xFF);
+        dst[1] = (uint8_t)(len >> 8);
+        dst += PACKET_LENGTH_FIELD_SIZE;
+    } else {
+        struct mmsghdr *m = &out->msgs[out->count];
+        memset(&m->msg_hdr, 0, sizeof(m->msg_hdr));
+        out->iov[out->count].iov_base = dst;
+        out->iov[out->count].iov_len = len;
+        m->msg_hdr.msg_iov = &out->iov[out->count];
+        m->msg_hdr.msg_iovlen = 1;
+        out->count++;
+    }
+    memcpy(dst, first, first_len);
+    memcpy(dst + first_len, second, second_len);
+    out->used += need;
+}
+
+// --- Simulation Side ---
+static void bridge_drain_tx(struct bridge *br) {
+    while (BUS_READ_REG(br->chip.regs, CHIP_REG_TX_TAIL_PTR) != BUS_READ_REG(br->chip.regs, CHIP_REG_HOST_TX_HEAD_PUB)) {
+        chip_emulator_process_tx(&br->chip);
+    }
+}
+
+// HOST RX delivery: every received frame goes straight back out on TX. When the TX
+// ring is full the CHIP is run to make room, so nothing is dropped here.
+static void bridge_reflect(void *ctx, const struct host_rx_desc *descs, unsigned count) {
+    struct bridge *br = ctx;
+    for (unsigned i = 0; i < count; i++) {
+        while (host_chip_queue_packet(&br->host, descs[i].data, descs[i].len) == -2) {
+            host_chip_tx_kick(&br->host);
+            bridge_drain_tx(br);
+        }
+    }
+}
+
+static void bridge_usage(void) {
+    fprintf(stderr,
+            "usage: wifi_ring_buffer_sim --bridge --rx-from unix:PATH|pipe:PATH|pipe:-\n"
+            "                                     [--tx-to unix:PATH|pipe:PATH|pipe:-] [--frames N]\n");
+}
+
+int bridge_main(int argc, char **argv) {
+    const char *rx_from = NULL;
+    const char *tx_to = NULL;
+    unsigned long long max_frames = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (val == NULL) {
+            bridge_usage();
+            return 2;
+        }
+        if (strcmp(arg, "--rx-from") == 0) {
+            rx_from = val;
+        } else if (strcmp(arg, "--tx-to") == 0) {
+            tx_to = val;
+        } else if (strcmp(arg, "--frames") == 0) {
+            max_frames = strtoull(val, NULL, 10);
+        } else {
+            bridge_usage();
+            return 2;
+        }
+        i++;
+    }
+
+    struct bridge *br = calloc(1, sizeof(*br));
+    if (br == NULL) {
+        return 2;
+    }
+    if (rx_from == NULL || bridge_open_in(&br->in, rx_from) != 0 || bridge_open_out(&br->out, tx_to) != 0) {
+        if (rx_from == NULL || br->in.kind == BRIDGE_NONE || (tx_to != NULL && br->out.kind == BRIDGE_NONE)) {
+            bridge_usage();
+        }
+        free(br);
+        return 2;
+    }
+
+    sim_log_enabled = 0;
+    signal(SIGINT, bridge_on_signal);
+    signal(SIGTERM, bridge_on_signal);
+    signal(SIGPIPE, SIG_IGN); // A reader going away shows up as a write error
+
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_gen_percent = 0; // All RX traffic comes from outside
+    struct host_chip_bus bus;
+    sim_device_init(&br->dev);
+    sim_device_host_bus(&br->dev, &bus);
+    host_chip_driver_init(&br->host, &bus);
+    host_chip_set_rx_handler(&br->host, bridge_reflect, br, BRIDGE_RX_BATCH);
+    chip_emulator_init(&br->chip, &br->dev, &chip_cfg);
+    chip_emulator_set_tx_sink(&br->chip, bridge_emit, br);
+
+    while (!bridge_stop && !br->error) {
+        // CHIP: inject input frames while the RX ring has room
+        const uint8_t *data;
+        uint32_t len;
+        unsigned injected = 0;
+        int rc;
+        while ((rc = bridge_in_peek(br, &data, &len)) == 1) {
+            if (chip_emulator_inject_rx(&br->chip, data, len) != 0) {
+                break; // RX ring full: leave the rest queued in the socket/pipe
+            }
+            bridge_in_consume(br, len);
+            injected++;
+        }
+        if (rc < 0) {
+            br->error = 1; // Still pass on the frames injected so far, then stop
+        }
+
+        // HOST: receive (and reflect), then publish the reflected frames
+        host_chip_process_received_data(&br->host);
+        host_chip_tx_kick(&br->host);
+
+        // CHIP: transmit everything published, write it out in one batch
+        bridge_drain_tx(br);
+        bridge_out_flush(br);
+
+        if (max_frames != 0 && br->stats.frames_out >= max_frames) {
+            break;
+        }
+        if (injected == 0) {
+            if (br->in.eof && br->in.start == br->in.end) {
+                break; // Pipe input finished and everything went through
+            }
+            struct pollfd pfd = { .fd = br->in.fd, .events = POLLIN };
+            poll(&pfd, 1, br->in.eof ? 0 : BRIDGE_POLL_MS);
+        }
+    }
+
+    const struct bridge_stats *st = &br->stats;
+    fprintf(stderr,
+            "BRIDGE: in %llu frames (%llu dropped), out %llu frames / %llu bytes, "
+            "%.1f frames per input call, %.1f per output call\n",
+            (unsigned long long)st->frames_in, (unsigned long long)st->frames_dropped,
+            (unsigned long long)st->frames_out, (unsigned long long)st->bytes_out,
+            st->in_calls ? (double)st->frames_in / st->in_calls : 0.0,
+            st->out_calls ? (double)st->frames_out / st->out_calls : 0.0);
+
+    int failed = br->error;
+    if (br->in.kind == BRIDGE_UNIX || (br->in.fd != STDIN_FILENO && br->in.fd >= 0)) {
+        close(br->in.fd);
+    }
+    if (br->out.fd >= 0 && br->out.fd != STDOUT_FILENO) {
+        close(br->out.fd);
+    }
+    free(br);
+    return failed ? 2 : 0;
+}
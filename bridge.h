@@ -0,0 +1,24 @@
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+// --- External Traffic Bridge ---
+// Entry point for "wifi_ring_buffer_sim --bridge [options]". argv[0] is "--bridge".
+//
+// Attaches the CHIP side of one simulated device to external traffic tools:
+//   --rx-from unix:PATH | pipe:PATH | pipe:-   frames injected into the RX ring
+//   --tx-to   unix:PATH | pipe:PATH | pipe:-   frames the CHIP consumed from the TX ring
+//   --frames N                                 stop after N frames came out
+// The HOST driver reflects every frame it receives back into the TX ring, so traffic
+// sent to --rx-from leaves through --tx-to after crossing both rings and the driver.
+//
+// unix: endpoints are datagram sockets, one frame per datagram, received and sent
+// in batches with recvmmsg()/sendmmsg(); --rx-from binds PATH, --tx-to connects to
+// PATH. pipe: endpoints (a FIFO, a file or "-" for stdin/stdout) carry frames as a
+// 2-byte little-endian length followed by the payload, read and written in large
+// chunks. Input stops being read while the RX ring is full, so a fast generator is
+// back-pressured by the socket/pipe buffer instead of losing frames in the bridge.
+// Runs until --frames, EOF on a pipe input, or SIGINT/SIGTERM; prints its counters
+// to stderr. Returns 0 on success, 2 on usage/IO errors.
+int bridge_main(int argc, char **argv);
+
+#endif // BRIDGE_H
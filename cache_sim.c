@@ -0,0 +1,167 @@
+#include "shared.h"
+#include "cache_sim.h"
+#include <stdio.h>
+
+enum cache_sim_line_state {
+    LINE_INVALID,
+    LINE_CLEAN,
+    LINE_DIRTY,
+};
+
+static const char *const side_names[CACHE_SIM_SIDES] = { "HOST", "CHIP" };
+
+int cache_sim_enable(struct cache_sim *cs, const struct cache_sim_config *cfg) {
+    static const struct cache_sim_config defaults = CACHE_SIM_DEFAULT_CONFIG;
+    if (cfg == NULL) {
+        cfg = &defaults;
+    }
+    if (cfg->line_size < CACHE_SIM_MIN_LINE_SIZE || (cfg->line_size & (cfg->line_size - 1)) != 0) {
+        printf("CACHE_SIM: Invalid line size %u.\n", cfg->line_size);
+        return -1;
+    }
+
+    cs->cfg = *cfg;
+    cs->line_shift = 0;
+    while ((1U << cs->line_shift) < cfg->line_size) {
+        cs->line_shift++;
+    }
+    cache_sim_reset(cs);
+    cs->enabled = 1;
+    return 0;
+}
+
+void cache_sim_disable(struct cache_sim *cs) {
+    cs->enabled = 0;
+}
+
+void cache_sim_reset(struct cache_sim *cs) {
+    memset(cs->lines, 0, sizeof(cs->lines));
+    memset(cs->mem_version, 0, sizeof(cs->mem_version));
+    memset(cs->latest_version, 0, sizeof(cs->latest_version));
+    memset(&cs->stats, 0, sizeof(cs->stats));
+}
+
+// Converts a bus address range to [first, last] line indices; returns 0 if outside shared RAM
+static int cache_sim_line_range(const struct cache_sim *cs, uint32_t addr, uint32_t len,
+                                uint32_t *first, uint32_t *last) {
+    if (len == 0 || addr < SHARED_RAM_BASE_ADDR) {
+        return 0;
+    }
+    uint32_t off = addr - SHARED_RAM_BASE_ADDR;
+    if (off >= TOTAL_SHARED_MEMORY_SIZE) {
+        return 0;
+    }
+    uint32_t end = off + len - 1;
+    if (end >= TOTAL_SHARED_MEMORY_SIZE) {
+        end = TOTAL_SHARED_MEMORY_SIZE - 1;
+    }
+    *first = off >> cs->line_shift;
+    *last = end >> cs->line_shift;
+    return 1;
+}
+
+void cache_sim_access(struct cache_sim *cs, enum cache_sim_side side, uint32_t addr, uint32_t len, int is_write) {
+    uint32_t first, last;
+    if (!cs->enabled || !cache_sim_line_range(cs, addr, len, &first, &last)) {
+        return;
+    }
+    struct cache_sim_side_stats *st = &cs->stats.side[side];
+
+    for (uint32_t l = first; l <= last; l++) {
+        struct cache_sim_line *line = &cs->lines[side][l];
+
+        if (line->state == LINE_INVALID) {
+            // Line fill (write-allocate as well): the cache gets whatever RAM holds
+            line->version = cs->mem_version[l];
+            line->state = LINE_CLEAN;
+        }
+
+        if (is_write) {
+            line->version = ++cs->latest_version[l];
+            line->state = LINE_DIRTY;
+        } else if (line->version != cs->latest_version[l]) {
+            if (cs->mem_version[l] == cs->latest_version[l]) {
+                st->missed_invalidate++;
+                SIM_LOG("CACHE_SIM: %s read stale line 0x%08lx (not invalidated).\n",
+                        side_names[side], SHARED_RAM_BASE_ADDR + ((unsigned long)l << cs->line_shift));
+            } else {
+                st->missed_clean++;
+                SIM_LOG("CACHE_SIM: %s read line 0x%08lx before the writer cleaned it.\n",
+                        side_names[side], SHARED_RAM_BASE_ADDR + ((unsigned long)l << cs->line_shift));
+            }
+        }
+    }
+}
+
+void cache_sim_clean(struct cache_sim *cs, enum cache_sim_side side, uint32_t addr, uint32_t len) {
+    uint32_t first, last;
+    if (!cs->enabled || !cache_sim_line_range(cs, addr, len, &first, &last)) {
+        return;
+    }
+    struct cache_sim_side_stats *st = &cs->stats.side[side];
+    st->clean_ops++;
+    st->bytes_cleaned += (uint64_t)(last - first + 1) << cs->line_shift;
+    st->modelled_cycles += cs->cfg.op_cycles;
+
+    for (uint32_t l = first; l <= last; l++) {
+        struct cache_sim_line *line = &cs->lines[side][l];
+        if (line->state == LINE_DIRTY) {
+            cs->mem_version[l] = line->version;
+            line->state = LINE_CLEAN;
+            st->modelled_cycles += cs->cfg.clean_dirty_cycles;
+        } else {
+            st->redundant_clean_lines++;
+            st->modelled_cycles += cs->cfg.clean_clean_cycles;
+        }
+    }
+}
+
+void cache_sim_invalidate(struct cache_sim *cs, enum cache_sim_side side, uint32_t addr, uint32_t len) {
+    uint32_t first, last;
+    if (!cs->enabled || !cache_sim_line_range(cs, addr, len, &first, &last)) {
+        return;
+    }
+    struct cache_sim_side_stats *st = &cs->stats.side[side];
+    st->invalidate_ops++;
+    st->bytes_invalidated += (uint64_t)(last - first + 1) << cs->line_shift;
+    st->modelled_cycles += cs->cfg.op_cycles;
+
+    for (uint32_t l = first; l <= last; l++) {
+        struct cache_sim_line *line = &cs->lines[side][l];
+        if (line->state == LINE_INVALID) {
+            st->redundant_inval_lines++;
+        } else if (line->state == LINE_DIRTY) {
+            st->dirty_discards++;
+        }
+        line->state = LINE_INVALID;
+        st->modelled_cycles += cs->cfg.invalidate_cycles;
+    }
+}
+
+uint64_t cache_sim_missed_total(const struct cache_sim *cs) {
+    uint64_t total = 0;
+    for (int s = 0; s < CACHE_SIM_SIDES; s++) {
+        const struct cache_sim_side_stats *st = &cs->stats.side[s];
+        total += st->missed_clean + st->missed_invalidate + st->dirty_discards;
+    }
+    return total;
+}
+
+void cache_sim_print_report(const struct cache_sim *cs, uint64_t packets) {
+    if (!cs->enabled) {
+        return;
+    }
+    double div = (packets > 0) ? (double)packets : 1.0;
+
+    printf("CACHE_SIM: line %u B, %llu packets\n", cs->cfg.line_size, (unsigned long long)packets);
+    printf("%-5s %12s %12s %12s %12s %10s %10s %10s\n", "side", "clean B/pkt", "inval B/pkt",
+           "redund/pkt", "cycles/pkt", "miss_clean", "miss_inval", "dirty_drop");
+    for (int s = 0; s < CACHE_SIM_SIDES; s++) {
+        const struct cache_sim_side_stats *st = &cs->stats.side[s];
+        printf("%-5s %12.1f %12.1f %12.2f %12.1f %10llu %10llu %10llu\n", side_names[s],
+               st->bytes_cleaned / div, st->bytes_invalidated / div,
+               (st->redundant_clean_lines + st->redundant_inval_lines) / div, st->modelled_cycles / div,
+               (unsigned long long)st->missed_clean, (unsigned long long)st->missed_invalidate,
+               (unsigned long long)st->dirty_discards);
+    }
+}
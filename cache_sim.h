@@ -0,0 +1,103 @@
+#ifndef CACHE_SIM_H
+#define CACHE_SIM_H
+
+#include <stdint.h>
+#include "shared.h" // For DCACHE_LINE_SIZE, TOTAL_SHARED_MEMORY_SIZE
+
+// --- Non-coherent Write-back Cache Model ---
+// Optional model of one private write-back D-cache per side (HOST and CHIP) in front
+// of simulated_shared_ram. It tracks state per cache line rather than data: every
+// write creates a new version of the line, clean writes a side's dirty version back
+// to RAM, invalidate drops a side's copy, and a read that returns anything but the
+// newest version is a coherency bug.
+//
+// The model answers three questions about the driver's cache maintenance:
+//   - how many bytes it maintains per packet, and what that costs (modelled cycles)
+//   - how much of it is redundant (cleaning clean lines, invalidating absent lines)
+//   - where it is missing (a stale read because the writer did not clean, or the
+//     reader did not invalidate; a dirty line discarded by invalidate)
+// Capacity is unlimited, so no eviction ever hides a missing clean.
+//
+// Addresses are BUS addresses in the shared RAM window (SHARED_RAM_BASE_ADDR...).
+// Each simulated device has its own model instance (struct sim_device).
+
+enum cache_sim_side {
+    CACHE_SIM_HOST,
+    CACHE_SIM_CHIP,
+    CACHE_SIM_SIDES,
+};
+
+struct cache_sim_config {
+    uint32_t line_size;              // Bytes, power of two
+    uint32_t op_cycles;              // Fixed cost of one clean/invalidate call
+    uint32_t clean_dirty_cycles;     // Per line written back
+    uint32_t clean_clean_cycles;     // Per line looked up but already clean/absent
+    uint32_t invalidate_cycles;      // Per line invalidated
+};
+
+#define CACHE_SIM_DEFAULT_CONFIG { DCACHE_LINE_SIZE, 20, 40, 4, 4 }
+
+struct cache_sim_side_stats {
+    uint64_t clean_ops;
+    uint64_t invalidate_ops;
+    uint64_t bytes_cleaned;          // Line-rounded bytes covered by clean calls
+    uint64_t bytes_invalidated;      // Line-rounded bytes covered by invalidate calls
+    uint64_t redundant_clean_lines;  // Clean of a line that was not dirty
+    uint64_t redundant_inval_lines;  // Invalidate of a line that was not cached
+    uint64_t missed_clean;           // Read a line whose newest version sat dirty in the peer's cache
+    uint64_t missed_invalidate;      // Read a stale copy from the own cache though RAM was newer
+    uint64_t dirty_discards;         // Invalidate dropped a dirty line (its writes are lost)
+    uint64_t modelled_cycles;        // Cost of the maintenance under the config above
+};
+
+struct cache_sim_stats {
+    struct cache_sim_side_stats side[CACHE_SIM_SIDES];
+};
+
+// Smallest supported line size bounds the per-line state arrays
+#define CACHE_SIM_MIN_LINE_SIZE     16
+#define CACHE_SIM_MAX_LINES         (TOTAL_SHARED_MEMORY_SIZE / CACHE_SIM_MIN_LINE_SIZE)
+
+struct cache_sim_line {
+    uint8_t state;
+    uint32_t version; // Version of the data held in this cache
+};
+
+// One model instance; zero-initialized it is disabled
+struct cache_sim {
+    int enabled;
+    struct cache_sim_stats stats;
+    struct cache_sim_config cfg;
+    uint32_t line_shift;
+    struct cache_sim_line lines[CACHE_SIM_SIDES][CACHE_SIM_MAX_LINES];
+    uint32_t mem_version[CACHE_SIM_MAX_LINES];    // Version currently in RAM
+    uint32_t latest_version[CACHE_SIM_MAX_LINES]; // Newest version written by either side
+};
+
+// Enables the model (NULL for CACHE_SIM_DEFAULT_CONFIG) with all lines invalid
+int cache_sim_enable(struct cache_sim *cs, const struct cache_sim_config *cfg);
+void cache_sim_disable(struct cache_sim *cs);
+// Drops all cached lines and clears the statistics
+void cache_sim_reset(struct cache_sim *cs);
+
+void cache_sim_access(struct cache_sim *cs, enum cache_sim_side side, uint32_t addr, uint32_t len, int is_write);
+void cache_sim_clean(struct cache_sim *cs, enum cache_sim_side side, uint32_t addr, uint32_t len);
+void cache_sim_invalidate(struct cache_sim *cs, enum cache_sim_side side, uint32_t addr, uint32_t len);
+
+uint64_t cache_sim_missed_total(const struct cache_sim *cs);
+void cache_sim_print_report(const struct cache_sim *cs, uint64_t packets);
+
+// Access to len bytes at off of the ring at bus address base, split where it wraps
+static inline void cache_sim_ring_access(struct cache_sim *cs, enum cache_sim_side side, uint32_t base,
+                                         uint32_t size, uint32_t off, uint32_t len, int is_write) {
+    if (!cs->enabled) {
+        return;
+    }
+    uint32_t first = (len < size - off) ? len : size - off;
+    cache_sim_access(cs, side, base + off, first, is_write);
+    if (first < len) {
+        cache_sim_access(cs, side, base, len - first, is_write);
+    }
+}
+
+#endif // CACHE_SIM_H
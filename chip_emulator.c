@@ -1,51 +1,279 @@
 #include "shared.h"
+#include "chip_emulator.h"
+#include "cache_sim.h"
+#include "frame_verify.h"
 #include <stdio.h>
-#include <stdlib.h> // For rand()
 #include <stdint.h> // For uintptr_t
 
-// --- Simulated CHIP Internal State ---
-static volatile uint32_t chip_tx_tail = 0; // Where CHIP reads from shared Tx buffer
-static volatile uint32_t chip_rx_head = 0; // Where CHIP writes to shared Rx buffer
+// --- Simulated CHIP D-Cache Maintenance ---
+// The CHIP's own cache in front of shared RAM, modelled by cache_sim.c when enabled.
+static void chip_dcache_clean_range(void *ctx, uint32_t addr, uint32_t len) {
+    cache_sim_clean(ctx, CACHE_SIM_CHIP, addr, len);
+}
+
+static void chip_dcache_invalidate_range(void *ctx, uint32_t addr, uint32_t len) {
+    cache_sim_invalidate(ctx, CACHE_SIM_CHIP, addr, len);
+}
 
-// Mock simulated memory for registers (defined in host.c)
-extern uint32_t simulated_chip_registers[7];
+// Emulator-private traffic generator, so CHIPs on different threads share no state
+static uint32_t chip_rand(struct chip_emulator *chip) {
+    uint32_t x = chip->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    chip->rng = x;
+    return x;
+}
 
 // --- Simulated Interrupts ---
+// CHIP_REG_INT_CLEAR is write-1-to-clear: the CHIP drops the written bits from
+// CHIP_REG_INT_STATUS the next time it looks at its interrupt logic
+static void chip_apply_int_clear(struct chip_emulator *chip) {
+    uint32_t clear = BUS_READ_REG(chip->regs, CHIP_REG_INT_CLEAR);
+    if (clear != 0) {
+        BUS_WRITE_REG(chip->regs, CHIP_REG_INT_STATUS, BUS_READ_REG(chip->regs, CHIP_REG_INT_STATUS) & ~clear);
+        BUS_WRITE_REG(chip->regs, CHIP_REG_INT_CLEAR, 0);
+    }
+}
+
 // Function to "raise" an interrupt to the HOST
-void chip_raise_interrupt(uint32_t bit) {
-    BUS_WRITE_REG(CHIP_REG_INT_STATUS, BUS_READ_REG(CHIP_REG_INT_STATUS) | bit);
-    printf("CHIP_EMU: Raised interrupt 0x%x\n", bit);
+void chip_raise_interrupt(struct chip_emulator *chip, uint32_t bit) {
+    chip_apply_int_clear(chip); // A clear written before this event must not swallow it
+    BUS_WRITE_REG(chip->regs, CHIP_REG_INT_STATUS, BUS_READ_REG(chip->regs, CHIP_REG_INT_STATUS) | bit);
+    SIM_LOG("CHIP_EMU: Raised interrupt 0x%x\n", bit);
+}
+
+// --- RX Payload Fill ---
+// The template comes from a generator of its own, so that frame lengths (and the rest
+// of the traffic) are the same for a seed whatever the fill mode
+static void chip_rx_fill_init(struct chip_emulator *chip) {
+    uint32_t x = chip->rng ^ 0x9E3779B9U;
+    for (uint32_t i = 0; i < sizeof(chip->rx_template); i++) {
+        if (chip->cfg.rx_fill == CHIP_RX_FILL_TEMPLATE) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            chip->rx_template[i] = (uint8_t)x;
+        } else {
+            chip->rx_template[i] = (uint8_t)i;
+        }
+    }
+}
+
+// Fills the len-byte payload of arrival seq at off of a ring of size bytes
+static void chip_rx_fill(struct chip_emulator *chip, uint8_t *base, uint32_t size, uint32_t off, uint32_t len,
+                         uint64_t seq) {
+    uint32_t first;
+    switch (chip->cfg.rx_fill) {
+    case CHIP_RX_FILL_NONE:
+        break;
+    case CHIP_RX_FILL_PATTERN:
+        first = ring_contig(off, len, size);
+        memset(base + off, CHIP_RX_FILL_BYTE, first);
+        memset(base, CHIP_RX_FILL_BYTE, len - first);
+        break;
+    case CHIP_RX_FILL_TEMPLATE:
+        ring_write(base, size, off, chip->rx_template, len);
+        break;
+    case CHIP_RX_FILL_SEQUENCE:
+        ring_write(base, size, off, chip->rx_template + (seq & 0xFF), len);
+        break;
+    case CHIP_RX_FILL_VERIFY:
+        if (ring_contig(off, len, size) == len) {
+            frame_verify_fill(base + off, len, (uint32_t)seq, chip->cfg.seed);
+        } else {
+            uint8_t frame[CHIP_RX_TEMPLATE_SIZE];
+            frame_verify_fill(frame, len, (uint32_t)seq, chip->cfg.seed);
+            ring_write(base, size, off, frame, len);
+        }
+        break;
+    default:
+        for (uint32_t i = 0; i < len; i++) {
+            base[ring_wrap(off + i, size)] = (uint8_t)chip_rand(chip);
+        }
+        break;
+    }
 }
 
 // --- Emulator Initialization ---
-void chip_emulator_init() {
-    printf("CHIP_EMU: Initializing emulator...\n");
+void chip_emulator_init(struct chip_emulator *chip, struct sim_device *dev,
+                        const struct chip_emulator_config *cfg) {
+    static const struct chip_emulator_config defaults = CHIP_EMULATOR_DEFAULT_CONFIG;
+    SIM_LOG("CHIP_EMU: Initializing emulator...\n");
     // Ensure initial pointers match the hardware's reset state
-    chip_tx_tail = 0;
-    chip_rx_head = 0;
+    memset(chip, 0, sizeof(*chip));
+    chip->dev = dev;
+    chip->regs = sim_device_regs(dev);
+    chip->tx_ring = sim_device_tx_ring(dev);
+    chip->rx_ring = sim_device_rx_ring(dev);
+    chip->tx_compl_cookies = sim_device_tx_compl_cookies(dev);
+    chip->tx_compl_ring = sim_device_tx_compl_ring(dev);
+    chip->rx_split_ring = sim_device_rx_split_ring(dev);
+    chip->rx_split_fill = sim_device_rx_split_fill(dev);
+    chip->rx_split_pool = sim_device_rx_split_pool(dev);
+    chip->rx_dst = chip->rx_ring;
+    chip->cfg = (cfg != NULL) ? *cfg : defaults;
+    chip->rng = (chip->cfg.seed != 0) ? chip->cfg.seed : 1;
+    chip->pwr_state = CHIP_PWR_ACTIVE;
+    if (chip->cfg.rx_fifo_frames == 0 || chip->cfg.rx_fifo_frames > CHIP_RX_FIFO_SLOTS) {
+        chip->cfg.rx_fifo_frames = CHIP_RX_FIFO_SLOTS;
+    }
+    chip_rx_fill_init(chip);
+    dev->time_ns = 0;
     // Set initial hardware-side pointers in the simulated registers for HOST to read
-    BUS_WRITE_REG(CHIP_REG_TX_TAIL_PTR, chip_tx_tail);
-    BUS_WRITE_REG(CHIP_REG_RX_HEAD_PTR, chip_rx_head);
-    printf("CHIP_EMU: Emulator initialized.\n");
+    BUS_WRITE_REG(chip->regs, CHIP_REG_TX_TAIL_PTR, chip->tx_tail);
+    BUS_WRITE_REG(chip->regs, CHIP_REG_RX_HEAD_PTR, chip->rx_head);
+    BUS_WRITE_REG(chip->regs, CHIP_REG_RX_DROP_COUNT, 0);
+    BUS_WRITE_REG(chip->regs, CHIP_REG_TX_COMPL_HEAD, chip->tx_compl_head);
+    BUS_WRITE_REG(chip->regs, CHIP_REG_RX_SPLIT_HEAD, chip->rx_split_head);
+    SIM_LOG("CHIP_EMU: Emulator initialized.\n");
+}
+
+void chip_emulator_set_tx_sink(struct chip_emulator *chip, chip_tx_sink_fn fn, void *ctx) {
+    chip->tx_sink = fn;
+    chip->tx_sink_ctx = ctx;
+}
+
+// --- Loopback FIFO ---
+// Takes a copy of a TX frame payload of first_len bytes at first and second_len bytes
+// at second (the sink's split form); returns 0 if the FIFO has no room
+static int chip_loopback_accept(struct chip_emulator *chip, const uint8_t *first, uint32_t first_len,
+                                const uint8_t *second, uint32_t second_len) {
+    uint32_t len = first_len + second_len;
+    if (chip->lb_slot_count == CHIP_LOOPBACK_SLOTS ||
+        ring_free(chip->lb_head, chip->lb_tail, CHIP_LOOPBACK_FIFO_SIZE) < len) {
+        return 0;
+    }
+
+    chip->lb_head = ring_write(chip->lb_fifo, CHIP_LOOPBACK_FIFO_SIZE, chip->lb_head, first, first_len);
+    chip->lb_head = ring_write(chip->lb_fifo, CHIP_LOOPBACK_FIFO_SIZE, chip->lb_head, second, second_len);
+
+    struct chip_loopback_slot *slot = &chip->lb_slots[(chip->lb_slot_first + chip->lb_slot_count) % CHIP_LOOPBACK_SLOTS];
+    slot->len = len;
+    slot->due_ns = chip->dev->time_ns + chip->cfg.loopback_delay_ns;
+    chip->lb_slot_count++;
+    return 1;
+}
+
+// Invalidate cache for the TX data the CHIP is about to read (from HOST's writes),
+// only for what the HOST published since the last doorbell the CHIP observed
+static void chip_tx_observe(struct chip_emulator *chip, uint32_t host_tx_head_pub) {
+    if (host_tx_head_pub != chip->tx_seen_head) {
+        dcache_ring_range(chip_dcache_invalidate_range, &chip->dev->cache, TX_BUFFER_START_ADDR, TX_BUFFER_SIZE,
+                          chip->tx_seen_head, tx_ring_used(host_tx_head_pub, chip->tx_seen_head));
+        chip->tx_seen_head = host_tx_head_pub;
+    }
+    BARRIER_RING_OBSERVE();
+}
+
+// --- TX Completions ---
+static int chip_tx_compl_enabled(struct chip_emulator *chip) {
+    return (BUS_READ_REG(chip->regs, CHIP_REG_TX_COMPL_CTRL) & CHIP_TX_COMPL_CTRL_ENABLE) != 0;
+}
+
+static int chip_tx_compl_full(struct chip_emulator *chip) {
+    return chip->tx_compl_head - BUS_READ_REG(chip->regs, CHIP_REG_HOST_TX_COMPL_TAIL_PUB) >= TX_COMPL_RING_ENTRIES;
+}
+
+// Reports the frame just consumed, with the cookie the HOST left in its table slot
+static void chip_tx_complete(struct chip_emulator *chip, uint32_t len) {
+    uint32_t slot = chip->tx_compl_head & (TX_COMPL_RING_ENTRIES - 1);
+    chip_dcache_invalidate_range(&chip->dev->cache, TX_COMPL_COOKIE_START_ADDR + slot * 4, 4);
+    cache_sim_ring_access(&chip->dev->cache, CACHE_SIM_CHIP, TX_COMPL_COOKIE_START_ADDR, TX_COMPL_COOKIE_SIZE,
+                          slot * 4, 4, 0);
+
+    struct tx_completion *c = &chip->tx_compl_ring[slot];
+    c->cookie = chip->tx_compl_cookies[slot];
+    c->len = (uint16_t)len;
+    c->status = TX_COMPL_STATUS_OK;
+    c->done_ns = chip->dev->time_ns;
+    cache_sim_ring_access(&chip->dev->cache, CACHE_SIM_CHIP, TX_COMPL_RING_START_ADDR, TX_COMPL_RING_SIZE,
+                          slot * TX_COMPL_ENTRY_SIZE, TX_COMPL_ENTRY_SIZE, 1);
+    chip_dcache_clean_range(&chip->dev->cache, TX_COMPL_RING_START_ADDR + slot * TX_COMPL_ENTRY_SIZE,
+                            TX_COMPL_ENTRY_SIZE);
+
+    chip->tx_compl_head++;
+    BARRIER_RING_PUBLISH();
+    BUS_WRITE_REG(chip->regs, CHIP_REG_TX_COMPL_HEAD, chip->tx_compl_head);
+    BARRIER_DOORBELL();
+    SIM_LOG("CHIP_EMU_TX: Completed packet. Cookie: %u.\n", c->cookie);
+    chip_raise_interrupt(chip, CHIP_INT_TX_COMPLETE_BIT);
+}
+
+// --- TX Segmentation Offload ---
+// Reads the TSO descriptor behind the marker at off
+static struct tx_tso_desc chip_tso_desc(struct chip_emulator *chip, uint32_t off) {
+    struct tx_tso_desc d;
+    tx_ring_read(chip->tx_ring, tx_ring_wrap(off + PACKET_LENGTH_FIELD_SIZE), &d, sizeof(d));
+    return d;
+}
+
+static uint32_t chip_tso_segments(const struct tx_tso_desc *d) {
+    return (d->len - d->p.hdr_len + d->p.mss - 1) / d->p.mss;
+}
+
+// Builds the segment carrying payload bytes [done, done + mss) of the super-frame at
+// frame_off in tso_seg; returns its length
+static uint32_t chip_tso_build(struct chip_emulator *chip, uint32_t frame_off, const struct tx_tso_desc *d,
+                               uint32_t done) {
+    uint32_t hdr_len = d->p.hdr_len;
+    uint32_t n = d->len - hdr_len - done;
+    if (n > d->p.mss) {
+        n = d->p.mss;
+    }
+    uint8_t *seg = chip->tso_seg;
+    tx_ring_read(chip->tx_ring, frame_off, seg, hdr_len);
+    tx_ring_read(chip->tx_ring, tx_ring_wrap(frame_off + hdr_len + done), seg + hdr_len, n);
+
+    if (d->p.seq_off != TX_TSO_NO_FIELD) {
+        uint8_t *p = seg + d->p.seq_off;
+        uint32_t seq = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        seq += done;
+        p[0] = (uint8_t)(seq >> 24);
+        p[1] = (uint8_t)(seq >> 16);
+        p[2] = (uint8_t)(seq >> 8);
+        p[3] = (uint8_t)seq;
+    }
+    if (d->p.len_off != TX_TSO_NO_FIELD) {
+        uint32_t field = hdr_len + n - d->p.len_adj;
+        seg[d->p.len_off] = (uint8_t)(field >> 8);
+        seg[d->p.len_off + 1] = (uint8_t)field;
+    }
+    return hdr_len + n;
+}
+
+// Sends the remaining segments of the super-frame at frame_off; returns 0 if the
+// loopback FIFO filled up first (the next call continues where this one stopped)
+static int chip_tso_send(struct chip_emulator *chip, uint32_t frame_off, const struct tx_tso_desc *d) {
+    uint32_t payload_len = d->len - d->p.hdr_len;
+    while (chip->tso_done < payload_len) {
+        uint32_t seg_len = chip_tso_build(chip, frame_off, d, chip->tso_done);
+        if (chip->cfg.loopback && !chip_loopback_accept(chip, chip->tso_seg, seg_len, chip->tso_seg + seg_len, 0)) {
+            return 0;
+        }
+        if (chip->tx_sink != NULL) {
+            chip->tx_sink(chip->tx_sink_ctx, chip->tso_seg, seg_len, chip->tso_seg + seg_len, 0);
+        }
+        chip->tso_done += seg_len - d->p.hdr_len;
+        chip->tso.segments++;
+    }
+    SIM_LOG("CHIP_EMU_TX: Segmented super-frame. Len: %u, MSS: %u, %u segments.\n",
+            d->len, d->p.mss, chip_tso_segments(d));
+    chip->tso_done = 0;
+    chip->tso.superframes++;
+    return 1;
 }
 
 // --- Simulate CHIP's TX processing (reading from shared memory) ---
-void chip_emulator_process_tx() {
+void chip_emulator_process_tx(struct chip_emulator *chip) {
     // CHIP reads HOST's published TX head pointer
-    uint32_t host_tx_head_pub = BUS_READ_REG(CHIP_REG_HOST_TX_HEAD_PUB);
+    uint32_t host_tx_head_pub = BUS_READ_REG(chip->regs, CHIP_REG_HOST_TX_HEAD_PUB);
 
     // Calculate data available for CHIP to process
-    uint32_t data_available;
-    if (host_tx_head_pub >= chip_tx_tail) {
-        data_available = host_tx_head_pub - chip_tx_tail;
-    } else {
-        data_available = TX_BUFFER_SIZE - chip_tx_tail + host_tx_head_pub;
-    }
+    uint32_t data_available = tx_ring_used(host_tx_head_pub, chip->tx_tail);
 
     if (data_available > 0) {
-        // Invalidate cache for the data it's about to read (from HOST's writes)
-        mock_dcache_invalidate_range((uintptr_t)tx_buffer_ptr, TX_BUFFER_SIZE); // Simplified for whole buffer
-        DMB();
+        chip_tx_observe(chip, host_tx_head_pub);
 
         // Simulate processing a packet
         // First, read the length header
@@ -54,133 +282,531 @@ void chip_emulator_process_tx() {
             return;
         }
 
-        uint16_t packet_payload_len;
-        uint32_t header_offset = chip_tx_tail;
-
-        if ((header_offset + PACKET_LENGTH_FIELD_SIZE) > TX_BUFFER_SIZE) {
-            uint8_t byte0 = tx_buffer_ptr[header_offset];
-            uint8_t byte1 = tx_buffer_ptr[0];
-            packet_payload_len = (uint16_t)byte0 | ((uint16_t)byte1 << 8);
-        } else {
-            packet_payload_len = *(uint16_t*)(tx_buffer_ptr + header_offset);
+        uint16_t packet_payload_len = tx_ring_read_len16(chip->tx_ring, chip->tx_tail);
+        uint32_t record_hdr_len = PACKET_LENGTH_FIELD_SIZE;
+        struct tx_tso_desc tso;
+        int is_tso = (packet_payload_len == TX_LEN_TSO);
+        if (is_tso) {
+            if (data_available < TX_TSO_RECORD_OVERHEAD) {
+                return;
+            }
+            tso = chip_tso_desc(chip, chip->tx_tail);
+            packet_payload_len = tso.len;
+            record_hdr_len = TX_TSO_RECORD_OVERHEAD;
         }
-
-        uint32_t total_packet_len = packet_payload_len + PACKET_LENGTH_FIELD_SIZE;
+        uint32_t total_packet_len = packet_payload_len + record_hdr_len;
 
         if (data_available < total_packet_len) {
             // Not a full packet yet, wait
             return;
         }
 
-        printf("CHIP_EMU_TX: Processing packet from HOST. Len: %u. First byte: 0x%02x\n",
-               packet_payload_len, tx_buffer_ptr[(chip_tx_tail + PACKET_LENGTH_FIELD_SIZE) % TX_BUFFER_SIZE]);
+        // With TX completions the frame only leaves once its completion has a slot
+        int tx_compl = chip_tx_compl_enabled(chip);
+        if (tx_compl && chip_tx_compl_full(chip)) {
+            return;
+        }
+
+        uint32_t payload_off = tx_ring_wrap(chip->tx_tail + record_hdr_len);
+        if (is_tso) {
+            // Segments go out one by one; in loopback the super-frame stays until all have
+            if (!chip_tso_send(chip, payload_off, &tso)) {
+                return;
+            }
+        } else {
+            uint32_t first = tx_ring_contig(payload_off, packet_payload_len);
+
+            // In loopback the frame is only consumed once the CHIP can hold a copy
+            if (chip->cfg.loopback &&
+                !chip_loopback_accept(chip, chip->tx_ring + payload_off, first, chip->tx_ring, packet_payload_len - first)) {
+                return;
+            }
+
+            SIM_LOG("CHIP_EMU_TX: Processing packet from HOST. Len: %u. First byte: 0x%02x\n",
+                   packet_payload_len, chip->tx_ring[payload_off]);
+
+            // Hand the frame to whatever sits behind the air interface
+            if (chip->tx_sink != NULL) {
+                chip->tx_sink(chip->tx_sink_ctx, chip->tx_ring + payload_off, first, chip->tx_ring, packet_payload_len - first);
+            }
+        }
+
+        // Modelled once the frame is consumed, not on every cycle it has to wait
+        cache_sim_ring_access(&chip->dev->cache, CACHE_SIM_CHIP, TX_BUFFER_START_ADDR, TX_BUFFER_SIZE, chip->tx_tail, total_packet_len, 0);
 
         // Simulate internal CHIP processing and transmission
         // Advance CHIP's local Tx tail pointer
-        chip_tx_tail = (chip_tx_tail + total_packet_len) % TX_BUFFER_SIZE;
+        chip->tx_tail = tx_ring_wrap(chip->tx_tail + total_packet_len);
 
         // Publish updated Tx tail pointer to HOST via simulated register
-        DMB(); // Ensure data processing is conceptually complete
-        BUS_WRITE_REG(CHIP_REG_TX_TAIL_PTR, chip_tx_tail);
-        DSB();
-
-        // If enough space is freed, raise TX_SPACE_AVAIL_BIT interrupt
-        uint32_t space_freed;
-        if (chip_tx_tail >= host_tx_head_pub) { // This comparison is for the HOST's current view
-            space_freed = TX_BUFFER_SIZE - (chip_tx_tail - host_tx_head_pub);
-        } else {
-            space_freed = host_tx_head_pub - chip_tx_tail;
+        BARRIER_RING_RELEASE(); // Ensure data processing is conceptually complete
+        BUS_WRITE_REG(chip->regs, CHIP_REG_TX_TAIL_PTR, chip->tx_tail);
+        BARRIER_DOORBELL();
+
+        if (tx_compl) {
+            chip_tx_complete(chip, packet_payload_len);
         }
 
+        // If enough space is freed (as seen from the HOST's last published head), raise TX_SPACE_AVAIL_BIT interrupt
+        uint32_t space_freed = tx_ring_free(host_tx_head_pub, chip->tx_tail);
+
         if (space_freed >= TX_LOW_WATERMARK_THRESHOLD) {
-             chip_raise_interrupt(CHIP_INT_TX_SPACE_AVAIL_BIT);
+             chip_raise_interrupt(chip, CHIP_INT_TX_SPACE_AVAIL_BIT);
         }
 
     }
 }
 
-// --- Simulate CHIP's RX generation (writing to shared memory) ---
-void chip_emulator_generate_rx() {
-    // CHIP reads HOST's published RX tail pointer
-    uint32_t host_rx_tail_pub = BUS_READ_REG(CHIP_REG_HOST_RX_TAIL_PUB);
+// --- RX Drop Accounting ---
+// Counts a lost frame where the HOST can see it (CHIP_REG_RX_DROP_COUNT)
+static void chip_rx_count_drop(struct chip_emulator *chip) {
+    chip->rx.dropped++;
+    BUS_WRITE_REG(chip->regs, CHIP_REG_RX_DROP_COUNT, BUS_READ_REG(chip->regs, CHIP_REG_RX_DROP_COUNT) + 1);
+}
 
-    // Calculate space available for CHIP to write
-    uint32_t space_available;
-    if (chip_rx_head >= host_rx_tail_pub) {
-        space_available = RX_BUFFER_SIZE - (chip_rx_head - host_rx_tail_pub) - 1; // -1 to distinguish full/empty
-    } else {
-        space_available = (host_rx_tail_pub - chip_rx_head) - 1; // -1 to distinguish full/empty
+// --- CHIP RX Header Split ---
+// Header bytes per entry while header split is enabled, else 0
+static uint32_t chip_rx_split_hdr_len(struct chip_emulator *chip) {
+    uint32_t ctrl = BUS_READ_REG(chip->regs, CHIP_REG_RX_SPLIT_CTRL);
+    if ((ctrl & CHIP_RX_SPLIT_CTRL_ENABLE) == 0) {
+        return 0;
     }
+    uint32_t hdr_len = (ctrl >> CHIP_RX_SPLIT_CTRL_HDR_SHIFT) & 0xFF;
+    return (hdr_len == 0 || hdr_len > RX_SPLIT_HDR_MAX) ? RX_SPLIT_HDR_MAX : hdr_len;
+}
 
-    // Simulate receiving a packet (e.g., random size)
-    uint32_t simulated_payload_len = (rand() % 100) + 10; // Random length between 10 and 109 bytes
-    uint32_t total_packet_len = simulated_payload_len + PACKET_LENGTH_FIELD_SIZE;
+// Whether a frame of len bytes fits: a free header entry, and a fill ring buffer
+// unless the whole frame fits in the header
+static int chip_rx_split_reserve(struct chip_emulator *chip, uint32_t len, uint32_t hdr_len) {
+    if (len > hdr_len + RX_SPLIT_BUF_SIZE ||
+        chip->rx_split_head - BUS_READ_REG(chip->regs, CHIP_REG_HOST_RX_SPLIT_TAIL_PUB) >= RX_SPLIT_ENTRIES) {
+        return -1;
+    }
+    if (len > hdr_len && BUS_READ_REG(chip->regs, CHIP_REG_HOST_RX_FILL_HEAD_PUB) == chip->rx_fill_tail) {
+        return -1;
+    }
+    return 0;
+}
+
+// Splits the frame staged in rx_stage into a header entry and a pool buffer and
+// publishes the entry
+static void chip_rx_split_commit(struct chip_emulator *chip, uint32_t len, uint32_t hdr_len, const char *what) {
+    uint32_t slot = chip->rx_split_head & (RX_SPLIT_ENTRIES - 1);
+    struct rx_split_entry *e = &chip->rx_split_ring[slot];
+    if (hdr_len > len) {
+        hdr_len = len;
+    }
+
+    uint16_t buf = RX_SPLIT_NO_BUF;
+    if (len > hdr_len) {
+        // Take the next free buffer from the fill ring
+        uint32_t fill_slot = chip->rx_fill_tail & (RX_SPLIT_BUFS - 1);
+        chip_dcache_invalidate_range(&chip->dev->cache, RX_SPLIT_FILL_START_ADDR + fill_slot * 2, 2);
+        cache_sim_ring_access(&chip->dev->cache, CACHE_SIM_CHIP, RX_SPLIT_FILL_START_ADDR, RX_SPLIT_FILL_SIZE,
+                              fill_slot * 2, 2, 0);
+        buf = chip->rx_split_fill[fill_slot];
+        chip->rx_fill_tail++;
+        if (buf >= RX_SPLIT_BUFS) {
+            // Not a pool buffer: lose the frame rather than write outside the pool
+            chip_rx_count_drop(chip);
+            SIM_LOG("CHIP_EMU_RX: Bad fill buffer %u, dropped packet. Len: %u.\n", buf, len);
+            chip_raise_interrupt(chip, CHIP_INT_ERROR_BIT);
+            return;
+        }
+
+        uint32_t payload_len = len - hdr_len;
+        memcpy(chip->rx_split_pool + (uint32_t)buf * RX_SPLIT_BUF_SIZE, chip->rx_stage + hdr_len, payload_len);
+        cache_sim_ring_access(&chip->dev->cache, CACHE_SIM_CHIP, RX_SPLIT_POOL_START_ADDR, RX_SPLIT_POOL_SIZE,
+                              (uint32_t)buf * RX_SPLIT_BUF_SIZE, payload_len, 1);
+        chip_dcache_clean_range(&chip->dev->cache, RX_SPLIT_POOL_START_ADDR + (uint32_t)buf * RX_SPLIT_BUF_SIZE,
+                                payload_len);
+    }
+
+    e->len = (uint16_t)len;
+    e->hdr_len = (uint16_t)hdr_len;
+    e->buf = buf;
+    e->reserved = 0;
+    memcpy(e->hdr, chip->rx_stage, hdr_len);
+    cache_sim_ring_access(&chip->dev->cache, CACHE_SIM_CHIP, RX_SPLIT_RING_START_ADDR, RX_SPLIT_RING_SIZE,
+                          slot * RX_SPLIT_ENTRY_SIZE, RX_SPLIT_ENTRY_SIZE, 1);
+    chip_dcache_clean_range(&chip->dev->cache, RX_SPLIT_RING_START_ADDR + slot * RX_SPLIT_ENTRY_SIZE,
+                            RX_SPLIT_ENTRY_SIZE);
+
+    chip->rx_split_head++;
+    BARRIER_RING_PUBLISH();
+    BUS_WRITE_REG(chip->regs, CHIP_REG_RX_SPLIT_HEAD, chip->rx_split_head);
+    BARRIER_DOORBELL();
+
+    SIM_LOG("CHIP_EMU_RX: %s packet (split). Len: %u. Hdr: %u. Buf: %u.\n", what, len, hdr_len, buf);
+
+    if (chip->rx_split_head - BUS_READ_REG(chip->regs, CHIP_REG_HOST_RX_SPLIT_TAIL_PUB) >= RX_SPLIT_HIGH_WATERMARK) {
+        chip_raise_interrupt(chip, CHIP_INT_RX_DATA_READY_BIT);
+    }
+}
 
-    if (space_available < total_packet_len) {
+// --- CHIP RX Ring Writes ---
+// Reserves room for a frame of len payload bytes at the CHIP's RX head and writes its
+// length header. Returns 0 and the offset in chip->rx_dst to write the payload at, or
+// -1 if the frame does not fit. With header split the frame is staged in rx_stage.
+static int chip_rx_reserve(struct chip_emulator *chip, uint32_t len, uint32_t *payload_off) {
+    uint32_t hdr_len = chip_rx_split_hdr_len(chip);
+    if (hdr_len != 0) {
+        if (len > RX_BUFFER_SIZE || chip_rx_split_reserve(chip, len, hdr_len) != 0) {
+            return -1;
+        }
+        chip->rx_dst = chip->rx_stage;
+        *payload_off = 0;
+        return 0;
+    }
+
+    // CHIP reads HOST's published RX tail pointer
+    uint32_t host_rx_tail_pub = BUS_READ_REG(chip->regs, CHIP_REG_HOST_RX_TAIL_PUB);
+
+    // Calculate space available for CHIP to write (one byte kept free to distinguish full/empty)
+    uint32_t space_available = rx_ring_free(chip->rx_head, host_rx_tail_pub);
+
+    if (space_available < len + PACKET_LENGTH_FIELD_SIZE) {
         // No space to write a full packet
-        return;
+        return -1;
     }
 
     // --- Write Length Header ---
-    uint16_t len_header = (uint16_t)simulated_payload_len;
-    uint32_t current_offset = chip_rx_head;
+    chip->rx_dst = chip->rx_ring;
+    *payload_off = rx_ring_write_len16(chip->rx_ring, chip->rx_head, (uint16_t)len);
+    return 0;
+}
+
+// Publishes the frame reserved and filled at the RX head to the HOST; what names its
+// origin in the trace
+static void chip_rx_commit(struct chip_emulator *chip, uint32_t len, const char *what) {
+    if (chip->rx_dst == chip->rx_stage) {
+        chip_rx_split_commit(chip, len, chip_rx_split_hdr_len(chip), what);
+        return;
+    }
 
-    *(uint16_t*)(rx_buffer_ptr + current_offset) = len_header;
-    current_offset = (current_offset + PACKET_LENGTH_FIELD_SIZE) % RX_BUFFER_SIZE;
+    uint32_t start_offset = chip->rx_head;
+    uint32_t total_packet_len = len + PACKET_LENGTH_FIELD_SIZE;
+
+    cache_sim_ring_access(&chip->dev->cache, CACHE_SIM_CHIP, RX_BUFFER_START_ADDR, RX_BUFFER_SIZE, start_offset, total_packet_len, 1);
+
+    // Update CHIP's local Rx head pointer
+    chip->rx_head = rx_ring_wrap(start_offset + total_packet_len);
+
+    // Ensure all writes to shared RAM are complete
+    BARRIER_RING_PUBLISH();
+    dcache_ring_range(chip_dcache_clean_range, &chip->dev->cache, RX_BUFFER_START_ADDR, RX_BUFFER_SIZE, start_offset, total_packet_len);
+
+    // Publish updated Rx head pointer to HOST via simulated register
+    BUS_WRITE_REG(chip->regs, CHIP_REG_RX_HEAD_PTR, chip->rx_head);
+    BARRIER_DOORBELL();
+
+    SIM_LOG("CHIP_EMU_RX: %s packet. Len: %u. New Head: %u.\n", what, len, chip->rx_head);
+
+    // If enough data is available (since HOST's last consumed position), raise RX_DATA_READY_BIT interrupt
+    uint32_t data_written = rx_ring_used(chip->rx_head, BUS_READ_REG(chip->regs, CHIP_REG_HOST_RX_TAIL_PUB));
+
+    if (data_written >= RX_HIGH_WATERMARK_THRESHOLD) {
+        chip_raise_interrupt(chip, CHIP_INT_RX_DATA_READY_BIT);
+    }
+}
+
+// --- RX Overflow ---
+// Drops a frame that found no room in the ring
+static void chip_rx_drop(struct chip_emulator *chip, uint32_t len) {
+    chip_rx_count_drop(chip);
+    SIM_LOG("CHIP_EMU_RX: Ring full, dropped packet. Len: %u.\n", len);
+    chip_raise_interrupt(chip, CHIP_INT_RX_OVERFLOW_BIT);
+}
+
+// Holds arrival seq of len bytes in the overflow FIFO; returns -1 if full
+static int chip_rx_fifo_hold(struct chip_emulator *chip, uint32_t len, uint64_t seq) {
+    if (chip->rx_fifo_count == chip->cfg.rx_fifo_frames ||
+        ring_free(chip->rx_fifo_head, chip->rx_fifo_tail, CHIP_RX_FIFO_SIZE) < len) {
+        return -1;
+    }
+    chip_rx_fill(chip, chip->rx_fifo, CHIP_RX_FIFO_SIZE, chip->rx_fifo_head, len, seq);
+    chip->rx_fifo_head = ring_wrap(chip->rx_fifo_head + len, CHIP_RX_FIFO_SIZE);
+    chip->rx_fifo_len[(chip->rx_fifo_first + chip->rx_fifo_count) % CHIP_RX_FIFO_SLOTS] = (uint16_t)len;
+    chip->rx_fifo_count++;
+    chip->rx.held++;
+    if (chip->rx_fifo_count > chip->rx.fifo_peak) {
+        chip->rx.fifo_peak = chip->rx_fifo_count;
+    }
+    return 0;
+}
+
+// Moves held frames into the RX ring, oldest first, as far as the HOST made room
+static void chip_rx_fifo_drain(struct chip_emulator *chip) {
+    while (chip->rx_fifo_count > 0) {
+        uint32_t len = chip->rx_fifo_len[chip->rx_fifo_first];
+        uint32_t payload_off;
+        if (chip_rx_reserve(chip, len, &payload_off) != 0) {
+            return;
+        }
+
+        uint32_t first = ring_contig(chip->rx_fifo_tail, len, CHIP_RX_FIFO_SIZE);
+        payload_off = rx_ring_write(chip->rx_dst, payload_off, chip->rx_fifo + chip->rx_fifo_tail, first);
+        rx_ring_write(chip->rx_dst, payload_off, chip->rx_fifo, len - first);
+        chip->rx_fifo_tail = ring_wrap(chip->rx_fifo_tail + len, CHIP_RX_FIFO_SIZE);
+
+        chip_rx_commit(chip, len, "Released held");
+
+        chip->rx_fifo_first = (chip->rx_fifo_first + 1) % CHIP_RX_FIFO_SLOTS;
+        chip->rx_fifo_count--;
+    }
+}
+
+// --- Simulate CHIP's RX generation (writing to shared memory) ---
+void chip_emulator_generate_rx(struct chip_emulator *chip) {
+    // Simulate receiving a packet (e.g., random size)
+    uint32_t simulated_payload_len = (chip_rand(chip) % (CHIP_RX_GEN_MAX_LEN - CHIP_RX_GEN_MIN_LEN + 1)) +
+                                     CHIP_RX_GEN_MIN_LEN;
+    uint32_t current_offset;
+    uint64_t seq = chip->rx.arrived++;
+    if (chip->cfg.rx_overflow == CHIP_RX_OVERFLOW_FIFO) {
+        // Held frames go first, so a frame only bypasses the FIFO while it is empty
+        chip_rx_fifo_drain(chip);
+        if (chip->rx_fifo_count > 0 || chip_rx_reserve(chip, simulated_payload_len, &current_offset) != 0) {
+            if (chip_rx_fifo_hold(chip, simulated_payload_len, seq) != 0) {
+                chip_rx_drop(chip, simulated_payload_len);
+            }
+            return;
+        }
+    } else if (chip_rx_reserve(chip, simulated_payload_len, &current_offset) != 0) {
+        chip_rx_drop(chip, simulated_payload_len);
+        return;
+    }
 
     // --- Write Packet Payload ---
-    if ((current_offset + simulated_payload_len) > RX_BUFFER_SIZE) {
-        uint32_t first_part_len = RX_BUFFER_SIZE - current_offset;
-        // Fill with dummy data (simulate received CHIP data)
-        for (uint32_t i = 0; i < first_part_len; i++) {
-            rx_buffer_ptr[current_offset + i] = (uint8_t)(rand() % 256);
+    // Fill with dummy data (simulate received CHIP data)
+    chip_rx_fill(chip, chip->rx_dst, RX_BUFFER_SIZE, current_offset, simulated_payload_len, seq);
+
+    chip_rx_commit(chip, simulated_payload_len, "Generated");
+}
+
+// --- External RX Injection ---
+int chip_emulator_inject_rx(struct chip_emulator *chip, const uint8_t *data, uint32_t len) {
+    uint32_t payload_off;
+    if (len > UINT16_MAX || chip_rx_reserve(chip, len, &payload_off) != 0) {
+        return -1;
+    }
+    rx_ring_write(chip->rx_dst, payload_off, data, len);
+    chip_rx_commit(chip, len, "Injected");
+    return 0;
+}
+
+// --- Loopback Delivery ---
+void chip_emulator_process_loopback(struct chip_emulator *chip) {
+    while (chip->lb_slot_count > 0) {
+        const struct chip_loopback_slot *slot = &chip->lb_slots[chip->lb_slot_first];
+        uint32_t payload_off;
+        if (slot->due_ns > chip->dev->time_ns || chip_rx_reserve(chip, slot->len, &payload_off) != 0) {
+            return; // Not due yet, or the HOST has not made room
         }
-        for (uint32_t i = 0; i < (simulated_payload_len - first_part_len); i++) {
-            rx_buffer_ptr[i] = (uint8_t)(rand() % 256);
+
+        uint32_t first = ring_contig(chip->lb_tail, slot->len, CHIP_LOOPBACK_FIFO_SIZE);
+        payload_off = rx_ring_write(chip->rx_dst, payload_off, chip->lb_fifo + chip->lb_tail, first);
+        rx_ring_write(chip->rx_dst, payload_off, chip->lb_fifo, slot->len - first);
+        chip->lb_tail = ring_wrap(chip->lb_tail + slot->len, CHIP_LOOPBACK_FIFO_SIZE);
+
+        chip_rx_commit(chip, slot->len, "Looped back");
+
+        chip->lb_slot_first = (chip->lb_slot_first + 1) % CHIP_LOOPBACK_SLOTS;
+        chip->lb_slot_count--;
+        chip->lb_frames++;
+    }
+}
+
+// --- TX Airtime Pacing ---
+// Counts the published frames at the TX tail that fit into one A-MPDU. A super-frame
+// counts as one frame here (it leaves the ring whole) and as its segments in *mpdus;
+// it is never split across A-MPDUs.
+static uint32_t chip_phy_aggregate(struct chip_emulator *chip, uint32_t *psdu_len, uint32_t *mpdus) {
+    const struct phy_config *phy = &chip->cfg.phy;
+    uint32_t host_tx_head_pub = BUS_READ_REG(chip->regs, CHIP_REG_HOST_TX_HEAD_PUB);
+    uint32_t off = chip->tx_tail;
+    uint32_t avail = tx_ring_used(host_tx_head_pub, off);
+    uint32_t frames = 0;
+
+    *psdu_len = 0;
+    *mpdus = 0;
+    if (avail == 0) {
+        return 0;
+    }
+    chip_tx_observe(chip, host_tx_head_pub);
+
+    while (*mpdus < phy->ampdu_max_frames && avail >= PACKET_LENGTH_FIELD_SIZE) {
+        cache_sim_ring_access(&chip->dev->cache, CACHE_SIM_CHIP, TX_BUFFER_START_ADDR, TX_BUFFER_SIZE, off, PACKET_LENGTH_FIELD_SIZE, 0);
+        uint32_t payload_len = tx_ring_read_len16(chip->tx_ring, off);
+        uint32_t total_packet_len = payload_len + PACKET_LENGTH_FIELD_SIZE;
+        uint32_t segs = 1;
+        uint32_t len = *psdu_len;
+        if (payload_len == TX_LEN_TSO) {
+            if (avail < TX_TSO_RECORD_OVERHEAD) {
+                break;
+            }
+            struct tx_tso_desc d = chip_tso_desc(chip, off);
+            total_packet_len = d.len + TX_TSO_RECORD_OVERHEAD;
+            segs = chip_tso_segments(&d);
+            uint32_t last = d.len - d.p.hdr_len - (segs - 1) * d.p.mss;
+            len += (segs - 1) * phy_mpdu_len(d.p.hdr_len + d.p.mss) + phy_mpdu_len(d.p.hdr_len + last);
+        } else {
+            len += phy_mpdu_len(payload_len);
         }
-    } else {
-        for (uint32_t i = 0; i < simulated_payload_len; i++) {
-            rx_buffer_ptr[current_offset + i] = (uint8_t)(rand() % 256);
+        if (avail < total_packet_len) {
+            break;
+        }
+        // The first frame always goes out, even if it alone exceeds the limits
+        if (frames > 0 && (*mpdus + segs > phy->ampdu_max_frames || len > phy->ampdu_max_bytes ||
+                           phy_ppdu_ns(phy, len) > PHY_MAX_PPDU_NS)) {
+            break;
         }
+        *psdu_len = len;
+        *mpdus += segs;
+        frames++;
+        off = tx_ring_wrap(off + total_packet_len);
+        avail -= total_packet_len;
     }
+    return frames;
+}
 
-    // Update CHIP's local Rx head pointer
-    chip_rx_head = (chip_rx_head + total_packet_len) % RX_BUFFER_SIZE;
+// Replaces chip_emulator_process_tx() in the cycle when airtime pacing is enabled
+static void chip_phy_step(struct chip_emulator *chip) {
+    const struct phy_config *phy = &chip->cfg.phy;
+    uint64_t now = chip->dev->time_ns;
 
-    // Ensure all writes to shared RAM are complete
-    DMB();
-    mock_dcache_clean_range((uintptr_t)rx_buffer_ptr + ((current_offset - (PACKET_LENGTH_FIELD_SIZE + simulated_payload_len) + RX_BUFFER_SIZE) % RX_BUFFER_SIZE), total_packet_len);
+    if (chip->phy_frames > 0) {
+        if (now < chip->phy_done_ns) {
+            return; // Exchange still in progress
+        }
+        // BlockAck received: the frames leave the ring
+        while (chip->phy_frames > 0) {
+            uint32_t tail = chip->tx_tail;
+            chip_emulator_process_tx(chip);
+            if (chip->tx_tail == tail) {
+                // Loopback FIFO or completion ring full: retry next cycle, unless the frames are gone
+                if (BUS_READ_REG(chip->regs, CHIP_REG_HOST_TX_HEAD_PUB) == tail) {
+                    chip->phy_frames = 0;
+                }
+                return;
+            }
+            chip->phy_frames--;
+        }
+    }
 
-    // Publish updated Rx head pointer to HOST via simulated register
-    BUS_WRITE_REG(CHIP_REG_RX_HEAD_PTR, chip_rx_head);
-    DSB();
+    uint32_t psdu_len;
+    uint32_t mpdus;
+    uint32_t frames = chip_phy_aggregate(chip, &psdu_len, &mpdus);
+    if (frames == 0) {
+        return;
+    }
 
-    printf("CHIP_EMU_RX: Generated packet. Len: %u. New Head: %u.\n", simulated_payload_len, chip_rx_head);
+    uint32_t backoff = chip_rand(chip) % (phy->cw_min + 1);
+    uint64_t airtime = phy_ppdu_ns(phy, psdu_len);
+    uint64_t busy = phy_contention_ns(phy, backoff) + airtime + phy_ack_ns(mpdus);
+    chip->phy_frames = frames;
+    chip->phy_done_ns = now + busy;
+    chip->phy.ppdus++;
+    chip->phy.mpdus += mpdus;
+    chip->phy.psdu_bytes += psdu_len;
+    chip->phy.airtime_ns += airtime;
+    chip->phy.busy_ns += busy;
+    SIM_LOG("CHIP_EMU_PHY: A-MPDU of %u frames, %u bytes, %llu ns on air.\n", mpdus, psdu_len,
+            (unsigned long long)airtime);
+}
 
-    // If enough data is available, raise RX_DATA_READY_BIT interrupt
-    uint32_t data_written;
-    if (chip_rx_head >= host_rx_tail_pub) { // This comparison is for HOST's last consumed position
-        data_written = chip_rx_head - host_rx_tail_pub;
-    } else {
-        data_written = RX_BUFFER_SIZE - host_rx_tail_pub + chip_rx_head;
-    }
+// --- Idle / Power-Save State Machine ---
+// Work is anything the CHIP would have to stay awake for: TX frames the HOST has
+// published, RX frames the HOST has not consumed yet, or frames in the loopback FIFO.
+static int chip_has_work(struct chip_emulator *chip) {
+    return BUS_READ_REG(chip->regs, CHIP_REG_HOST_TX_HEAD_PUB) != chip->tx_tail ||
+           BUS_READ_REG(chip->regs, CHIP_REG_HOST_RX_TAIL_PUB) != chip->rx_head ||
+           BUS_READ_REG(chip->regs, CHIP_REG_HOST_RX_SPLIT_TAIL_PUB) != chip->rx_split_head ||
+           chip->lb_slot_count > 0 || chip->rx_fifo_count > 0;
+}
 
-    if (data_written >= RX_HIGH_WATERMARK_THRESHOLD) {
-        chip_raise_interrupt(CHIP_INT_RX_DATA_READY_BIT);
+// Advances the power state by one cycle; returns 1 if the CHIP may run this cycle
+static int chip_power_step(struct chip_emulator *chip) {
+    const struct chip_idle_config *idle = &chip->cfg.idle;
+    uint64_t now = chip->dev->time_ns;
+
+    // The doorbell logic latches every HEAD_PUB write, asleep or not
+    uint32_t doorbell = BUS_READ_REG(chip->regs, CHIP_REG_HOST_TX_HEAD_PUB);
+    int rang = (doorbell != chip->doorbell_seen);
+    chip->doorbell_seen = doorbell;
+
+    if (idle->enabled) {
+        switch (chip->pwr_state) {
+        case CHIP_PWR_ACTIVE:
+            if (!chip_has_work(chip)) {
+                chip->pwr_state = CHIP_PWR_IDLE_PENDING;
+                chip->pwr_deadline = now + idle->entry_delay_ns;
+            }
+            break;
+        case CHIP_PWR_IDLE_PENDING:
+            if (chip_has_work(chip)) {
+                chip->pwr_state = CHIP_PWR_ACTIVE;
+            } else if (now >= chip->pwr_deadline) {
+                chip->pwr_state = CHIP_PWR_SLEEP;
+                chip->pwr_deadline = now + idle->poll_interval_ns;
+                chip->power.sleeps++;
+                SIM_LOG("CHIP_EMU: Entering sleep.\n");
+            }
+            break;
+        case CHIP_PWR_SLEEP:
+            if (rang && idle->doorbell_wake) {
+                chip->power.doorbell_wakeups++;
+            } else if (idle->poll_interval_ns != 0 && now >= chip->pwr_deadline) {
+                chip->power.poll_wakeups++;
+            } else {
+                break;
+            }
+            chip->pwr_state = CHIP_PWR_WAKING;
+            chip->pwr_deadline = now + idle->wake_latency_ns;
+            break;
+        case CHIP_PWR_WAKING:
+            if (now >= chip->pwr_deadline) {
+                chip->pwr_state = CHIP_PWR_ACTIVE;
+                SIM_LOG("CHIP_EMU: Awake.\n");
+            }
+            break;
+        default:
+            break;
+        }
     }
+
+    chip->power.residency_ns[chip->pwr_state] += CHIP_CYCLE_NS;
+    return chip->pwr_state == CHIP_PWR_ACTIVE || chip->pwr_state == CHIP_PWR_IDLE_PENDING;
 }
 
 // --- Main Emulator Loop (simulates hardware's continuous operation) ---
-void chip_emulator_run_cycle() {
+void chip_emulator_run_cycle(struct chip_emulator *chip) {
+    chip->dev->time_ns += CHIP_CYCLE_NS;
+    chip_apply_int_clear(chip);
+
+    // A sleeping or waking CHIP does not touch the rings
+    if (!chip_power_step(chip)) {
+        return;
+    }
+
     // In a real hardware IP, these would run concurrently and continuously.
     // In simulation, we call them sequentially.
 
-    // Try to process outgoing (TX) data from HOST
-    chip_emulator_process_tx();
+    // Try to process outgoing (TX) data from HOST, at the link rate if modelled
+    if (chip->cfg.phy.enabled) {
+        chip_phy_step(chip);
+    } else {
+        chip_emulator_process_tx(chip);
+    }
 
-    // Try to generate incoming (RX) data for HOST
-    // Simulate some randomness for when RX data arrives
-    if ((rand() % 10) < 5) { // 50% chance to generate RX data each cycle
-        chip_emulator_generate_rx();
+    // Try to generate incoming (RX) data for HOST: looped-back frames, or
+    // simulate some randomness for when RX data arrives
+    if (chip->cfg.loopback) {
+        chip_emulator_process_loopback(chip);
+    } else {
+        chip_rx_fifo_drain(chip); // Frames held on overflow go out first
+        if (chip->cfg.rx_gen_percent > 0 && chip_rand(chip) % 100 < chip->cfg.rx_gen_percent) {
+            chip_emulator_generate_rx(chip);
+        }
     }
 }
@@ -0,0 +1,228 @@
+#ifndef CHIP_EMULATOR_H
+#define CHIP_EMULATOR_H
+
+#include <stdint.h>
+#include "sim_device.h"
+#include "phy_model.h"
+
+// --- CHIP Idle / Power-Save Model ---
+// With idle.enabled the emulator only does work while awake. Once both rings are
+// empty it waits entry_delay_ns (IDLE_PENDING) and then sleeps. A sleeping CHIP
+// wakes on a HOST doorbell (a HEAD_PUB write, if doorbell_wake) or on its own every
+// poll_interval_ns (if non-zero), and needs wake_latency_ns before it can touch the
+// rings again. All times are virtual (the device clock, sim_device.time_ns).
+enum chip_power_state {
+    CHIP_PWR_ACTIVE,
+    CHIP_PWR_IDLE_PENDING,
+    CHIP_PWR_SLEEP,
+    CHIP_PWR_WAKING,
+    CHIP_PWR_STATES,
+};
+
+struct chip_idle_config {
+    int enabled;
+    uint32_t entry_delay_ns;   // Idle time before the CHIP goes to sleep
+    uint32_t wake_latency_ns;  // SLEEP -> ACTIVE transition time
+    uint32_t poll_interval_ns; // Self wake-up period while asleep (0 = never)
+    int doorbell_wake;         // A HOST_TX_HEAD_PUB write wakes a sleeping CHIP
+};
+
+// --- CHIP Loopback ---
+// With loopback set, every TX frame the CHIP consumes is held for loopback_delay_ns
+// (the modelled air/processing time) and then written into the RX ring instead of
+// random RX traffic. Frames wait in a CHIP-internal FIFO; when it is full the CHIP
+// stops consuming TX, and when the RX ring is full the FIFO stops draining, so the
+// HOST sees backpressure instead of loss.
+#define CHIP_LOOPBACK_FIFO_SIZE     8192U // Bytes, power of two
+_Static_assert((CHIP_LOOPBACK_FIFO_SIZE & (CHIP_LOOPBACK_FIFO_SIZE - 1)) == 0, "loopback FIFO size");
+#define CHIP_LOOPBACK_SLOTS         64    // Frames
+
+// --- CHIP RX Overflow ---
+// What happens to a frame arriving from the air while the RX ring has no room for it.
+// CHIP_RX_OVERFLOW_DROP drops it; CHIP_RX_OVERFLOW_FIFO holds it in a CHIP-internal
+// FIFO of rx_fifo_frames frames (at most CHIP_RX_FIFO_SLOTS and CHIP_RX_FIFO_SIZE
+// bytes) that drains into the ring, in order, as the HOST makes room, and drops only
+// once that is full as well. Every drop increments CHIP_REG_RX_DROP_COUNT and raises
+// CHIP_INT_RX_OVERFLOW_BIT. Looped-back and injected frames are never dropped: their
+// sources wait for room instead.
+enum chip_rx_overflow_policy {
+    CHIP_RX_OVERFLOW_DROP,
+    CHIP_RX_OVERFLOW_FIFO,
+};
+
+#define CHIP_RX_GEN_MIN_LEN         10    // Payload lengths of frames from the air
+#define CHIP_RX_GEN_MAX_LEN         109
+
+#define CHIP_RX_FIFO_SIZE           8192U // Bytes, power of two
+_Static_assert((CHIP_RX_FIFO_SIZE & (CHIP_RX_FIFO_SIZE - 1)) == 0, "RX overflow FIFO size");
+#define CHIP_RX_FIFO_SLOTS          64    // Frames
+
+// --- CHIP RX Payload Fill ---
+// How the payload of a frame arriving from the air is made up. CHIP_RX_FILL_RANDOM
+// draws every byte from the traffic generator (the reference behaviour, and by far
+// the costliest); the other modes keep generator cost out of HOST measurements.
+// NONE leaves whatever the ring held, PATTERN writes CHIP_RX_FILL_BYTE, TEMPLATE
+// copies from a random template made once at init, and SEQUENCE copies a byte ramp
+// starting at the frame's arrival number n (counting drops, from 0), so payload byte
+// i is (uint8_t)(n + i) and a consumer can check every frame and spot the lost ones.
+// VERIFY stamps each frame for frame_verify_check() (frame_verify.h) with its arrival
+// number as sequence number and cfg.seed as pattern seed.
+// Frame lengths are random in every mode, and the same for a seed across modes.
+enum chip_rx_fill {
+    CHIP_RX_FILL_RANDOM,
+    CHIP_RX_FILL_NONE,
+    CHIP_RX_FILL_PATTERN,
+    CHIP_RX_FILL_TEMPLATE,
+    CHIP_RX_FILL_SEQUENCE,
+    CHIP_RX_FILL_VERIFY,
+};
+
+#define CHIP_RX_FILL_BYTE           0xA5
+#define CHIP_RX_TEMPLATE_SIZE       2048U // Longest frame TEMPLATE/SEQUENCE/VERIFY can fill
+
+// --- CHIP TX Airtime Pacing ---
+// With phy.enabled (a valid phy_config_check() link) the CHIP no longer consumes one
+// TX frame per cycle. Whenever the medium is free it aggregates the published frames
+// at the ring tail into one A-MPDU (up to the link's frame/byte/PPDU-time limits),
+// contends for the medium, transmits and waits for the BlockAck, all in device time;
+// only then are those frames consumed and the TX tail advanced. The TX ring therefore
+// drains at the link rate and holds the frames that are queued or on the air.
+
+struct chip_emulator_config {
+    uint32_t rx_gen_percent;   // Chance per cycle that an RX frame arrives from the air
+    uint32_t seed;             // Seed of the emulator's own traffic generator (non-zero)
+    int loopback;              // Loop consumed TX frames back to RX (no random RX traffic)
+    uint32_t loopback_delay_ns;
+    struct chip_idle_config idle;
+    struct phy_config phy;
+    enum chip_rx_overflow_policy rx_overflow;
+    uint32_t rx_fifo_frames;   // CHIP_RX_OVERFLOW_FIFO depth, 1..CHIP_RX_FIFO_SLOTS
+    enum chip_rx_fill rx_fill;
+};
+
+#define CHIP_EMULATOR_DEFAULT_CONFIG { 50, 1, 0, 2000, { 0, 50000, 200000, 0, 1 }, PHY_DEFAULT_CONFIG, \
+                                       CHIP_RX_OVERFLOW_DROP, CHIP_RX_FIFO_SLOTS, CHIP_RX_FILL_RANDOM }
+
+// Receives every TX frame the CHIP consumes, in place: the payload is first_len
+// bytes at first, followed by second_len bytes at second where it wraps the ring.
+// Segments of a super-frame arrive whole in first, from a CHIP-internal buffer.
+typedef void (*chip_tx_sink_fn)(void *ctx, const uint8_t *first, uint32_t first_len,
+                                const uint8_t *second, uint32_t second_len);
+
+struct chip_loopback_slot {
+    uint32_t len;
+    uint64_t due_ns;           // Device time at which the frame may go out on RX
+};
+
+struct chip_phy_stats {
+    uint64_t ppdus;
+    uint64_t mpdus;
+    uint64_t psdu_bytes;       // A-MPDU bytes, framing included
+    uint64_t airtime_ns;       // PPDU durations
+    uint64_t busy_ns;          // Whole exchanges: contention, PPDU, SIFS, BlockAck
+};
+
+// TX segmentation offload (TX_LEN_TSO records, see shared.h). Every segment goes to
+// the TX sink, the loopback FIFO and the airtime model as a frame of its own; the
+// super-frame leaves the ring, and completes, once its last segment is out.
+struct chip_tso_stats {
+    uint64_t superframes;
+    uint64_t segments;
+};
+
+struct chip_rx_stats {
+    uint64_t arrived;          // Frames from the air (generated)
+    uint64_t dropped;          // Frames lost to overflow (CHIP_REG_RX_DROP_COUNT)
+    uint64_t held;             // Frames that went through the overflow FIFO
+    uint32_t fifo_peak;        // Most frames held at once
+};
+
+struct chip_power_stats {
+    uint64_t residency_ns[CHIP_PWR_STATES];
+    uint64_t sleeps;           // ACTIVE/IDLE_PENDING -> SLEEP transitions
+    uint64_t doorbell_wakeups;
+    uint64_t poll_wakeups;
+};
+
+// --- CHIP Emulator Instance ---
+// Internal state of one emulated CHIP, bound to the device it drives
+struct chip_emulator {
+    struct sim_device *dev;
+    uintptr_t regs;            // dev's register block
+    uint8_t *tx_ring;
+    uint8_t *rx_ring;
+    uint32_t *tx_compl_cookies;
+    struct tx_completion *tx_compl_ring;
+    struct rx_split_entry *rx_split_ring;
+    uint16_t *rx_split_fill;
+    uint8_t *rx_split_pool;
+    struct chip_emulator_config cfg;
+
+    uint32_t tx_tail;          // Where CHIP reads from shared Tx buffer
+    uint32_t rx_head;          // Where CHIP writes to shared Rx buffer
+    uint32_t tx_seen_head;     // HOST TX head up to which the CHIP cache was invalidated
+    uint32_t tx_compl_head;    // TX completions written (kept while they are disabled)
+    uint32_t rx_split_head;    // RX header entries written (kept while header split is off)
+    uint32_t rx_fill_tail;     // Fill ring buffers taken
+    uint32_t rng;              // Traffic generator state (xorshift32)
+
+    enum chip_power_state pwr_state;
+    uint64_t pwr_deadline;     // End of entry delay / wake latency / poll interval
+    uint32_t doorbell_seen;    // Last HOST_TX_HEAD_PUB value latched by the doorbell logic
+    struct chip_power_stats power;
+
+    // Loopback FIFO: frame data in lb_fifo, lengths and due times in lb_slots
+    uint8_t lb_fifo[CHIP_LOOPBACK_FIFO_SIZE];
+    uint32_t lb_head;
+    uint32_t lb_tail;
+    struct chip_loopback_slot lb_slots[CHIP_LOOPBACK_SLOTS];
+    unsigned lb_slot_first;
+    unsigned lb_slot_count;
+    uint64_t lb_frames;        // Frames looped back to the RX ring
+
+    // RX overflow FIFO: frame data in rx_fifo, lengths in rx_fifo_len
+    uint8_t rx_fifo[CHIP_RX_FIFO_SIZE];
+    uint32_t rx_fifo_head;
+    uint32_t rx_fifo_tail;
+    uint16_t rx_fifo_len[CHIP_RX_FIFO_SLOTS];
+    unsigned rx_fifo_first;
+    unsigned rx_fifo_count;
+    struct chip_rx_stats rx;
+    // RX payload source for TEMPLATE (random bytes) and SEQUENCE (0..255 ramp) fill
+    uint8_t rx_template[CHIP_RX_TEMPLATE_SIZE + 256];
+    // Where the frame reserved by chip_rx_reserve() is written: the RX ring, or with
+    // header split rx_stage, from which the commit splits it
+    uint8_t *rx_dst;
+    uint8_t rx_stage[RX_BUFFER_SIZE];
+
+    // Airtime pacing: frames of the exchange in progress, released at phy_done_ns
+    uint32_t phy_frames;
+    uint64_t phy_done_ns;
+    struct chip_phy_stats phy;
+
+    // Segmentation: payload bytes of the super-frame at the TX tail already sent as
+    // segments (a full loopback FIFO can stop it midway), and the segment being built
+    uint32_t tso_done;
+    uint8_t tso_seg[TX_BUFFER_SIZE];
+    struct chip_tso_stats tso;
+
+    chip_tx_sink_fn tx_sink;   // Optional consumer of transmitted frames
+    void *tx_sink_ctx;
+};
+
+// --- CHIP Emulator API ---
+// cfg NULL selects CHIP_EMULATOR_DEFAULT_CONFIG
+void chip_emulator_init(struct chip_emulator *chip, struct sim_device *dev,
+                        const struct chip_emulator_config *cfg);
+void chip_emulator_process_tx(struct chip_emulator *chip);
+// One frame arrives from the air; it is subject to the RX overflow policy
+void chip_emulator_generate_rx(struct chip_emulator *chip);
+// Moves looped-back frames whose delay has passed into the RX ring
+void chip_emulator_process_loopback(struct chip_emulator *chip);
+// Writes an externally supplied frame into the RX ring; returns -1 if it does not fit
+int chip_emulator_inject_rx(struct chip_emulator *chip, const uint8_t *data, uint32_t len);
+void chip_emulator_set_tx_sink(struct chip_emulator *chip, chip_tx_sink_fn fn, void *ctx);
+void chip_emulator_run_cycle(struct chip_emulator *chip);
+void chip_raise_interrupt(struct chip_emulator *chip, uint32_t bit);
+
+#endif // CHIP_EMULATOR_H
@@ -0,0 +1,77 @@
+#ifndef DCACHE_BATCH_H
+#define DCACHE_BATCH_H
+
+#include <stdint.h>
+#include "shared.h" // For DCACHE_LINE_SIZE, ring_contig()
+
+// --- Deferred D-Cache Maintenance ---
+// Collects the address ranges that need one kind of maintenance (clean or
+// invalidate), rounds them out to whole cache lines and merges overlapping or
+// adjacent ones, so that a burst of frames costs one maintenance call per
+// contiguous region instead of one per frame. dcache_batch_flush() issues the
+// calls; the driver does that right before it publishes the ring pointer.
+
+#define DCACHE_BATCH_MAX_RANGES     4 // Ring data is contiguous except at the wrap
+
+struct dcache_batch {
+    void (*op)(void *ctx, uint32_t addr, uint32_t len); // e.g. mock_dcache_clean_range
+    void *ctx;                               // Passed through to op
+    uint32_t start[DCACHE_BATCH_MAX_RANGES]; // Line-aligned, end exclusive
+    uint32_t end[DCACHE_BATCH_MAX_RANGES];
+    unsigned count;
+};
+
+static inline void dcache_batch_init(struct dcache_batch *b,
+                                     void (*op)(void *ctx, uint32_t addr, uint32_t len), void *ctx) {
+    b->op = op;
+    b->ctx = ctx;
+    b->count = 0;
+}
+
+static inline void dcache_batch_flush(struct dcache_batch *b) {
+    for (unsigned i = 0; i < b->count; i++) {
+        b->op(b->ctx, b->start[i], b->end[i] - b->start[i]);
+    }
+    b->count = 0;
+}
+
+static inline void dcache_batch_add(struct dcache_batch *b, uint32_t addr, uint32_t len) {
+    if (len == 0) {
+        return;
+    }
+    uint32_t start = addr & ~(DCACHE_LINE_SIZE - 1);
+    uint32_t end = (addr + len + DCACHE_LINE_SIZE - 1) & ~(DCACHE_LINE_SIZE - 1);
+
+    // Merge with every range it overlaps or touches
+    for (unsigned i = 0; i < b->count; ) {
+        if (start <= b->end[i] && b->start[i] <= end) {
+            start = (b->start[i] < start) ? b->start[i] : start;
+            end = (b->end[i] > end) ? b->end[i] : end;
+            b->count--;
+            b->start[i] = b->start[b->count];
+            b->end[i] = b->end[b->count];
+            i = 0; // The grown range may now touch one already checked
+        } else {
+            i++;
+        }
+    }
+
+    if (b->count == DCACHE_BATCH_MAX_RANGES) {
+        dcache_batch_flush(b); // Out of slots: maintain what we have now
+    }
+    b->start[b->count] = start;
+    b->end[b->count] = end;
+    b->count++;
+}
+
+// Adds len bytes at off of the ring at BUS address base, split where it wraps
+static inline void dcache_batch_add_ring(struct dcache_batch *b, uint32_t base, uint32_t size,
+                                         uint32_t off, uint32_t len) {
+    uint32_t first = ring_contig(off, len, size);
+    dcache_batch_add(b, base + off, first);
+    if (first < len) {
+        dcache_batch_add(b, base, len - first);
+    }
+}
+
+#endif // DCACHE_BATCH_H
@@ -0,0 +1,284 @@
+#include "shared.h"
+#include "fq_codel.h"
+#include <math.h>
+
+enum {
+    FQ_CODEL_LIST_NONE,
+    FQ_CODEL_LIST_NEW,
+    FQ_CODEL_LIST_OLD,
+};
+
+// --- Lists ---
+static void fq_list_init(struct fq_codel_list *l) {
+    l->head = FQ_CODEL_NONE;
+    l->tail = FQ_CODEL_NONE;
+}
+
+// Frame lists link through fq_codel_pkt.next
+static void fq_pkt_push(struct fq_codel *q, struct fq_codel_list *l, uint32_t idx) {
+    q->pool[idx].next = FQ_CODEL_NONE;
+    if (l->tail == FQ_CODEL_NONE) {
+        l->head = idx;
+    } else {
+        q->pool[l->tail].next = idx;
+    }
+    l->tail = idx;
+}
+
+static uint32_t fq_pkt_pop(struct fq_codel *q, struct fq_codel_list *l) {
+    uint32_t idx = l->head;
+    if (idx != FQ_CODEL_NONE) {
+        l->head = q->pool[idx].next;
+        if (l->head == FQ_CODEL_NONE) {
+            l->tail = FQ_CODEL_NONE;
+        }
+    }
+    return idx;
+}
+
+// Flow lists link through fq_codel_flow.next
+static void fq_flow_push(struct fq_codel *q, struct fq_codel_list *l, uint32_t idx, int which) {
+    q->flows[idx].next = FQ_CODEL_NONE;
+    q->flows[idx].list = which;
+    if (l->tail == FQ_CODEL_NONE) {
+        l->head = idx;
+    } else {
+        q->flows[l->tail].next = idx;
+    }
+    l->tail = idx;
+}
+
+static void fq_flow_pop(struct fq_codel *q, struct fq_codel_list *l) {
+    uint32_t idx = l->head;
+    l->head = q->flows[idx].next;
+    if (l->head == FQ_CODEL_NONE) {
+        l->tail = FQ_CODEL_NONE;
+    }
+    q->flows[idx].list = FQ_CODEL_LIST_NONE;
+}
+
+// --- Frame Pool ---
+static void fq_pkt_free(struct fq_codel *q, uint32_t idx) {
+    q->pool[idx].next = q->free_pkts;
+    q->free_pkts = idx;
+    q->queued--;
+}
+
+// Removes the head frame of flow f from the queue (the caller frees or keeps it)
+static uint32_t fq_flow_take(struct fq_codel *q, struct fq_codel_flow *f) {
+    uint32_t idx = fq_pkt_pop(q, &f->pkts);
+    if (idx != FQ_CODEL_NONE) {
+        f->backlog -= q->pool[idx].len;
+    }
+    return idx;
+}
+
+// --- Initialization ---
+int fq_codel_init(struct fq_codel *q, const struct fq_codel_config *cfg) {
+    static const struct fq_codel_config defaults = FQ_CODEL_DEFAULT_CONFIG;
+    const struct fq_codel_config *c = (cfg != NULL) ? cfg : &defaults;
+    if (c->interval_ns == 0 || c->quantum == 0 || c->limit == 0 || c->limit > FQ_CODEL_POOL_SIZE) {
+        return -1;
+    }
+
+    q->cfg = *c;
+    for (uint32_t i = 0; i < FQ_CODEL_FLOWS; i++) {
+        memset(&q->flows[i], 0, sizeof(q->flows[i]));
+        fq_list_init(&q->flows[i].pkts);
+        q->flows[i].next = FQ_CODEL_NONE;
+    }
+    fq_list_init(&q->new_flows);
+    fq_list_init(&q->old_flows);
+    for (uint32_t i = 0; i < FQ_CODEL_POOL_SIZE; i++) {
+        q->pool[i].next = (i + 1 < FQ_CODEL_POOL_SIZE) ? i + 1 : FQ_CODEL_NONE;
+    }
+    q->free_pkts = 0;
+    q->queued = 0;
+    q->staged = FQ_CODEL_NONE;
+    memset(&q->stats, 0, sizeof(q->stats));
+    return 0;
+}
+
+// --- Enqueue ---
+// Drops the head frame of the flow with the largest backlog
+static void fq_drop_fattest(struct fq_codel *q) {
+    uint32_t fattest = 0;
+    for (uint32_t i = 1; i < FQ_CODEL_FLOWS; i++) {
+        if (q->flows[i].backlog > q->flows[fattest].backlog) {
+            fattest = i;
+        }
+    }
+    uint32_t idx = fq_flow_take(q, &q->flows[fattest]);
+    if (idx != FQ_CODEL_NONE) {
+        fq_pkt_free(q, idx);
+        q->stats.overlimit_drops++;
+    }
+}
+
+int fq_codel_enqueue(struct fq_codel *q, uint32_t flow, const uint8_t *data, uint32_t len, uint64_t now_ns) {
+    if (len > FQ_CODEL_MAX_FRAME) {
+        return -1;
+    }
+    // The staged frame holds a pool entry too
+    if (q->queued >= q->cfg.limit || q->free_pkts == FQ_CODEL_NONE) {
+        fq_drop_fattest(q);
+    }
+
+    uint32_t idx = q->free_pkts;
+    q->free_pkts = q->pool[idx].next;
+    q->queued++;
+    struct fq_codel_pkt *pkt = &q->pool[idx];
+    pkt->len = len;
+    pkt->enqueue_ns = now_ns;
+    memcpy(pkt->data, data, len);
+
+    uint32_t bucket = flow % FQ_CODEL_FLOWS;
+    struct fq_codel_flow *f = &q->flows[bucket];
+    fq_pkt_push(q, &f->pkts, idx);
+    f->backlog += len;
+    q->stats.enqueued++;
+
+    if (f->list == FQ_CODEL_LIST_NONE) {
+        f->deficit = (int32_t)q->cfg.quantum;
+        fq_flow_push(q, &q->new_flows, bucket, FQ_CODEL_LIST_NEW);
+        q->stats.new_flows++;
+    }
+    return 0;
+}
+
+// --- CoDel (RFC 8289) ---
+static uint64_t codel_control_law(const struct fq_codel *q, uint64_t t, uint32_t count) {
+    return t + (uint64_t)(q->cfg.interval_ns / sqrt((double)count));
+}
+
+// Takes the flow's head frame and decides whether its sojourn time allows dropping
+static uint32_t codel_do_dequeue(struct fq_codel *q, struct fq_codel_flow *f, uint64_t now, int *ok_to_drop) {
+    uint32_t idx = fq_flow_take(q, f);
+    *ok_to_drop = 0;
+    if (idx == FQ_CODEL_NONE) {
+        f->first_above_ns = 0;
+        return idx;
+    }
+
+    uint64_t sojourn = now - q->pool[idx].enqueue_ns;
+    if (sojourn < q->cfg.target_ns || f->backlog <= FQ_CODEL_MAX_FRAME) {
+        // Below target, or too little queued to be a standing queue
+        f->first_above_ns = 0;
+    } else if (f->first_above_ns == 0) {
+        f->first_above_ns = now + q->cfg.interval_ns;
+    } else if (now >= f->first_above_ns) {
+        *ok_to_drop = 1;
+    }
+    return idx;
+}
+
+static void codel_drop(struct fq_codel *q, uint32_t idx) {
+    fq_pkt_free(q, idx);
+    q->stats.codel_drops++;
+}
+
+static uint32_t codel_dequeue(struct fq_codel *q, struct fq_codel_flow *f, uint64_t now) {
+    int ok_to_drop;
+    uint32_t idx = codel_do_dequeue(q, f, now, &ok_to_drop);
+    if (idx == FQ_CODEL_NONE) {
+        f->dropping = 0;
+        return idx;
+    }
+
+    if (f->dropping) {
+        if (!ok_to_drop) {
+            f->dropping = 0;
+        }
+        while (f->dropping && now >= f->drop_next_ns) {
+            codel_drop(q, idx);
+            f->count++;
+            idx = codel_do_dequeue(q, f, now, &ok_to_drop);
+            if (idx == FQ_CODEL_NONE || !ok_to_drop) {
+                f->dropping = 0;
+            } else {
+                f->drop_next_ns = codel_control_law(q, f->drop_next_ns, f->count);
+            }
+        }
+    } else if (ok_to_drop) {
+        codel_drop(q, idx);
+        idx = codel_do_dequeue(q, f, now, &ok_to_drop);
+        f->dropping = 1;
+        // Resume near the previous drop rate if the last dropping state was recent
+        uint32_t delta = f->count - f->lastcount;
+        f->count = (delta > 1 && now - f->drop_next_ns < 16ULL * q->cfg.interval_ns) ? delta : 1;
+        f->drop_next_ns = codel_control_law(q, now, f->count);
+        f->lastcount = f->count;
+    }
+    return idx;
+}
+
+// --- DRR Scheduler (RFC 8290) ---
+static uint32_t fq_codel_dequeue(struct fq_codel *q, uint64_t now) {
+    for (;;) {
+        struct fq_codel_list *l;
+        if (q->new_flows.head != FQ_CODEL_NONE) {
+            l = &q->new_flows;
+        } else if (q->old_flows.head != FQ_CODEL_NONE) {
+            l = &q->old_flows;
+        } else {
+            return FQ_CODEL_NONE;
+        }
+
+        uint32_t bucket = l->head;
+        struct fq_codel_flow *f = &q->flows[bucket];
+        if (f->deficit <= 0) {
+            // Used up its quantum: next round
+            f->deficit += (int32_t)q->cfg.quantum;
+            fq_flow_pop(q, l);
+            fq_flow_push(q, &q->old_flows, bucket, FQ_CODEL_LIST_OLD);
+            continue;
+        }
+
+        uint32_t idx = codel_dequeue(q, f, now);
+        if (idx == FQ_CODEL_NONE) {
+            // Empty: a new flow gets one more pass as an old flow, an old flow leaves
+            int was_new = (l == &q->new_flows);
+            fq_flow_pop(q, l);
+            if (was_new && q->old_flows.head != FQ_CODEL_NONE) {
+                fq_flow_push(q, &q->old_flows, bucket, FQ_CODEL_LIST_OLD);
+            }
+            continue;
+        }
+
+        f->deficit -= (int32_t)q->pool[idx].len;
+        return idx;
+    }
+}
+
+// --- Feeding the TX Ring ---
+unsigned fq_codel_feed(struct fq_codel *q, struct host_chip *host, uint64_t now_ns) {
+    unsigned sent = 0;
+
+    for (;;) {
+        if (q->staged == FQ_CODEL_NONE) {
+            q->staged = fq_codel_dequeue(q, now_ns);
+            if (q->staged == FQ_CODEL_NONE) {
+                break;
+            }
+        }
+
+        const struct fq_codel_pkt *pkt = &q->pool[q->staged];
+        uint32_t inflight = host_chip_tx_inflight(host);
+        if (q->cfg.ring_limit_bytes != 0 && inflight > 0 &&
+            inflight + pkt->len + PACKET_LENGTH_FIELD_SIZE > q->cfg.ring_limit_bytes) {
+            break; // Enough queued for the CHIP; the rest waits here
+        }
+        if (host_chip_queue_packet(host, pkt->data, pkt->len) != 0) {
+            break; // Ring full: retry on the next feed
+        }
+        fq_pkt_free(q, q->staged);
+        q->staged = FQ_CODEL_NONE;
+        q->stats.sent++;
+        sent++;
+    }
+
+    if (sent > 0) {
+        host_chip_tx_kick(host);
+    }
+    return sent;
+}
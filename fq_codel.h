@@ -0,0 +1,92 @@
+#ifndef FQ_CODEL_H
+#define FQ_CODEL_H
+
+#include <stdint.h>
+#include "host.h"
+
+// --- FQ-CoDel HOST TX Queue ---
+// Optional software queue above host_chip_send_packet() (RFC 8290). Frames go to one of
+// FQ_CODEL_FLOWS per-flow queues by a caller-supplied flow hash; flows are served by
+// deficit round robin with a quantum of bytes, new (sparse) flows ahead of old ones,
+// and every flow runs CoDel (RFC 8289): once a flow's sojourn time has stayed above
+// target for an interval, its head frames are dropped at a rate growing with sqrt(drops).
+//
+// fq_codel_feed() moves frames into the TX ring only while the bytes in flight (in
+// the ring, not yet consumed by the CHIP) stay below ring_limit_bytes, so the queue,
+// and with it the drop decision, stays in the qdisc instead of in the ring.
+// All times are the caller's clock in ns (virtual device time in the simulation).
+
+#define FQ_CODEL_FLOWS              64
+#define FQ_CODEL_POOL_SIZE          1024   // Frames held across all flows
+#define FQ_CODEL_MAX_FRAME          2048   // Largest frame accepted
+#define FQ_CODEL_NONE               UINT32_MAX
+
+struct fq_codel_config {
+    uint32_t target_ns;        // Acceptable standing sojourn time
+    uint32_t interval_ns;      // Window over which sojourn must stay above target
+    uint32_t quantum;          // DRR bytes per round
+    uint32_t limit;            // Frames held before the fattest flow is dropped (<= FQ_CODEL_POOL_SIZE)
+    uint32_t ring_limit_bytes; // TX ring bytes in flight (0: whole ring)
+};
+
+#define FQ_CODEL_DEFAULT_CONFIG { 5000000, 100000000, 1514, FQ_CODEL_POOL_SIZE, 0 }
+
+struct fq_codel_stats {
+    uint64_t enqueued;
+    uint64_t sent;             // Frames moved into the TX ring
+    uint64_t codel_drops;      // Dropped by CoDel at dequeue
+    uint64_t overlimit_drops;  // Dropped from the fattest flow at enqueue
+    uint64_t new_flows;        // Flows that entered the new-flow list
+};
+
+struct fq_codel_pkt {
+    uint32_t next;
+    uint32_t len;
+    uint64_t enqueue_ns;
+    uint8_t data[FQ_CODEL_MAX_FRAME];
+};
+
+// Singly linked list of frames or of flows, by index
+struct fq_codel_list {
+    uint32_t head;
+    uint32_t tail;
+};
+
+struct fq_codel_flow {
+    struct fq_codel_list pkts;
+    uint32_t backlog;          // Bytes queued
+    int32_t deficit;
+    uint32_t next;             // Next flow in the new/old list
+    int list;                  // FQ_CODEL_LIST_*
+
+    // CoDel state
+    int dropping;
+    uint32_t count;
+    uint32_t lastcount;
+    uint64_t first_above_ns;
+    uint64_t drop_next_ns;
+};
+
+struct fq_codel {
+    struct fq_codel_config cfg;
+    struct fq_codel_flow flows[FQ_CODEL_FLOWS];
+    struct fq_codel_list new_flows;
+    struct fq_codel_list old_flows;
+    uint32_t free_pkts;        // Head of the free frame list
+    uint32_t queued;           // Frames held
+    uint32_t staged;           // Dequeued frame waiting for ring room (FQ_CODEL_NONE if none)
+    struct fq_codel_stats stats;
+    struct fq_codel_pkt pool[FQ_CODEL_POOL_SIZE];
+};
+
+// cfg NULL selects FQ_CODEL_DEFAULT_CONFIG; returns -1 on an invalid config
+int fq_codel_init(struct fq_codel *q, const struct fq_codel_config *cfg);
+// Queues a frame in the queue of flow (its flow hash, e.g. of the 5-tuple, modulo
+// FQ_CODEL_FLOWS); returns 0, or -1 if it is larger than FQ_CODEL_MAX_FRAME.
+// When the queue is at its limit a frame of the fattest flow is dropped to make room.
+int fq_codel_enqueue(struct fq_codel *q, uint32_t flow, const uint8_t *data, uint32_t len, uint64_t now_ns);
+// Moves frames into the TX ring as far as the in-flight limit and the ring allow and
+// rings the doorbell once; returns the number of frames sent
+unsigned fq_codel_feed(struct fq_codel *q, struct host_chip *host, uint64_t now_ns);
+
+#endif // FQ_CODEL_H
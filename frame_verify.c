@@ -0,0 +1,195 @@
+#include "frame_verify.h"
+#include <stdio.h>
+
+#if defined(FRAME_VERIFY_SCALAR)
+#define FRAME_VERIFY_IMPL "scalar"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FRAME_VERIFY_IMPL "sse2"
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FRAME_VERIFY_IMPL "neon"
+#else
+#define FRAME_VERIFY_IMPL "scalar"
+#endif
+
+// --- Pattern ---
+struct frame_verify_key {
+    uint8_t k0;
+    uint8_t k1;                // Odd, so consecutive bytes always differ
+};
+
+static struct frame_verify_key frame_verify_key(uint32_t seq, uint32_t seed) {
+    // murmur3 finalizer
+    uint32_t h = seed ^ (seq * 0x9E3779B9U);
+    h ^= h >> 16;
+    h *= 0x85EBCA6BU;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35U;
+    h ^= h >> 16;
+    struct frame_verify_key k = { (uint8_t)h, (uint8_t)((h >> 8) | 1) };
+    return k;
+}
+
+static inline uint8_t frame_verify_byte(struct frame_verify_key k, uint32_t i) {
+    return (uint8_t)(k.k0 + i * k.k1);
+}
+
+static void frame_verify_put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t frame_verify_get32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void frame_verify_fill(uint8_t *buf, uint32_t len, uint32_t seq, uint32_t seed) {
+    struct frame_verify_key k = frame_verify_key(seq, seed);
+    frame_verify_put32(buf, seq);
+    frame_verify_put32(buf + 4, seed);
+    for (uint32_t i = FRAME_VERIFY_HDR_LEN; i < len; i++) {
+        buf[i] = frame_verify_byte(k, i);
+    }
+}
+
+// --- Compare ---
+// Returns the index of the first byte in [start, len) that differs from the pattern,
+// or len if there is none
+static uint32_t frame_verify_compare(const uint8_t *data, uint32_t start, uint32_t len, struct frame_verify_key k) {
+    uint32_t i = start;
+#if !defined(FRAME_VERIFY_SCALAR) && (defined(__SSE2__) || defined(__ARM_NEON))
+    if (len - i >= 16) {
+        // Lane j holds the pattern byte of i + j; every step advances all lanes by 16
+        uint8_t lanes[16];
+        for (uint32_t j = 0; j < 16; j++) {
+            lanes[j] = frame_verify_byte(k, i + j);
+        }
+        uint8_t step = (uint8_t)(16 * k.k1);
+#if defined(__SSE2__)
+        __m128i expect = _mm_loadu_si128((const __m128i *)lanes);
+        const __m128i inc = _mm_set1_epi8((char)step);
+        for (; len - i >= 16; i += 16) {
+            __m128i got = _mm_loadu_si128((const __m128i *)(data + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(got, expect)) != 0xFFFF) {
+                break; // The scalar loop below finds the byte
+            }
+            expect = _mm_add_epi8(expect, inc);
+        }
+#else
+        uint8x16_t expect = vld1q_u8(lanes);
+        const uint8x16_t inc = vdupq_n_u8(step);
+        for (; len - i >= 16; i += 16) {
+            uint8x16_t eq = vceqq_u8(vld1q_u8(data + i), expect);
+            uint64x2_t eq64 = vreinterpretq_u64_u8(eq);
+            if ((vgetq_lane_u64(eq64, 0) & vgetq_lane_u64(eq64, 1)) != UINT64_MAX) {
+                break;
+            }
+            expect = vaddq_u8(expect, inc);
+        }
+#endif
+    }
+#endif
+    for (; i < len; i++) {
+        if (data[i] != frame_verify_byte(k, i)) {
+            return i;
+        }
+    }
+    return len;
+}
+
+// --- Verifier ---
+void frame_verify_init(struct frame_verify *v, const char *name, uint32_t seed) {
+    *v = (struct frame_verify){ .name = name, .seed = seed };
+}
+
+// Returns 1 while the verifier may still print a report
+static int frame_verify_report(struct frame_verify *v) {
+    if (v->reports == FRAME_VERIFY_MAX_REPORTS) {
+        return 0;
+    }
+    v->reports++;
+    return 1;
+}
+
+static void frame_verify_track(struct frame_verify *v, uint32_t seq, uint32_t ring_off) {
+    int32_t ahead = (int32_t)(seq - v->next_seq);
+    if (ahead >= 0) {
+        uint32_t shift = (uint32_t)ahead + 1;
+        if (ahead > 0) {
+            v->lost += (uint32_t)ahead;
+            if (frame_verify_report(v)) {
+                fprintf(stderr, "VERIFY %s: seq %u at ring offset %u, expected %u (%u missing)\n",
+                        v->name, seq, ring_off, v->next_seq, (uint32_t)ahead);
+            }
+        }
+        v->window = (shift >= 64) ? 1 : (v->window << shift) | 1;
+        v->next_seq = seq + 1;
+        return;
+    }
+
+    uint32_t back = (uint32_t)(-(ahead + 1)); // 0: the frame just before next_seq
+    const char *what;
+    if (back < 64 && (v->window & (1ULL << back))) {
+        v->duplicated++;
+        what = "duplicate";
+    } else {
+        if (back < 64) {
+            v->window |= 1ULL << back;
+        }
+        v->lost -= (v->lost > 0); // Counted as missing when a later frame overtook it
+        v->reordered++;
+        what = "late";
+    }
+    if (frame_verify_report(v)) {
+        fprintf(stderr, "VERIFY %s: seq %u at ring offset %u, expected %u (%s)\n",
+                v->name, seq, ring_off, v->next_seq, what);
+    }
+}
+
+int frame_verify_check(struct frame_verify *v, const uint8_t *data, uint32_t len, uint32_t ring_off) {
+    v->frames++;
+    if (len < FRAME_VERIFY_HDR_LEN) {
+        v->corrupt++;
+        if (frame_verify_report(v)) {
+            fprintf(stderr, "VERIFY %s: %u-byte frame at ring offset %u is shorter than its header\n",
+                    v->name, len, ring_off);
+        }
+        return -1;
+    }
+
+    uint32_t seq = frame_verify_get32(data);
+    uint32_t seed = frame_verify_get32(data + 4);
+    if (seed != v->seed) {
+        // The sequence number is as untrustworthy as the seed next to it
+        v->corrupt++;
+        if (frame_verify_report(v)) {
+            fprintf(stderr, "VERIFY %s: frame at ring offset %u has seed 0x%08x, expected 0x%08x\n",
+                    v->name, ring_off, seed, v->seed);
+        }
+        return -1;
+    }
+    frame_verify_track(v, seq, ring_off);
+
+    struct frame_verify_key k = frame_verify_key(seq, seed);
+    uint32_t bad = frame_verify_compare(data, FRAME_VERIFY_HDR_LEN, len, k);
+    if (bad == len) {
+        return 0;
+    }
+    v->corrupt++;
+    if (frame_verify_report(v)) {
+        fprintf(stderr, "VERIFY %s: seq %u at ring offset %u (len %u): byte %u is 0x%02x, expected 0x%02x\n",
+                v->name, seq, ring_off, len, bad, data[bad], frame_verify_byte(k, bad));
+    }
+    return -1;
+}
+
+uint64_t frame_verify_errors(const struct frame_verify *v) {
+    return v->corrupt + v->duplicated + v->reordered + v->lost;
+}
+
+const char *frame_verify_impl(void) {
+    return FRAME_VERIFY_IMPL;
+}
@@ -0,0 +1,54 @@
+#ifndef FRAME_VERIFY_H
+#define FRAME_VERIFY_H
+
+#include <stdint.h>
+
+// --- Frame Content Verification ---
+// Producers stamp every frame with a per-ring sequence number and the run's pattern
+// seed, followed by a pattern derived from both; consumers check sequence continuity
+// and compare the payload against the regenerated pattern. A frame is laid out as:
+//
+//   [seq: 4 bytes LE][seed: 4 bytes LE][pattern: len - 8 bytes]
+//
+// Pattern byte i of the frame (i >= 8) is (uint8_t)(k0 + i * k1), with k0 and k1 (odd)
+// taken from a hash of (seed, seq): cheap to regenerate in vector registers, different
+// for every frame, and a shifted, truncated or foreign payload does not match.
+//
+// The compare uses SSE2 on x86-64 and NEON on aarch64, 16 bytes per step, and a scalar
+// loop elsewhere or with SIM_FLAGS=-DFRAME_VERIFY_SCALAR.
+
+#define FRAME_VERIFY_HDR_LEN        8      // Shortest frame that can be stamped
+#define FRAME_VERIFY_MAX_REPORTS    8      // Mismatches printed per verifier
+
+// Sequence tracking: frames behind next_seq are matched against a 64-frame window,
+// so a late frame counts as reordered (and no longer as lost) and a repeated one as
+// duplicated. Frames further behind cannot be told from duplicates and are taken as
+// late.
+struct frame_verify {
+    const char *name;          // Prefix of the mismatch reports
+    uint32_t seed;
+    uint32_t next_seq;         // One past the highest sequence number seen
+    uint64_t window;           // Bit k: next_seq - 1 - k has been seen
+    uint64_t frames;           // Frames checked
+    uint64_t lost;             // Sequence numbers skipped and not seen since
+    uint64_t duplicated;
+    uint64_t reordered;
+    uint64_t corrupt;          // Frames with a bad header, length or payload byte
+    unsigned reports;
+};
+
+// Writes frame seq of len bytes (>= FRAME_VERIFY_HDR_LEN) to buf
+void frame_verify_fill(uint8_t *buf, uint32_t len, uint32_t seq, uint32_t seed);
+
+// Resets v to expect sequence number 0 stamped with seed; name prefixes its reports
+void frame_verify_init(struct frame_verify *v, const char *name, uint32_t seed);
+// Checks one contiguous frame; ring_off is where the frame sits in its ring and only
+// appears in reports. Returns 0 if the content is intact, -1 if not (sequence gaps,
+// duplicates and reordering are counted but do not fail the frame).
+int frame_verify_check(struct frame_verify *v, const uint8_t *data, uint32_t len, uint32_t ring_off);
+// Corrupt + duplicated + reordered + lost frames
+uint64_t frame_verify_errors(const struct frame_verify *v);
+// "sse2", "neon" or "scalar"
+const char *frame_verify_impl(void);
+
+#endif // FRAME_VERIFY_H
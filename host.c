@@ -1,286 +1,1270 @@
 #include "shared.h"
+#include "host.h"
+#include "chip_emulator.h"
+#include "bench.h"
+#include "idle_report.h"
+#include "bridge.h"
+#include "phy_report.h"
+#include "aqm_report.h"
+#include "rx_loss_report.h"
+#include "ring_report.h"
+#include "cache_sim.h"
+#include "dcache_batch.h"
+#include "sim_device.h"
 #include <stdio.h> // For printf (debug purposes)
 #include <stdlib.h> // For rand(), srand()
 #include <stdint.h> // For uintptr_t
 
-// --- HOST Local Ring Buffer Pointers ---
-static volatile uint32_t host_tx_head = 0; // Where HOST will write next
-static volatile uint32_t host_rx_tail = 0; // Where HOST last read from
+// Trace output switch (declared extern in shared.h)
+int sim_log_enabled = 1;
 
-// Pointers to the shared memory regions (these will be part of a global simulated memory array)
-// For `main`, you'd allocate memory and assign these.
-uint8_t * tx_buffer_ptr = (uint8_t *)TX_BUFFER_START_ADDR;
-uint8_t * rx_buffer_ptr = (uint8_t *)RX_BUFFER_START_ADDR;
+#ifdef SIMULATION_MODE
+// Barrier audit counters (declared extern in shared.h)
+_Thread_local uint64_t sim_barrier_counts[SIM_BARRIER_KINDS];
+#endif
 
-// Mock simulated memory for registers (declared extern in shared.h)
-// This array represents the memory-mapped registers of the CHIP accessible via BUS.
-uint32_t simulated_chip_registers[7]; // Size matches the number of registers defined
-
-// Mock simulated shared RAM. In a real system, this would be actual DRAM.
-// For simulation, we'll create a single large array.
-// Total shared memory: TX_BUFFER_SIZE + RX_BUFFER_SIZE
-#define TOTAL_SHARED_MEMORY_SIZE (TX_BUFFER_SIZE + RX_BUFFER_SIZE)
-uint8_t simulated_shared_ram[TOTAL_SHARED_MEMORY_SIZE];
+// The device driven by the demo loop
+static struct sim_device demo_dev;
+static struct host_chip demo_host;
+static struct chip_emulator demo_chip;
 
 
 // --- Mock Cache Maintenance Functions for SIMULATION_MODE ---
-void mock_dcache_clean_range(uint32_t addr __attribute__((unused)), uint32_t len __attribute__((unused))) {
-    // In a real system, this would call your SoC's D-Cache API.
-    // In simulation, it's just a print or a no-op if memory is directly accessed.
+// Addresses are BUS addresses of the shared RAM. In a real system, these would call
+// your SoC's D-Cache API. In simulation they drive the HOST side of the device's
+// cache model (ctx, see cache_sim.c), which is a no-op unless enabled.
+void mock_dcache_clean_range(void *ctx, uint32_t addr, uint32_t len) {
     // printf("DEBUG: D-Cache Clean: 0x%lx, Len: %lu\n", addr, len);
+    cache_sim_clean(ctx, CACHE_SIM_HOST, addr, len);
 }
 
-void mock_dcache_invalidate_range(uint32_t addr __attribute__((unused)), uint32_t len __attribute__((unused))) {
-    // In a real system, this would call your SoC's D-Cache API.
-    // In simulation, it's just a print or a no-op if memory is directly accessed.
+void mock_dcache_invalidate_range(void *ctx, uint32_t addr, uint32_t len) {
     // printf("DEBUG: D-Cache Invalidate: 0x%lx, Len: %lu\n", addr, len);
+    cache_sim_invalidate(ctx, CACHE_SIM_HOST, addr, len);
 }
 
 
 // --- HOST Initialization ---
-void host_chip_driver_init() {
-    printf("HOST: Initializing CHIP driver...\n");
+void host_chip_driver_init(struct host_chip *host, const struct host_chip_bus *bus) {
+    SIM_LOG("HOST: Initializing CHIP driver...\n");
 
     // Initialize local pointers
-    host_tx_head = 0;
-    host_rx_tail = 0;
+    memset(host, 0, sizeof(*host));
+    host->bus = *bus;
+    dcache_batch_init(&host->tx_clean_batch, mock_dcache_clean_range, bus->dcache_ctx);
+    dcache_batch_init(&host->rx_inval_batch, mock_dcache_invalidate_range, bus->dcache_ctx);
 
-    // Zero-out simulated registers
-    for (int i = 0; i < 7; i++) {
-        simulated_chip_registers[i] = 0;
+    // Zero-out the CHIP registers
+    for (uint32_t reg = 0; reg < CHIP_NUM_REGS * 4; reg += 4) {
+        BUS_WRITE_REG(bus->regs, reg, 0);
     }
 
     // Clear any pending interrupts on the CHIP side
-    BUS_WRITE_REG(CHIP_REG_INT_CLEAR, 0xFFFFFFFFUL);
+    BUS_WRITE_REG(bus->regs, CHIP_REG_INT_CLEAR, 0xFFFFFFFFUL);
 
     // Publish initial HOST pointers to the CHIP.
-    BUS_WRITE_REG(CHIP_REG_HOST_TX_HEAD_PUB, host_tx_head);
-    BUS_WRITE_REG(CHIP_REG_HOST_RX_TAIL_PUB, host_rx_tail);
+    BUS_WRITE_REG(bus->regs, CHIP_REG_HOST_TX_HEAD_PUB, host->tx_head);
+    BUS_WRITE_REG(bus->regs, CHIP_REG_HOST_RX_TAIL_PUB, host->rx_tail);
 
     // Ensure all writes are completed and visible to the CHIP over BUS.
     DSB();
     ISB();
 
     // Enable specific interrupts from the CHIP
-    BUS_WRITE_REG(CHIP_REG_INT_ENABLE,
+    BUS_WRITE_REG(bus->regs, CHIP_REG_INT_ENABLE,
                   CHIP_INT_RX_DATA_READY_BIT |
                   CHIP_INT_TX_SPACE_AVAIL_BIT |
-                  CHIP_INT_ERROR_BIT);
-    printf("HOST: CHIP driver initialized. Pointers published.\n");
+                  CHIP_INT_ERROR_BIT |
+                  CHIP_INT_RX_OVERFLOW_BIT |
+                  CHIP_INT_TX_COMPLETE_BIT);
+    SIM_LOG("HOST: CHIP driver initialized. Pointers published.\n");
 }
 
-// --- HOST Transmit Function ---
-// Returns 0 on success, <0 on error
-int host_chip_send_packet(const uint8_t *data, uint32_t len) {
-    // Total size to write: packet data + length header
-    uint32_t total_write_len = len + PACKET_LENGTH_FIELD_SIZE;
+// --- HOST Transmit Functions ---
+// host_chip_queue_packet() writes a frame into the TX ring without telling the CHIP;
+// host_chip_tx_kick() cleans everything queued since the last kick in one merged
+// pass and rings the doorbell once. host_chip_send_packet() does both per frame.
+
+// Payload length of a fragment list; UINT32_MAX if the list itself is invalid
+static uint32_t host_tx_frags_len(const struct host_tx_frag *frags, unsigned count) {
+    if (count == 0 || count > HOST_TX_FRAGS_MAX) {
+        return UINT32_MAX;
+    }
+    uint64_t len = 0;
+    for (unsigned i = 0; i < count; i++) {
+        len += frags[i].len;
+    }
+    return (len > UINT16_MAX) ? UINT32_MAX : (uint32_t)len;
+}
 
+// Whether the CHIP can segment a super-frame of len bytes as tso describes
+static int host_tso_valid(const struct tx_tso_params *tso, uint32_t len) {
+    if (tso->mss == 0 || len <= tso->hdr_len ||
+        (uint32_t)tso->hdr_len + tso->mss > TX_BUFFER_SIZE - PACKET_LENGTH_FIELD_SIZE - 1) {
+        return 0; // Empty payload, or segments longer than any plain frame
+    }
+    if (tso->seq_off != TX_TSO_NO_FIELD && (uint32_t)tso->seq_off + 4 > tso->hdr_len) {
+        return 0;
+    }
+    if (tso->len_off != TX_TSO_NO_FIELD &&
+        ((uint32_t)tso->len_off + 2 > tso->hdr_len || tso->len_adj > tso->hdr_len)) {
+        return 0;
+    }
+    return 1;
+}
+
+// Writes one frame, gathered from count fragments of len bytes in total, behind the
+// local head; with tso set, as a super-frame for the CHIP to segment. Returns 0 on
+// success, <0 on error
+static int host_tx_queue(struct host_chip *host, const struct host_tx_frag *frags, unsigned count,
+                         uint32_t len, const struct tx_tso_params *tso, uint32_t cookie) {
+    // Total size to write: packet data + length header (+ TSO descriptor)
+    uint32_t total_write_len = len + ((tso != NULL) ? TX_TSO_RECORD_OVERHEAD : PACKET_LENGTH_FIELD_SIZE);
+
+    if (len == UINT32_MAX) {
+        SIM_LOG("HOST_TX_ERR: Invalid fragment list (%u fragments).\n", count);
+        return -1;
+    }
+    if (tso != NULL && !host_tso_valid(tso, len)) {
+        SIM_LOG("HOST_TX_ERR: Invalid TSO parameters (len %u, hdr_len %u, mss %u).\n", len, tso->hdr_len, tso->mss);
+        return -1;
+    }
     if (total_write_len > TX_BUFFER_SIZE) {
-        printf("HOST_TX_ERR: Packet too large (%u bytes) for buffer size %lu.\n", total_write_len, TX_BUFFER_SIZE);
+        SIM_LOG("HOST_TX_ERR: Packet too large (%u bytes) for buffer size %lu.\n", total_write_len, TX_BUFFER_SIZE);
         return -1; // Packet too large
     }
 
-    // Read the CHIP's current Tx consumption pointer (tail)
-    uint32_t chip_tx_tail = BUS_READ_REG(CHIP_REG_TX_TAIL_PTR);
+    // BQL: enough in flight to keep the CHIP busy until the next completion
+    if (host->bql.enabled && (int32_t)(host->bql.adj_limit - host->bql.num_queued) < 0) {
+        host->stats.tx_bql_stopped++;
+        return -2;
+    }
 
-    // Calculate available space in the ring buffer
-    uint32_t space_available;
-    if (host_tx_head >= chip_tx_tail) {
-        space_available = TX_BUFFER_SIZE - (host_tx_head - chip_tx_tail) - 1; // -1 to distinguish full from empty
-    } else {
-        space_available = (chip_tx_tail - host_tx_head) - 1; // -1 to distinguish full from empty
+    // TX completions: every frame in flight holds a slot until it is reaped
+    if (host->txc.enabled && host->txc.submitted - host->txc.tail == TX_COMPL_RING_ENTRIES) {
+        host->stats.tx_compl_full++;
+        return -2;
     }
 
+    // Read the CHIP's current Tx consumption pointer (tail)
+    uint32_t chip_tx_tail = BUS_READ_REG(host->bus.regs, CHIP_REG_TX_TAIL_PTR);
+
+    // Calculate available space in the ring buffer (one byte kept free to distinguish full from empty)
+    uint32_t space_available = tx_ring_free(host->tx_head, chip_tx_tail);
+
     if (space_available < total_write_len) {
-        printf("HOST_TX_ERR: Not enough space in Tx buffer. Avail: %u, Needed: %u.\n", space_available, total_write_len);
+        SIM_LOG("HOST_TX_ERR: Not enough space in Tx buffer. Avail: %u, Needed: %u.\n", space_available, total_write_len);
+        host->stats.tx_ring_full++;
         return -2; // Not enough space
     }
 
-    // --- Write Length Header ---
-    uint16_t len_header = (uint16_t)len; // Actual payload length
-    uint32_t current_offset = host_tx_head;
-
-    // Write length header (2 bytes) - Assuming it fits without wrapping for 2 bytes
-    *(uint16_t*)(tx_buffer_ptr + current_offset) = len_header;
-    current_offset = (current_offset + PACKET_LENGTH_FIELD_SIZE) % TX_BUFFER_SIZE;
+    uint32_t start_offset = host->tx_head;
 
-    // --- Copy Packet Data ---
-    if ((current_offset + len) > TX_BUFFER_SIZE) {
-        // Packet data wraps around
-        uint32_t first_part_len = TX_BUFFER_SIZE - current_offset;
-        memcpy(tx_buffer_ptr + current_offset, data, first_part_len);
-        memcpy(tx_buffer_ptr, data + first_part_len, len - first_part_len);
+    // --- Write Length Header (actual payload length, or the TSO marker and descriptor) ---
+    uint32_t current_offset;
+    if (tso != NULL) {
+        struct tx_tso_desc desc = { (uint16_t)len, *tso };
+        current_offset = tx_ring_write_len16(host->bus.tx_ring, start_offset, TX_LEN_TSO);
+        current_offset = tx_ring_write(host->bus.tx_ring, current_offset, &desc, sizeof(desc));
+        host->stats.tx_tso++;
     } else {
-        // Packet data fits in a single contiguous block
-        memcpy(tx_buffer_ptr + current_offset, data, len);
+        current_offset = tx_ring_write_len16(host->bus.tx_ring, start_offset, (uint16_t)len);
     }
 
+    // --- Copy Packet Data (wrapping around the end of the ring if needed) ---
+    for (unsigned i = 0; i < count; i++) {
+        current_offset = tx_ring_write(host->bus.tx_ring, current_offset, frags[i].data, frags[i].len);
+    }
+
+    cache_sim_ring_access(host->bus.dcache_ctx, CACHE_SIM_HOST, TX_BUFFER_START_ADDR, TX_BUFFER_SIZE,
+                          start_offset, total_write_len, 1);
+
+    // Defer the clean to the next kick, merged with the neighbouring frames
+    dcache_batch_add_ring(&host->tx_clean_batch, TX_BUFFER_START_ADDR, TX_BUFFER_SIZE, start_offset, total_write_len);
+
     // Update local head pointer
-    host_tx_head = (host_tx_head + total_write_len) % TX_BUFFER_SIZE;
+    host->tx_head = current_offset;
+
+    if (host->txc.enabled) {
+        uint32_t slot = host->txc.submitted & (TX_COMPL_RING_ENTRIES - 1);
+        host->bus.tx_compl_cookies[slot] = cookie;
+        cache_sim_ring_access(host->bus.dcache_ctx, CACHE_SIM_HOST, TX_COMPL_COOKIE_START_ADDR, TX_COMPL_COOKIE_SIZE,
+                              slot * 4, 4, 1);
+        dcache_batch_add(&host->tx_clean_batch, TX_COMPL_COOKIE_START_ADDR + slot * 4, 4);
+        host->txc.submitted++;
+    }
+
+    host->stats.tx_packets++;
+    host->stats.tx_bytes += len;
+    host->bql.num_queued += total_write_len;
+    host->bql.last_obj_cnt = total_write_len;
+
+    SIM_LOG("HOST_TX: Packet sent. Len: %u. New Head: %u.\n", len, host->tx_head);
+    return 0; // Success
+}
+
+int host_chip_queue_packet_cookie(struct host_chip *host, const uint8_t *data, uint32_t len, uint32_t cookie) {
+    struct host_tx_frag frag = { data, len };
+    return host_tx_queue(host, &frag, 1, len, NULL, cookie);
+}
+
+int host_chip_queue_packet(struct host_chip *host, const uint8_t *data, uint32_t len) {
+    return host_chip_queue_packet_cookie(host, data, len, 0);
+}
+
+int host_chip_queue_packetv(struct host_chip *host, const struct host_tx_frag *frags, unsigned count,
+                            uint32_t cookie) {
+    return host_tx_queue(host, frags, count, host_tx_frags_len(frags, count), NULL, cookie);
+}
+
+// Publishes every queued frame to the CHIP with one clean pass and one doorbell
+void host_chip_tx_kick(struct host_chip *host) {
+    if (host->tx_head == host->tx_head_pub) {
+        return; // Nothing queued since the last doorbell
+    }
 
     // Ensure all data writes to shared RAM are complete before updating the public pointer.
-    DMB();
-    mock_dcache_clean_range((uintptr_t)tx_buffer_ptr + ((current_offset - (PACKET_LENGTH_FIELD_SIZE + len) + TX_BUFFER_SIZE) % TX_BUFFER_SIZE), total_write_len);
+    BARRIER_RING_PUBLISH();
+    dcache_batch_flush(&host->tx_clean_batch);
 
     // Publish the updated HOST Tx head pointer to the CHIP
-    BUS_WRITE_REG(CHIP_REG_HOST_TX_HEAD_PUB, host_tx_head);
+    host->tx_head_pub = host->tx_head;
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_HOST_TX_HEAD_PUB, host->tx_head_pub);
 
     // Ensure the pointer update is visible to CHIP (via BUS)
-    DSB();
-    ISB();
+    BARRIER_DOORBELL();
 
-    printf("HOST_TX: Packet sent. Len: %u. New Head: %u.\n", len, host_tx_head);
-    return 0; // Success
+    host->stats.tx_doorbells++;
+}
+
+// --- Software TX Queue ---
+#define HOST_TXQ_PAD                0xFFFF // Length marking the unused end of the storage
+
+int host_chip_enable_txq(struct host_chip *host, const struct host_txq_config *cfg, uint8_t *storage, uint32_t size) {
+    static const struct host_txq_config defaults = HOST_TXQ_DEFAULT_CONFIG;
+    const struct host_txq_config *c = (cfg != NULL) ? cfg : &defaults;
+    if (storage == NULL || size < TX_BUFFER_SIZE ||
+        (c->policy != HOST_TXQ_DROP_NEW && c->policy != HOST_TXQ_DROP_OLDEST)) {
+        return -1;
+    }
+
+    struct host_txq *q = &host->txq;
+    memset(q, 0, sizeof(*q));
+    q->cfg = *c;
+    q->buf = storage;
+    q->size = size;
+    q->enabled = 1;
+    return 0;
+}
+
+void host_chip_disable_txq(struct host_chip *host) {
+    host->stats.tx_dropped += host->txq.frames;
+    host->txq.frames = 0;
+    host->txq.bytes = 0;
+    host->txq.enabled = 0;
+}
+
+// Offset of the oldest record, skipping the padded end of the storage
+static uint32_t host_txq_head(struct host_txq *q) {
+    if (q->size - q->head < PACKET_LENGTH_FIELD_SIZE) {
+        q->head = 0;
+    } else {
+        uint16_t len;
+        memcpy(&len, q->buf + q->head, sizeof(len));
+        if (len == HOST_TXQ_PAD) {
+            q->head = 0;
+        }
+    }
+    return q->head;
+}
+
+static uint16_t host_txq_len(const struct host_txq *q, uint32_t off) {
+    uint16_t len;
+    memcpy(&len, q->buf + off, sizeof(len));
+    return len;
 }
 
-// Forward declaration
-void host_chip_process_received_data(void);
+static void host_txq_pop(struct host_txq *q) {
+    uint32_t off = host_txq_head(q);
+    uint16_t len = host_txq_len(q, off);
+    q->head = off + PACKET_LENGTH_FIELD_SIZE + len;
+    q->frames--;
+    q->bytes -= len;
+    if (q->frames == 0) {
+        q->head = 0;
+        q->tail = 0;
+    }
+}
+
+// Where a record of need bytes fits contiguously, or -1. Free space is [tail, head)
+// when tail < head, else [tail, size) plus [0, head); tail == head means full.
+static int64_t host_txq_reserve(const struct host_txq *q, uint32_t need) {
+    if (q->frames == 0) {
+        return 0;
+    }
+    if (q->tail > q->head) {
+        if (q->size - q->tail >= need) {
+            return q->tail;
+        }
+        return (q->head >= need) ? 0 : -1;
+    }
+    if (q->tail < q->head && q->head - q->tail >= need) {
+        return q->tail;
+    }
+    return -1;
+}
+
+static int host_txq_fits(const struct host_txq *q, uint32_t len) {
+    if (q->cfg.max_frames != 0 && q->frames >= q->cfg.max_frames) {
+        return 0;
+    }
+    if (q->cfg.max_bytes != 0 && q->bytes + len > q->cfg.max_bytes) {
+        return 0;
+    }
+    return host_txq_reserve(q, len + PACKET_LENGTH_FIELD_SIZE) >= 0;
+}
+
+// Parks one frame, gathered from its fragments, behind the others; returns 0, or -2
+// if the policy dropped it
+static int host_txq_park(struct host_chip *host, const struct host_tx_frag *frags, unsigned count, uint32_t len) {
+    struct host_txq *q = &host->txq;
+    if (q->cfg.policy == HOST_TXQ_DROP_OLDEST) {
+        while (q->frames > 0 && !host_txq_fits(q, len)) {
+            host_txq_pop(q);
+            host->stats.tx_dropped++;
+        }
+    }
+    if (!host_txq_fits(q, len)) {
+        host->stats.tx_dropped++;
+        SIM_LOG("HOST_TXQ: Queue full (%u frames). Dropped Len: %u.\n", q->frames, len);
+        return -2;
+    }
+
+    uint32_t off = (uint32_t)host_txq_reserve(q, len + PACKET_LENGTH_FIELD_SIZE);
+    if (off == 0 && q->frames > 0 && q->size - q->tail >= PACKET_LENGTH_FIELD_SIZE) {
+        // Wrapped: the reader skips the rest of the storage
+        uint16_t pad = HOST_TXQ_PAD;
+        memcpy(q->buf + q->tail, &pad, sizeof(pad));
+    }
+    uint16_t len16 = (uint16_t)len;
+    memcpy(q->buf + off, &len16, sizeof(len16));
+    q->tail = off + PACKET_LENGTH_FIELD_SIZE;
+    for (unsigned i = 0; i < count; i++) {
+        memcpy(q->buf + q->tail, frags[i].data, frags[i].len);
+        q->tail += frags[i].len;
+    }
+    q->frames++;
+    q->bytes += len;
+    if (q->frames > q->peak_frames) {
+        q->peak_frames = q->frames;
+    }
+    host->stats.tx_queued++;
+    return 0;
+}
+
+unsigned host_chip_txq_drain(struct host_chip *host) {
+    struct host_txq *q = &host->txq;
+    uint32_t space = tx_ring_free(host->tx_head, BUS_READ_REG(host->bus.regs, CHIP_REG_TX_TAIL_PTR));
+    unsigned sent = 0;
+
+    while (q->frames > 0) {
+        uint32_t off = host_txq_head(q);
+        uint16_t len = host_txq_len(q, off);
+        // Checked here so a drain that stops at a full ring is not counted as a rejected send
+        if ((uint32_t)len + PACKET_LENGTH_FIELD_SIZE > space) {
+            break;
+        }
+        if (host_chip_queue_packet(host, q->buf + off + PACKET_LENGTH_FIELD_SIZE, len) != 0) {
+            break; // BQL limit, or TX completion ring full
+        }
+        space -= len + PACKET_LENGTH_FIELD_SIZE;
+        host_txq_pop(q);
+        sent++;
+    }
+
+    if (sent > 0) {
+        host_chip_tx_kick(host);
+        SIM_LOG("HOST_TXQ: Drained %u frames, %u still queued.\n", sent, q->frames);
+    }
+    return sent;
+}
+
+// Returns 0 on success, <0 on error
+int host_chip_send_packetv(struct host_chip *host, const struct host_tx_frag *frags, unsigned count) {
+    uint32_t len = host_tx_frags_len(frags, count);
+    if (host->txq.enabled && host->txq.frames > 0) {
+        // Space discovered on the next send: parked frames go first, in order
+        host_chip_txq_drain(host);
+        if (host->txq.frames > 0) {
+            if (len == UINT32_MAX || len + PACKET_LENGTH_FIELD_SIZE > TX_BUFFER_SIZE) {
+                return -1; // Would never fit the ring
+            }
+            return host_txq_park(host, frags, count, len);
+        }
+    }
+
+    int rc = host_tx_queue(host, frags, count, len, NULL, 0);
+    if (rc == 0) {
+        host_chip_tx_kick(host);
+    } else if (rc == -2 && host->txq.enabled) {
+        rc = host_txq_park(host, frags, count, len);
+    }
+    return rc;
+}
+
+int host_chip_send_packet(struct host_chip *host, const uint8_t *data, uint32_t len) {
+    struct host_tx_frag frag = { data, len };
+    return host_chip_send_packetv(host, &frag, 1);
+}
+
+int host_chip_queue_packet_tso(struct host_chip *host, const struct host_tx_frag *frags, unsigned count,
+                               const struct tx_tso_params *tso, uint32_t cookie) {
+    return host_tx_queue(host, frags, count, host_tx_frags_len(frags, count), tso, cookie);
+}
+
+int host_chip_send_packet_tso(struct host_chip *host, const struct host_tx_frag *frags, unsigned count,
+                              const struct tx_tso_params *tso) {
+    int rc = host_chip_queue_packet_tso(host, frags, count, tso, 0);
+    if (rc == 0) {
+        host_chip_tx_kick(host);
+    }
+    return rc;
+}
+
+int host_chip_send_packet_cookie(struct host_chip *host, const uint8_t *data, uint32_t len, uint32_t cookie) {
+    int rc = host_chip_queue_packet_cookie(host, data, len, cookie);
+    if (rc == 0) {
+        host_chip_tx_kick(host);
+    }
+    return rc;
+}
+
+uint32_t host_chip_tx_inflight(const struct host_chip *host) {
+    return tx_ring_used(host->tx_head, BUS_READ_REG(host->bus.regs, CHIP_REG_TX_TAIL_PTR));
+}
+
+// --- TX Completions ---
+// The CHIP's completion head survives disabling, so enabling simply continues from it:
+// the next frame queued gets the cookie slot the CHIP will complete next.
+int host_chip_enable_tx_completions(struct host_chip *host, host_tx_complete_fn fn, void *ctx) {
+    if (host->tx_head != BUS_READ_REG(host->bus.regs, CHIP_REG_TX_TAIL_PTR)) {
+        return -1; // Frames in flight would not match their cookie slots
+    }
+    uint32_t head = BUS_READ_REG(host->bus.regs, CHIP_REG_TX_COMPL_HEAD);
+    host->txc = (struct host_tx_compl){ .enabled = 1, .submitted = head, .tail = head, .seen_head = head,
+                                        .fn = fn, .ctx = ctx };
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_HOST_TX_COMPL_TAIL_PUB, head);
+    BARRIER_DOORBELL();
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_TX_COMPL_CTRL, CHIP_TX_COMPL_CTRL_ENABLE);
+    BARRIER_DOORBELL();
+    return 0;
+}
+
+void host_chip_disable_tx_completions(struct host_chip *host) {
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_TX_COMPL_CTRL, 0);
+    BARRIER_DOORBELL();
+    host->txc.enabled = 0;
+    host->txc.fn = NULL;
+}
+
+unsigned host_chip_reap_tx_completions(struct host_chip *host, struct tx_completion *out, unsigned max) {
+    struct host_tx_compl *txc = &host->txc;
+    uint32_t head = BUS_READ_REG(host->bus.regs, CHIP_REG_TX_COMPL_HEAD);
+    uint32_t avail = head - txc->tail;
+    if (avail == 0 || max == 0) {
+        return 0;
+    }
+
+    // Invalidate only the entries written since the last look
+    if (head != txc->seen_head) {
+        dcache_ring_range(mock_dcache_invalidate_range, host->bus.dcache_ctx, TX_COMPL_RING_START_ADDR,
+                          TX_COMPL_RING_SIZE, (txc->seen_head & (TX_COMPL_RING_ENTRIES - 1)) * TX_COMPL_ENTRY_SIZE,
+                          (head - txc->seen_head) * TX_COMPL_ENTRY_SIZE);
+        txc->seen_head = head;
+    }
+    BARRIER_RING_OBSERVE();
+
+    uint32_t n = (avail < max) ? avail : max;
+    uint32_t slot = txc->tail & (TX_COMPL_RING_ENTRIES - 1);
+    uint32_t first = (n < TX_COMPL_RING_ENTRIES - slot) ? n : TX_COMPL_RING_ENTRIES - slot;
+    memcpy(out, host->bus.tx_compl_ring + slot, first * sizeof(*out));
+    memcpy(out + first, host->bus.tx_compl_ring, (n - first) * sizeof(*out));
+    cache_sim_ring_access(host->bus.dcache_ctx, CACHE_SIM_HOST, TX_COMPL_RING_START_ADDR, TX_COMPL_RING_SIZE,
+                          slot * TX_COMPL_ENTRY_SIZE, n * TX_COMPL_ENTRY_SIZE, 0);
+
+    // Release the slots to the CHIP in one publish
+    txc->tail += n;
+    BARRIER_RING_RELEASE();
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_HOST_TX_COMPL_TAIL_PUB, txc->tail);
+    BARRIER_DOORBELL();
+
+    host->stats.tx_completed += n;
+    SIM_LOG("HOST_TX: Reaped %u TX completions.\n", n);
+
+    // Frames parked because the completion ring was full can move now
+    if (host->txq.enabled) {
+        host_chip_txq_drain(host);
+    }
+    return n;
+}
+
+// --- Byte Queue Limits ---
+int host_chip_enable_bql(struct host_chip *host, const struct host_bql_config *cfg) {
+    static const struct host_bql_config defaults = HOST_BQL_DEFAULT_CONFIG;
+    const struct host_bql_config *c = (cfg != NULL) ? cfg : &defaults;
+    if (c->min_limit > c->max_limit || c->max_limit >= TX_BUFFER_SIZE || c->slack_hold == 0) {
+        return -1;
+    }
+
+    struct host_bql *bql = &host->bql;
+    memset(bql, 0, sizeof(*bql));
+    bql->cfg = *c;
+    bql->limit = c->min_limit;
+    bql->lowest_slack = UINT32_MAX;
+    // Whatever is in flight now counts as queued under the new limit
+    bql->completed_tail = BUS_READ_REG(host->bus.regs, CHIP_REG_TX_TAIL_PTR);
+    bql->num_queued = tx_ring_used(host->tx_head, bql->completed_tail);
+    bql->prev_num_queued = bql->num_queued;
+    bql->adj_limit = bql->limit;
+    bql->enabled = 1;
+    return 0;
+}
+
+void host_chip_disable_bql(struct host_chip *host) {
+    host->bql.enabled = 0;
+}
+
+#define BQL_POSDIFF(a, b)           (((int32_t)((a) - (b)) > 0) ? (a) - (b) : 0U)
+
+// Accounts what the CHIP consumed since the last completion and adapts the limit
+static void host_bql_completed(struct host_chip *host) {
+    struct host_bql *bql = &host->bql;
+    uint32_t tail = BUS_READ_REG(host->bus.regs, CHIP_REG_TX_TAIL_PTR);
+    uint32_t count = tx_ring_used(tail, bql->completed_tail);
+    bql->completed_tail = tail;
+
+    uint32_t num_queued = bql->num_queued;
+    uint32_t completed = bql->num_completed + count;
+    uint32_t limit = bql->limit;
+    uint32_t ovlimit = BQL_POSDIFF(num_queued - bql->num_completed, limit);
+    uint32_t inprogress = num_queued - completed;
+    uint32_t prev_inprogress = bql->prev_num_queued - bql->num_completed;
+    int all_prev_completed = (int32_t)(completed - bql->prev_num_queued) >= 0;
+
+    if ((ovlimit && !inprogress) || (bql->prev_ovlimit && all_prev_completed)) {
+        // Starved: the limit held frames back and the CHIP ran out of work
+        limit += BQL_POSDIFF(completed, bql->prev_num_queued) + bql->prev_ovlimit;
+        bql->lowest_slack = UINT32_MAX;
+        bql->slack_events = 0;
+    } else if (inprogress && prev_inprogress && !all_prev_completed) {
+        // Not starved: measure the slack, shrink once it persisted slack_hold times
+        uint32_t slack = BQL_POSDIFF(limit + bql->prev_ovlimit, 2 * (completed - bql->num_completed));
+        uint32_t slack_last_objs = bql->prev_ovlimit ? BQL_POSDIFF(bql->prev_last_obj_cnt, bql->prev_ovlimit) : 0;
+        if (slack_last_objs > slack) {
+            slack = slack_last_objs;
+        }
+        if (slack < bql->lowest_slack) {
+            bql->lowest_slack = slack;
+        }
+        if (++bql->slack_events >= bql->cfg.slack_hold) {
+            limit = BQL_POSDIFF(limit, bql->lowest_slack);
+            bql->lowest_slack = UINT32_MAX;
+            bql->slack_events = 0;
+        }
+    }
+
+    if (limit < bql->cfg.min_limit) {
+        limit = bql->cfg.min_limit;
+    } else if (limit > bql->cfg.max_limit) {
+        limit = bql->cfg.max_limit;
+    }
+    if (limit != bql->limit) {
+        if (limit > bql->limit) {
+            bql->increases++;
+        } else {
+            bql->decreases++;
+        }
+        SIM_LOG("HOST_BQL: Limit %u -> %u bytes.\n", bql->limit, limit);
+        bql->limit = limit;
+        ovlimit = 0;
+    }
+
+    bql->adj_limit = limit + completed;
+    bql->prev_ovlimit = ovlimit;
+    bql->prev_last_obj_cnt = bql->last_obj_cnt;
+    bql->num_completed = completed;
+    bql->prev_num_queued = num_queued;
+}
 
 // --- HOST Receive Interrupt Handler ---
-void host_chip_irq_handler() {
-    uint32_t int_status = BUS_READ_REG(CHIP_REG_INT_STATUS);
+void host_chip_irq_handler(struct host_chip *host) {
+    uint32_t int_status = BUS_READ_REG(host->bus.regs, CHIP_REG_INT_STATUS);
+    // Ack everything seen with one write: the CHIP applies INT_CLEAR lazily, so a
+    // second write before it does would replace the first instead of adding to it
+    if (int_status != 0) {
+        BUS_WRITE_REG(host->bus.regs, CHIP_REG_INT_CLEAR, int_status);
+    }
 
     // Process Rx Data Ready interrupt
     if (int_status & CHIP_INT_RX_DATA_READY_BIT) {
-        BUS_WRITE_REG(CHIP_REG_INT_CLEAR, CHIP_INT_RX_DATA_READY_BIT);
-        printf("HOST_RX_ISR: RX Data Ready Interrupt.\n");
-        host_chip_process_received_data();
+        SIM_LOG("HOST_RX_ISR: RX Data Ready Interrupt.\n");
+        host_chip_process_received_data(host);
     }
 
     // Process Tx Space Available interrupt (optional)
     if (int_status & CHIP_INT_TX_SPACE_AVAIL_BIT) {
-        BUS_WRITE_REG(CHIP_REG_INT_CLEAR, CHIP_INT_TX_SPACE_AVAIL_BIT);
-        printf("HOST_TX_ISR: TX Space Available Interrupt.\n");
+        SIM_LOG("HOST_TX_ISR: TX Space Available Interrupt.\n");
+        if (host->bql.enabled) {
+            host_bql_completed(host);
+        }
+        if (host->txq.enabled) {
+            host_chip_txq_drain(host);
+        }
+    }
+
+    // Process TX Complete interrupt: hand finished frames back to their owner
+    if (int_status & CHIP_INT_TX_COMPLETE_BIT) {
+        SIM_LOG("HOST_TX_ISR: TX Complete Interrupt.\n");
+        if (host->txc.fn != NULL) {
+            struct tx_completion batch[HOST_TX_COMPL_BATCH];
+            unsigned n;
+            while ((n = host_chip_reap_tx_completions(host, batch, HOST_TX_COMPL_BATCH)) > 0) {
+                host->txc.fn(host->txc.ctx, batch, n);
+            }
+        }
+    }
+
+    // Process RX Overflow interrupt: account the loss and make room
+    if (int_status & CHIP_INT_RX_OVERFLOW_BIT) {
+        uint32_t drops = BUS_READ_REG(host->bus.regs, CHIP_REG_RX_DROP_COUNT);
+        host->stats.rx_dropped += drops - host->rx_drop_seen; // The counter wraps
+        SIM_LOG("HOST_RX_ISR: RX Overflow Interrupt. %u frames dropped.\n", drops - host->rx_drop_seen);
+        host->rx_drop_seen = drops;
+        if (!(int_status & CHIP_INT_RX_DATA_READY_BIT)) {
+            host_chip_process_received_data(host);
+        }
     }
 
     // Process Error interrupt
     if (int_status & CHIP_INT_ERROR_BIT) {
-        BUS_WRITE_REG(CHIP_REG_INT_CLEAR, CHIP_INT_ERROR_BIT);
-        printf("HOST_ERR_ISR: CHIP Error Interrupt! Status: 0x%x\n", int_status);
+        SIM_LOG("HOST_ERR_ISR: CHIP Error Interrupt! Status: 0x%x\n", int_status);
     }
 }
 
-// --- HOST Receive Processing Function ---
-void host_chip_process_received_data() {
-    uint32_t current_rx_tail = host_rx_tail;
-    uint32_t chip_rx_head = BUS_READ_REG(CHIP_REG_RX_HEAD_PTR); // Get CHIP's current written position
+// Reads the CHIP's RX head and makes the data it published since the last call
+// visible: the D-cache is invalidated only for that new range, line-rounded and
+// merged into at most two calls (the range may wrap).
+static uint32_t host_rx_observe_head(struct host_chip *host) {
+    uint32_t chip_rx_head = BUS_READ_REG(host->bus.regs, CHIP_REG_RX_HEAD_PTR);
+    if (chip_rx_head == host->rx_seen_head) {
+        return chip_rx_head;
+    }
 
-    // Invalidate D-Cache for the potential new data in the Rx buffer.
-    mock_dcache_invalidate_range((uintptr_t)rx_buffer_ptr, RX_BUFFER_SIZE);
-    DMB(); // Ensure invalidate completes before memory access
+    dcache_batch_add_ring(&host->rx_inval_batch, RX_BUFFER_START_ADDR, RX_BUFFER_SIZE,
+                          host->rx_seen_head, rx_ring_used(chip_rx_head, host->rx_seen_head));
+    dcache_batch_flush(&host->rx_inval_batch);
+    host->rx_seen_head = chip_rx_head;
+    BARRIER_RING_OBSERVE(); // Ensure invalidate completes before memory access
+    return chip_rx_head;
+}
 
-    while (current_rx_tail != chip_rx_head) {
-        uint32_t bytes_available;
-        if (chip_rx_head >= current_rx_tail) {
-            bytes_available = chip_rx_head - current_rx_tail;
+// --- Batched RX Delivery ---
+int host_chip_set_rx_handler(struct host_chip *host, host_rx_deliver_fn fn, void *ctx, unsigned batch) {
+    if (fn != NULL && (batch == 0 || batch > HOST_RX_BATCH_MAX)) {
+        return -1;
+    }
+    host->rx_deliver = fn;
+    host->rx_deliver_ctx = ctx;
+    host->rx_batch = batch;
+    host->rx_desc_count = 0;
+    return 0;
+}
+
+static void host_rx_split_recycle_batch(struct host_chip *host);
+
+// Hands the collected descriptors to the upper stack in one call
+static void host_rx_deliver_batch(struct host_chip *host) {
+    if (host->rx_desc_count == 0) {
+        return;
+    }
+    host->rx_deliver(host->rx_deliver_ctx, host->rx_descs, host->rx_desc_count);
+    host->stats.rx_batches++;
+    host->rx_desc_count = 0;
+    host->gro.pending = 0; // GRO buffers are free for the next merge
+    host_rx_split_recycle_batch(host);
+}
+
+// Adds one descriptor to the pending batch
+static struct host_rx_desc *host_rx_add_desc(struct host_chip *host, uint32_t frame_off, const uint8_t *data,
+                                             uint32_t len, uint32_t flags, uint32_t segs) {
+    struct host_rx_desc *desc = &host->rx_descs[host->rx_desc_count++];
+    desc->data = data;
+    desc->len = len;
+    desc->ring_off = frame_off;
+    desc->flags = flags;
+    desc->segs = segs;
+    desc->payload = NULL;
+    desc->payload_len = 0;
+    desc->buf = RX_SPLIT_NO_BUF;
+    return desc;
+}
+
+// Adds one descriptor to the pending batch, delivering the batch once it is full
+static void host_rx_push_desc(struct host_chip *host, uint32_t frame_off, const uint8_t *data, uint32_t len,
+                              uint32_t flags, uint32_t segs) {
+    host_rx_add_desc(host, frame_off, data, len, flags, segs);
+    if (host->rx_desc_count == host->rx_batch) {
+        host_rx_deliver_batch(host);
+    }
+}
+
+// Adds one frame to the pending batch. A frame that wraps around the end of the
+// ring is copied to the bounce buffer so the consumer always sees contiguous data;
+// a batch holds at most one such frame, since one drain covers at most one lap.
+static void host_rx_queue_desc(struct host_chip *host, uint32_t frame_off, uint32_t payload_off, uint32_t len) {
+    if (rx_ring_contig(payload_off, len) < len) {
+        rx_ring_read(host->bus.rx_ring, payload_off, host->rx_bounce, len);
+        host->stats.rx_bounced++;
+        host_rx_push_desc(host, frame_off, host->rx_bounce, len, HOST_RX_DESC_BOUNCED, 1);
+    } else {
+        host_rx_push_desc(host, frame_off, host->bus.rx_ring + payload_off, len, 0, 1);
+    }
+}
+
+// --- RX Coalescing (GRO) ---
+#define HOST_GRO_ETH_LEN            14
+#define HOST_GRO_TCP_OFF            (HOST_GRO_ETH_LEN + 20)
+#define HOST_GRO_MIN_HDR            (HOST_GRO_TCP_OFF + 20)
+#define HOST_GRO_TCP_ACK            0x10
+#define HOST_GRO_TCP_PSH            0x08
+
+int host_chip_enable_gro(struct host_chip *host, const struct host_gro_config *cfg, uint8_t *storage, uint32_t size) {
+    static const struct host_gro_config defaults = HOST_GRO_DEFAULT_CONFIG;
+    const struct host_gro_config *c = (cfg != NULL) ? cfg : &defaults;
+    if (storage == NULL || c->max_bytes < HOST_GRO_HDR_MAX || c->max_bytes > UINT16_MAX ||
+        size / HOST_GRO_FLOWS < c->max_bytes) {
+        return -1;
+    }
+
+    struct host_gro *g = &host->gro;
+    memset(g, 0, sizeof(*g));
+    g->cfg = *c;
+    g->buf = storage;
+    g->enabled = 1;
+    return 0;
+}
+
+void host_chip_disable_gro(struct host_chip *host) {
+    host->gro.enabled = 0; // Nothing is held between drains
+}
+
+static uint32_t host_gro_get16(const uint8_t *p) {
+    return ((uint32_t)p[0] << 8) | p[1];
+}
+
+static uint32_t host_gro_get32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// The fields of a TCP/IPv4 frame that GRO looks at
+struct host_gro_frame {
+    uint32_t saddr;
+    uint32_t daddr;
+    uint32_t ports;
+    uint32_t seq;
+    uint32_t ack;
+    uint32_t hdr_len;
+    uint8_t tcp_flags;
+    int mergeable;           // Plain data segment: only ACK/PSH, unfragmented, no padding
+};
+
+// Parses the headers h of a frame of len bytes; returns 0 unless it is TCP over
+// IPv4 (no IP options) over Ethernet II
+static int host_gro_parse(const uint8_t *h, uint32_t len, struct host_gro_frame *f) {
+    if (len < HOST_GRO_MIN_HDR || h[12] != 0x08 || h[13] != 0x00 || h[14] != 0x45 || h[23] != 6) {
+        return 0;
+    }
+    f->hdr_len = HOST_GRO_TCP_OFF + (uint32_t)(h[HOST_GRO_TCP_OFF + 12] >> 4) * 4;
+    if (f->hdr_len < HOST_GRO_MIN_HDR || f->hdr_len > len) {
+        return 0;
+    }
+    f->saddr = host_gro_get32(h + 26);
+    f->daddr = host_gro_get32(h + 30);
+    f->ports = host_gro_get32(h + HOST_GRO_TCP_OFF);
+    f->seq = host_gro_get32(h + HOST_GRO_TCP_OFF + 4);
+    f->ack = host_gro_get32(h + HOST_GRO_TCP_OFF + 8);
+    f->tcp_flags = h[HOST_GRO_TCP_OFF + 13];
+    f->mergeable = (host_gro_get16(h + 20) & 0x3FFF) == 0 &&                   // Not a fragment
+                   host_gro_get16(h + 16) == len - HOST_GRO_ETH_LEN &&           // No padding
+                   (f->tcp_flags & ~(HOST_GRO_TCP_ACK | HOST_GRO_TCP_PSH)) == 0 &&
+                   (f->tcp_flags & HOST_GRO_TCP_ACK) != 0 && len > f->hdr_len;
+    return 1;
+}
+
+static unsigned host_gro_slot(const struct host_gro_frame *f) {
+    return ((f->saddr ^ f->daddr ^ f->ports) * 0x9E3779B1U) >> 24 & (HOST_GRO_FLOWS - 1);
+}
+
+static uint8_t *host_gro_buf(struct host_chip *host, unsigned slot) {
+    return host->gro.buf + (size_t)slot * host->gro.cfg.max_bytes;
+}
+
+// Whether frame f (headers h) continues the flow held in slot within the limits
+static int host_gro_can_merge(struct host_chip *host, unsigned slot, const struct host_gro_frame *f,
+                              const uint8_t *h, uint32_t len) {
+    const struct host_gro_flow *fl = &host->gro.flows[slot];
+    const struct host_gro_config *c = &host->gro.cfg;
+    if (f->seq != fl->next_seq || f->ack != fl->ack || f->hdr_len != fl->hdr_len ||
+        fl->len + (len - f->hdr_len) > c->max_bytes || (c->max_segs != 0 && fl->segs >= c->max_segs)) {
+        return 0;
+    }
+    if (f->hdr_len > HOST_GRO_MIN_HDR) {
+        // TCP options must match the held frame's
+        uint8_t held[HOST_GRO_HDR_MAX];
+        if (fl->segs > 1) {
+            memcpy(held, host_gro_buf(host, slot), f->hdr_len);
         } else {
-            bytes_available = RX_BUFFER_SIZE - current_rx_tail + chip_rx_head;
+            rx_ring_read(host->bus.rx_ring, fl->payload_off, held, f->hdr_len);
         }
+        if (memcmp(held + HOST_GRO_MIN_HDR, h + HOST_GRO_MIN_HDR, f->hdr_len - HOST_GRO_MIN_HDR) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
 
-        if (bytes_available < PACKET_LENGTH_FIELD_SIZE) {
-            printf("HOST_RX: Not enough for header. Avail: %u.\n", bytes_available);
-            break;
+// Appends the payload of the frame at payload_off to the flow in slot
+static void host_gro_merge(struct host_chip *host, unsigned slot, const struct host_gro_frame *f,
+                           uint32_t payload_off, uint32_t len) {
+    struct host_gro_flow *fl = &host->gro.flows[slot];
+    uint8_t *buf = host_gro_buf(host, slot);
+    if (fl->segs == 1) {
+        if (host->gro.pending & (1U << slot)) {
+            host_rx_deliver_batch(host); // The buffer still backs a descriptor
         }
+        rx_ring_read(host->bus.rx_ring, fl->payload_off, buf, fl->len);
+    }
+    uint32_t seg_len = len - f->hdr_len;
+    rx_ring_read(host->bus.rx_ring, rx_ring_wrap(payload_off + f->hdr_len), buf + fl->len, seg_len);
+    buf[HOST_GRO_TCP_OFF + 13] |= f->tcp_flags & HOST_GRO_TCP_PSH;
+    fl->len += seg_len;
+    fl->next_seq += seg_len;
+    fl->segs++;
+    host->stats.rx_gro_merged++;
+}
 
-        // --- Read Packet Length Header ---
-        uint16_t packet_payload_len;
-        uint32_t header_offset = current_rx_tail;
+// Queues what the flow in slot holds for delivery and frees the slot
+static void host_gro_flush(struct host_chip *host, unsigned slot) {
+    struct host_gro_flow *fl = &host->gro.flows[slot];
+    if (fl->segs == 1) {
+        host_rx_queue_desc(host, fl->frame_off, fl->payload_off, fl->len);
+    } else {
+        uint8_t *buf = host_gro_buf(host, slot);
+        buf[16] = (uint8_t)((fl->len - HOST_GRO_ETH_LEN) >> 8);
+        buf[17] = (uint8_t)(fl->len - HOST_GRO_ETH_LEN);
+        host->gro.pending |= 1U << slot; // Before the push, which may deliver at once
+        host_rx_push_desc(host, fl->frame_off, buf, fl->len, HOST_RX_DESC_GRO, fl->segs);
+        SIM_LOG("HOST_GRO: Flushed %u frames, %u bytes.\n", fl->segs, fl->len);
+    }
+    fl->segs = 0;
+}
 
-        if ((header_offset + PACKET_LENGTH_FIELD_SIZE) > RX_BUFFER_SIZE) {
-            uint8_t byte0 = rx_buffer_ptr[header_offset];
-            uint8_t byte1 = rx_buffer_ptr[0];
-            packet_payload_len = (uint16_t)byte0 | ((uint16_t)byte1 << 8); // Assuming little-endian
-        } else {
-            packet_payload_len = *(uint16_t*)(rx_buffer_ptr + header_offset);
+static void host_gro_flush_all(struct host_chip *host) {
+    for (unsigned i = 0; i < HOST_GRO_FLOWS; i++) {
+        if (host->gro.flows[i].segs > 0) {
+            host_gro_flush(host, i);
+        }
+    }
+}
+
+// Takes one frame in place of host_rx_queue_desc(): it joins its flow, starts one, or
+// is queued as it is
+static void host_gro_receive(struct host_chip *host, uint32_t frame_off, uint32_t payload_off, uint32_t len) {
+    uint8_t copy[HOST_GRO_HDR_MAX];
+    uint32_t hdr_bytes = (len < HOST_GRO_HDR_MAX) ? len : HOST_GRO_HDR_MAX;
+    const uint8_t *h = host->bus.rx_ring + payload_off;
+    if (rx_ring_contig(payload_off, hdr_bytes) < hdr_bytes) {
+        rx_ring_read(host->bus.rx_ring, payload_off, copy, hdr_bytes);
+        h = copy;
+    }
+
+    struct host_gro_frame f;
+    if (!host_gro_parse(h, len, &f)) {
+        host_rx_queue_desc(host, frame_off, payload_off, len);
+        return;
+    }
+
+    unsigned slot = host_gro_slot(&f);
+    struct host_gro_flow *fl = &host->gro.flows[slot];
+    if (fl->segs > 0 && fl->saddr == f.saddr && fl->daddr == f.daddr && fl->ports == f.ports) {
+        if (f.mergeable && host_gro_can_merge(host, slot, &f, h, len)) {
+            host_gro_merge(host, slot, &f, payload_off, len);
+            if ((f.tcp_flags & HOST_GRO_TCP_PSH) != 0) {
+                host_gro_flush(host, slot);
+            }
+            return;
         }
+        host_gro_flush(host, slot); // Keeps the flow's frames in order
+    }
+    if (!f.mergeable || (f.tcp_flags & HOST_GRO_TCP_PSH) != 0) {
+        host_rx_queue_desc(host, frame_off, payload_off, len);
+        return;
+    }
+    if (fl->segs > 0) {
+        host_gro_flush(host, slot); // Another flow in the same entry
+    }
+
+    fl->saddr = f.saddr;
+    fl->daddr = f.daddr;
+    fl->ports = f.ports;
+    fl->next_seq = f.seq + (len - f.hdr_len);
+    fl->ack = f.ack;
+    fl->hdr_len = (uint16_t)f.hdr_len;
+    fl->segs = 1;
+    fl->len = len;
+    fl->frame_off = frame_off;
+    fl->payload_off = payload_off;
+}
+
+// --- RX Header Split ---
+// Puts pool buffer buf in the fill ring; published with host_rx_split_publish_fill()
+static void host_rx_split_fill(struct host_chip *host, uint32_t buf) {
+    struct host_rx_split *rs = &host->rxs;
+    uint32_t slot = rs->fill_head & (RX_SPLIT_BUFS - 1);
+    host->bus.rx_split_fill[slot] = (uint16_t)buf;
+    cache_sim_ring_access(host->bus.dcache_ctx, CACHE_SIM_HOST, RX_SPLIT_FILL_START_ADDR, RX_SPLIT_FILL_SIZE,
+                          slot * 2, 2, 1);
+    rs->fill_head++;
+}
+
+// Cleans the fill ring slots written since the last publish and publishes them
+static void host_rx_split_publish_fill(struct host_chip *host) {
+    struct host_rx_split *rs = &host->rxs;
+    if (rs->fill_head == rs->fill_head_pub) {
+        return;
+    }
+    dcache_ring_range(mock_dcache_clean_range, host->bus.dcache_ctx, RX_SPLIT_FILL_START_ADDR, RX_SPLIT_FILL_SIZE,
+                      (rs->fill_head_pub & (RX_SPLIT_BUFS - 1)) * 2, (rs->fill_head - rs->fill_head_pub) * 2);
+    BARRIER_RING_PUBLISH();
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_HOST_RX_FILL_HEAD_PUB, rs->fill_head);
+    BARRIER_DOORBELL();
+    rs->fill_head_pub = rs->fill_head;
+}
 
+// Returns the buffers of the batch just delivered that the stack did not take
+static void host_rx_split_recycle_batch(struct host_chip *host) {
+    uint64_t bufs = host->rxs.batch_bufs;
+    host->rxs.batch_bufs = 0;
+    for (uint32_t buf = 0; bufs != 0; buf++, bufs >>= 1) {
+        if (bufs & 1) {
+            host_rx_split_fill(host, buf);
+        }
+    }
+}
+
+int host_chip_enable_rx_split(struct host_chip *host, uint32_t hdr_len) {
+    struct host_rx_split *rs = &host->rxs;
+    if (rs->enabled || hdr_len == 0 || hdr_len > RX_SPLIT_HDR_MAX ||
+        host->rx_tail != BUS_READ_REG(host->bus.regs, CHIP_REG_RX_HEAD_PTR)) {
+        return -1;
+    }
+
+    // The CHIP's entry head survives disabling, as do the buffers left in the fill ring
+    uint32_t head = BUS_READ_REG(host->bus.regs, CHIP_REG_RX_SPLIT_HEAD);
+    rs->hdr_len = hdr_len;
+    rs->tail = head;
+    rs->seen_head = head;
+    if (!rs->primed) {
+        for (uint32_t buf = 0; buf < RX_SPLIT_BUFS; buf++) {
+            host_rx_split_fill(host, buf);
+        }
+        rs->primed = 1;
+    }
+    host_rx_split_publish_fill(host);
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_HOST_RX_SPLIT_TAIL_PUB, head);
+    BARRIER_DOORBELL();
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_RX_SPLIT_CTRL,
+                  CHIP_RX_SPLIT_CTRL_ENABLE | (hdr_len << CHIP_RX_SPLIT_CTRL_HDR_SHIFT));
+    BARRIER_DOORBELL();
+    rs->enabled = 1;
+    return 0;
+}
+
+static void host_rx_split_process(struct host_chip *host);
+
+void host_chip_disable_rx_split(struct host_chip *host) {
+    if (!host->rxs.enabled) {
+        return;
+    }
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_RX_SPLIT_CTRL, 0);
+    BARRIER_DOORBELL();
+    host_rx_split_process(host); // The CHIP writes no more entries
+    host->rxs.enabled = 0;
+}
+
+int host_chip_rx_split_take(struct host_chip *host, uint32_t buf) {
+    uint64_t bit = 1ULL << (buf & 63);
+    if (buf >= RX_SPLIT_BUFS || !(host->rxs.batch_bufs & bit)) {
+        return -1;
+    }
+    host->rxs.batch_bufs &= ~bit;
+    host->rxs.taken |= bit;
+    return 0;
+}
+
+int host_chip_rx_split_release(struct host_chip *host, const uint32_t *bufs, unsigned count) {
+    int rc = 0;
+    for (unsigned i = 0; i < count; i++) {
+        uint64_t bit = 1ULL << (bufs[i] & 63);
+        if (bufs[i] >= RX_SPLIT_BUFS || !(host->rxs.taken & bit)) {
+            rc = -1;
+            continue;
+        }
+        host->rxs.taken &= ~bit;
+        host_rx_split_fill(host, bufs[i]);
+    }
+    host_rx_split_publish_fill(host);
+    return rc;
+}
+
+// Reads the CHIP's entry head and invalidates the entries written since the last call
+static uint32_t host_rx_split_observe_head(struct host_chip *host) {
+    struct host_rx_split *rs = &host->rxs;
+    uint32_t head = BUS_READ_REG(host->bus.regs, CHIP_REG_RX_SPLIT_HEAD);
+    if (head != rs->seen_head) {
+        dcache_ring_range(mock_dcache_invalidate_range, host->bus.dcache_ctx, RX_SPLIT_RING_START_ADDR,
+                          RX_SPLIT_RING_SIZE, (rs->seen_head & (RX_SPLIT_ENTRIES - 1)) * RX_SPLIT_ENTRY_SIZE,
+                          (head - rs->seen_head) * RX_SPLIT_ENTRY_SIZE);
+        rs->seen_head = head;
+    }
+    BARRIER_RING_OBSERVE();
+    return head;
+}
+
+// Drain loop of host_chip_process_received_data() for header entries. Only the entry
+// is read here; the payload is invalidated for the stack but left untouched.
+static void host_rx_split_process(struct host_chip *host) {
+    struct host_rx_split *rs = &host->rxs;
+    uint32_t head = host_rx_split_observe_head(host);
+
+    while (rs->tail != head) {
+        uint32_t slot = rs->tail & (RX_SPLIT_ENTRIES - 1);
+        const struct rx_split_entry *e = &host->bus.rx_split_ring[slot];
+        cache_sim_ring_access(host->bus.dcache_ctx, CACHE_SIM_HOST, RX_SPLIT_RING_START_ADDR, RX_SPLIT_RING_SIZE,
+                              slot * RX_SPLIT_ENTRY_SIZE, RX_SPLIT_ENTRY_SIZE, 0);
+        uint32_t len = e->len;
+        uint32_t hdr_len = e->hdr_len;
+        uint32_t buf = e->buf;
+
+        SIM_LOG("HOST_RX: Received Packet (split)! Len: %u. Hdr: %u. Buf: %u.\n", len, hdr_len, buf);
+
+        if (buf != RX_SPLIT_NO_BUF) {
+            mock_dcache_invalidate_range(host->bus.dcache_ctx, RX_SPLIT_POOL_START_ADDR + buf * RX_SPLIT_BUF_SIZE,
+                                         len - hdr_len);
+        }
+        if (host->rx_deliver != NULL) {
+            struct host_rx_desc *desc = host_rx_add_desc(host, slot, e->hdr, hdr_len, HOST_RX_DESC_SPLIT, 1);
+            if (buf != RX_SPLIT_NO_BUF) {
+                desc->payload = host->bus.rx_split_pool + buf * RX_SPLIT_BUF_SIZE;
+                desc->payload_len = len - hdr_len;
+                desc->buf = buf;
+                rs->batch_bufs |= 1ULL << buf;
+            }
+            if (host->rx_desc_count == host->rx_batch) {
+                host_rx_deliver_batch(host);
+            }
+        } else if (buf != RX_SPLIT_NO_BUF) {
+            host_rx_split_fill(host, buf);
+        }
+
+        host->stats.rx_packets++;
+        host->stats.rx_bytes += len;
+        host->stats.rx_split++;
+        rs->tail++;
+        head = host_rx_split_observe_head(host);
+    }
+
+    // Deliver the partial batch before its entries and buffers are handed back
+    if (host->rx_deliver != NULL) {
+        host_rx_deliver_batch(host);
+    }
+
+    BARRIER_RING_RELEASE();
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_HOST_RX_SPLIT_TAIL_PUB, rs->tail);
+    BARRIER_DOORBELL();
+    host_rx_split_publish_fill(host);
+    SIM_LOG("HOST_RX: Finished processing (split). New Tail: %u.\n", rs->tail);
+}
+
+// --- HOST Receive Processing Function ---
+void host_chip_process_received_data(struct host_chip *host) {
+    if (host->rxs.enabled) {
+        host_rx_split_process(host);
+        return;
+    }
+
+    uint32_t current_rx_tail = host->rx_tail;
+    uint32_t chip_rx_head = host_rx_observe_head(host); // Get CHIP's current written position
+
+    while (current_rx_tail != chip_rx_head) {
+        uint32_t bytes_available = rx_ring_used(chip_rx_head, current_rx_tail);
+
+        if (bytes_available < PACKET_LENGTH_FIELD_SIZE) {
+            SIM_LOG("HOST_RX: Not enough for header. Avail: %u.\n", bytes_available);
+            break;
+        }
+
+        // --- Read Packet Length Header ---
+        uint16_t packet_payload_len = rx_ring_read_len16(host->bus.rx_ring, current_rx_tail);
         uint32_t total_packet_len = packet_payload_len + PACKET_LENGTH_FIELD_SIZE;
 
         if (bytes_available < total_packet_len) {
-            printf("HOST_RX: Partial packet. Avail: %u, Needed: %u. Waiting...\n", bytes_available, total_packet_len);
+            SIM_LOG("HOST_RX: Partial packet. Avail: %u, Needed: %u. Waiting...\n", bytes_available, total_packet_len);
             break;
         }
 
+        cache_sim_ring_access(host->bus.dcache_ctx, CACHE_SIM_HOST, RX_BUFFER_START_ADDR, RX_BUFFER_SIZE,
+                              current_rx_tail, total_packet_len, 0);
+
         // --- Process Packet Payload ---
-        uint8_t *packet_start_data_ptr = rx_buffer_ptr + ((current_rx_tail + PACKET_LENGTH_FIELD_SIZE) % RX_BUFFER_SIZE);
+        uint32_t payload_offset = rx_ring_wrap(current_rx_tail + PACKET_LENGTH_FIELD_SIZE);
+        uint8_t *packet_start_data_ptr = host->bus.rx_ring + payload_offset;
 
-        printf("HOST_RX: Received Packet! Payload Len: %u. Data Start Offset: %lu. (First byte: 0x%02x)\n",
-               packet_payload_len, (current_rx_tail + PACKET_LENGTH_FIELD_SIZE) % RX_BUFFER_SIZE, *packet_start_data_ptr);
+        SIM_LOG("HOST_RX: Received Packet! Payload Len: %u. Data Start Offset: %u. (First byte: 0x%02x)\n",
+               packet_payload_len, payload_offset, *packet_start_data_ptr);
 
-        // Here, pass the packet to the higher-level networking stack
-        // e.g., network_stack_receive(packet_start_data_ptr, packet_payload_len);
+        // Pass the packet to the higher-level networking stack, batched (and coalesced)
+        if (host->rx_deliver != NULL) {
+            if (host->gro.enabled) {
+                host_gro_receive(host, current_rx_tail, payload_offset, packet_payload_len);
+            } else {
+                host_rx_queue_desc(host, current_rx_tail, payload_offset, packet_payload_len);
+            }
+        }
+
+        host->stats.rx_packets++;
+        host->stats.rx_bytes += packet_payload_len;
 
         // Update local tail pointer to mark this packet as consumed
-        current_rx_tail = (current_rx_tail + total_packet_len) % RX_BUFFER_SIZE;
+        current_rx_tail = rx_ring_wrap(current_rx_tail + total_packet_len);
 
         // Update CHIP's head for the next loop iteration (in case it wrote more data)
-        chip_rx_head = BUS_READ_REG(CHIP_REG_RX_HEAD_PTR);
+        chip_rx_head = host_rx_observe_head(host);
     }
 
-    // Publish the updated HOST Rx tail pointer to the CHIP
-    DMB();
-    BUS_WRITE_REG(CHIP_REG_HOST_RX_TAIL_PUB, current_rx_tail);
-    DSB();
-    ISB();
+    // Deliver the partial batch before its frames are handed back to the CHIP
+    if (host->rx_deliver != NULL) {
+        if (host->gro.enabled) {
+            host_gro_flush_all(host);
+        }
+        host_rx_deliver_batch(host);
+    }
+
+    // Publish the updated HOST Rx tail pointer to the CHIP (payload reads done first)
+    BARRIER_RING_RELEASE();
+    BUS_WRITE_REG(host->bus.regs, CHIP_REG_HOST_RX_TAIL_PUB, current_rx_tail);
+    BARRIER_DOORBELL();
 
-    host_rx_tail = current_rx_tail; // Update global HOST tail
-    printf("HOST_RX: Finished processing. New Tail: %u.\n", host_rx_tail);
+    host->rx_tail = current_rx_tail; // Update the instance's HOST tail
+    SIM_LOG("HOST_RX: Finished processing. New Tail: %u.\n", host->rx_tail);
+}
+
+// Stand-in for the upper networking stack: receives frames one batch at a time
+static void host_demo_rx_deliver(void *ctx, const struct host_rx_desc *descs, unsigned count) {
+    (void)ctx;
+    uint32_t bytes = 0;
+    for (unsigned i = 0; i < count; i++) {
+        bytes += descs[i].len;
+    }
+    SIM_LOG("STACK_RX: Delivered batch of %u frames, %u bytes.\n", count, bytes);
 }
 
 // --- Main HOST Application Loop (for simulation) ---
 // In a real embedded system, this would be main(), possibly with an RTOS.
 // For simulation, we integrate it with the emulator.
-// extern void chip_emulator_run_cycle(); // Declared in chip_emulator.c
-extern void chip_emulator_init();
-extern void chip_emulator_run_cycle();
+static void host_main_loop(struct sim_device *dev, struct host_chip *host, struct chip_emulator *chip) {
+    struct host_chip_bus bus;
+    sim_device_host_bus(dev, &bus);
+    host_chip_driver_init(host, &bus);
+    host_chip_set_rx_handler(host, host_demo_rx_deliver, NULL, 8);
+    chip_emulator_init(chip, dev, NULL); // Initialize the emulator
 
-void host_main_loop() {
-    host_chip_driver_init();
-    chip_emulator_init(); // Initialize the emulator
-
-    printf("\n--- HOST and CHIP Simulation Start ---\n");
+    SIM_LOG("\n--- HOST and CHIP Simulation Start ---\n");
 
     // Simulate HOST sending a few packets
     uint8_t test_packet_tx1[] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x01, 0x02, 0x03, 0x04};
-    host_chip_send_packet(test_packet_tx1, sizeof(test_packet_tx1));
+    host_chip_send_packet(host, test_packet_tx1, sizeof(test_packet_tx1));
 
     uint8_t test_packet_tx2[] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0x00, 0xA0, 0xB0};
-    host_chip_send_packet(test_packet_tx2, sizeof(test_packet_tx2));
+    host_chip_send_packet(host, test_packet_tx2, sizeof(test_packet_tx2));
 
     // Simulate a few hundred "cycles" where both HOST and CHIP might run
     for (int cycle = 0; cycle < 50; cycle++) {
-        printf("\n--- Simulation Cycle %d ---\n", cycle);
+        SIM_LOG("\n--- Simulation Cycle %d ---\n", cycle);
 
         // HOST checks for incoming data (via IRQ or polling in simpler designs)
         // In this simulation, we'll manually check and call the handler.
-        host_chip_irq_handler();
+        host_chip_irq_handler(host);
 
         // Simulate CHIP's internal hardware operations (TX processing, RX generation)
-        chip_emulator_run_cycle();
+        chip_emulator_run_cycle(chip);
 
         // HOST can try to send more if space becomes available
         if (cycle % 10 == 0) { // Every 10 cycles, try to send another packet
              uint8_t dynamic_packet[20];
              for(int i = 0; i < 20; i++) dynamic_packet[i] = (uint8_t)(0xDA + i);
-             host_chip_send_packet(dynamic_packet, sizeof(dynamic_packet));
+             host_chip_send_packet(host, dynamic_packet, sizeof(dynamic_packet));
         }
     }
 
-    printf("\n--- Simulation End ---\n");
+    SIM_LOG("\n--- Simulation End ---\n");
 }
 
-int main() {
-    // Initialize the simulated shared RAM (equivalent to main memory)
-    memset(simulated_shared_ram, 0, TOTAL_SHARED_MEMORY_SIZE);
+int main(int argc, char **argv) {
+    sim_device_init(&demo_dev);
+
+    // "--bench ..." runs the benchmark runner instead of the traced demo loop
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return bench_main(argc - 1, argv + 1);
+    }
+
+    // "--idle-report ..." sweeps the CHIP idle model against doorbell strategies
+    if (argc > 1 && strcmp(argv[1], "--idle-report") == 0) {
+        return idle_report_main(argc - 1, argv + 1);
+    }
+
+    // "--phy-report ..." measures TX queueing with the CHIP paced at link rate
+    if (argc > 1 && strcmp(argv[1], "--phy-report") == 0) {
+        return phy_report_main(argc - 1, argv + 1);
+    }
 
-    // Assign global pointers to the correct offsets within the simulated_shared_ram
-    // This is how the BUS_READ_REG/WRITE_REG macros, tx_buffer_ptr, rx_buffer_ptr
-    // will actually access the simulated memory.
-    *(uint8_t**)(&tx_buffer_ptr) = simulated_shared_ram + (TX_BUFFER_START_ADDR - SHARED_RAM_BASE_ADDR);
-    *(uint8_t**)(&rx_buffer_ptr) = simulated_shared_ram + (RX_BUFFER_START_ADDR - SHARED_RAM_BASE_ADDR);
+    // "--aqm-report ..." compares a FIFO against FQ-CoDel above the TX ring
+    if (argc > 1 && strcmp(argv[1], "--aqm-report") == 0) {
+        return aqm_report_main(argc - 1, argv + 1);
+    }
 
+    // "--rx-loss-report ..." measures RX overflow loss per policy and HOST cost
+    if (argc > 1 && strcmp(argv[1], "--rx-loss-report") == 0) {
+        return rx_loss_report_main(argc - 1, argv + 1);
+    }
+
+    // "--ring-report ..." samples ring occupancy and recommends ring sizes
+    if (argc > 1 && strcmp(argv[1], "--ring-report") == 0) {
+        return ring_report_main(argc - 1, argv + 1);
+    }
+
+    // "--bridge ..." attaches external traffic tools to the CHIP side
+    if (argc > 1 && strcmp(argv[1], "--bridge") == 0) {
+        return bridge_main(argc - 1, argv + 1);
+    }
+
+    // "--cache-sim" runs the demo on top of the non-coherent cache model
+    if (argc > 1 && strcmp(argv[1], "--cache-sim") == 0) {
+        cache_sim_enable(&demo_dev.cache, NULL);
+    }
 
-    host_main_loop();
+    host_main_loop(&demo_dev, &demo_host, &demo_chip);
+    cache_sim_print_report(&demo_dev.cache, demo_host.stats.tx_packets + demo_host.stats.rx_packets);
 
     return 0;
 }
@@ -0,0 +1,340 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include "dcache_batch.h"
+
+// --- HOST Driver Statistics ---
+// Counters maintained by the driver so callers (e.g. the benchmark runner) can see
+// what actually crossed the rings without parsing trace output.
+struct host_chip_stats {
+    uint64_t tx_packets;     // Frames successfully written to the TX ring
+    uint64_t tx_bytes;       // Payload bytes successfully written to the TX ring
+    uint64_t tx_ring_full;   // host_chip_send_packet() calls rejected with -2
+    uint64_t tx_queued;      // Frames parked in the software TX queue
+    uint64_t tx_dropped;     // Frames dropped by the software TX queue policy
+    uint64_t tx_doorbells;   // CHIP_REG_HOST_TX_HEAD_PUB writes
+    uint64_t rx_packets;     // Frames consumed from the RX ring
+    uint64_t rx_bytes;       // Payload bytes consumed from the RX ring
+    uint64_t rx_batches;     // RX delivery callbacks
+    uint64_t rx_bounced;     // Frames copied to the bounce buffer for delivery
+    uint64_t rx_dropped;     // Frames the CHIP dropped on RX overflow (CHIP_REG_RX_DROP_COUNT)
+    uint64_t tx_bql_stopped; // host_chip_send_packet() calls rejected with -2 by the BQL limit
+    uint64_t tx_completed;   // TX completions reaped
+    uint64_t tx_compl_full;  // Frames rejected with -2 for TX_COMPL_RING_ENTRIES unreaped frames
+    uint64_t tx_tso;         // Super-frames written for the CHIP to segment (also in tx_packets)
+    uint64_t rx_gro_merged;  // Frames GRO appended to an earlier frame of their flow
+    uint64_t rx_split;       // Frames received as a header entry (also in rx_packets)
+};
+
+// --- Batched RX Delivery ---
+// host_chip_process_received_data() hands frames to the upper stack in batches of up
+// to rx_batch descriptors, one callback per batch (recvmmsg-style). A descriptor and
+// its data are only valid during the callback: the ring space is released after it.
+#define HOST_RX_BATCH_MAX           64
+
+struct host_rx_desc {
+    const uint8_t *data;     // Payload, in the ring, the bounce buffer or a GRO buffer
+    uint32_t len;            // Payload length
+    uint32_t ring_off;       // Ring offset of the (first) frame's length header
+    uint32_t flags;          // HOST_RX_DESC_*
+    uint32_t segs;           // Frames merged into this one (1 unless HOST_RX_DESC_GRO)
+    // HOST_RX_DESC_SPLIT only: data/len are the header bytes in the header entry
+    // (ring_off: its slot), and the rest of the frame is in payload pool buffer buf
+    const uint8_t *payload;  // NULL if the whole frame fitted in the header
+    uint32_t payload_len;
+    uint32_t buf;            // RX_SPLIT_NO_BUF unless payload != NULL
+};
+
+#define HOST_RX_DESC_BOUNCED        (1U << 0) // Frame wrapped around the ring end and was copied
+#define HOST_RX_DESC_GRO            (1U << 1) // Several frames of one TCP flow, merged by GRO
+#define HOST_RX_DESC_SPLIT          (1U << 2) // Header split: frame in a header entry and a pool buffer
+
+typedef void (*host_rx_deliver_fn)(void *ctx, const struct host_rx_desc *descs, unsigned count);
+
+// --- RX Coalescing (GRO) ---
+// With GRO enabled (and an RX handler installed), consecutive in-order TCP segments of
+// one flow in a drain are merged into a single delivery: one descriptor with the first
+// frame's headers (IPv4 total length updated, PSH carried over) followed by all their
+// payloads. Frames must be Ethernet II + IPv4 without options or fragmentation + TCP
+// with only ACK (and PSH, which ends the merge) set, and agree on the ACK number and
+// TCP options. Flows sit in a direct-mapped table of HOST_GRO_FLOWS entries; a frame
+// that cannot join its flow, or a flow of another key hashing to the same entry,
+// flushes the held one first. Every flow is flushed at the end of each drain, so GRO
+// never holds a frame across host_chip_process_received_data() calls.
+//
+// A flow's first frame stays in the ring (a lone frame is delivered without a copy);
+// once a second one joins, they are copied into the flow's max_bytes share of the
+// caller-supplied storage.
+#define HOST_GRO_FLOWS              8
+#define HOST_GRO_HDR_MAX            (14 + 20 + 60) // Ethernet + IPv4 + TCP with options
+
+struct host_gro_config {
+    uint32_t max_bytes;      // Merged frame, headers included; at most 65535
+    uint32_t max_segs;       // Frames per merged frame; 0: bounded by max_bytes only
+};
+
+#define HOST_GRO_DEFAULT_CONFIG     { 65535, 0 }
+
+struct host_gro_flow {
+    uint32_t saddr;
+    uint32_t daddr;
+    uint32_t ports;          // Source port << 16 | destination port
+    uint32_t next_seq;       // Sequence number the next segment must carry
+    uint32_t ack;
+    uint16_t hdr_len;        // Ethernet + IPv4 + TCP header bytes
+    uint16_t segs;           // Frames held; 0: entry free
+    uint32_t len;            // Bytes held, headers of the first frame included
+    uint32_t frame_off;      // Ring offset of the first frame's length header
+    uint32_t payload_off;    // Ring offset of the first frame's data (while segs == 1)
+};
+
+struct host_gro {
+    int enabled;
+    struct host_gro_config cfg;
+    uint8_t *buf;            // HOST_GRO_FLOWS buffers of cfg.max_bytes
+    uint32_t pending;        // Bit i: buffer i is referenced by the undelivered batch
+    struct host_gro_flow flows[HOST_GRO_FLOWS];
+};
+
+// --- RX Header Split ---
+// With header split enabled the CHIP writes each frame's first hdr_len bytes to a
+// 64-byte entry of the header ring and the rest to a buffer of the payload pool
+// (shared.h, RX Header Split), so the stack parses headers from densely packed lines
+// and can hand payloads on without copying or even touching them. The driver gives
+// every pool buffer to the CHIP once through the fill ring; after each delivery
+// callback the buffers of its frames go back, except those the callback took with
+// host_chip_rx_split_take(). Those stay with the stack until
+// host_chip_rx_split_release(), and the CHIP only has the others to fill. GRO does
+// not apply to split frames.
+struct host_rx_split {
+    int enabled;
+    int primed;              // Every pool buffer was given to the CHIP once
+    uint32_t hdr_len;
+    uint32_t tail;           // Header entries consumed (free-running)
+    uint32_t seen_head;      // Entry head up to which the cache was invalidated
+    uint32_t fill_head;      // Buffers put in the fill ring (free-running)
+    uint32_t fill_head_pub;  // fill_head last published to the CHIP
+    uint64_t batch_bufs;     // Bit i: pool buffer i is in the undelivered batch
+    uint64_t taken;          // Bit i: pool buffer i is held by the stack
+};
+
+_Static_assert(RX_SPLIT_BUFS <= 64, "host_rx_split buffer masks");
+
+// --- TX Completions ---
+// With completions enabled every TX frame carries a caller cookie, and the CHIP
+// reports each frame it is done with as a struct tx_completion (shared.h), in TX
+// order. Until its completion is reaped a frame counts against TX_COMPL_RING_ENTRIES,
+// so a caller may keep its buffer (or account its latency) until then. Completions are
+// reaped in bulk: one head read, one invalidate and one tail publish per call.
+// With a handler installed, host_chip_irq_handler() reaps them on
+// CHIP_INT_TX_COMPLETE_BIT and passes them on in batches of up to HOST_TX_COMPL_BATCH.
+#define HOST_TX_COMPL_BATCH         32
+
+typedef void (*host_tx_complete_fn)(void *ctx, const struct tx_completion *compl, unsigned count);
+
+struct host_tx_compl {
+    int enabled;
+    uint32_t submitted;      // Frames queued since enabling (cookie table index)
+    uint32_t tail;           // Completions reaped
+    uint32_t seen_head;      // CHIP head up to which the cache was invalidated
+    host_tx_complete_fn fn;
+    void *ctx;
+};
+
+// --- Byte Queue Limits ---
+// Optional dynamic limit on the TX ring bytes in flight (written by the HOST, not yet
+// consumed by the CHIP), after Linux's dynamic queue limits. On every TX completion
+// (CHIP_INT_TX_SPACE_AVAIL_BIT in host_chip_irq_handler()) the driver looks at what
+// the CHIP consumed: if it was held back by the limit and the CHIP ran dry, the limit
+// grows by what was missing; if bytes stayed queued (slack) through slack_hold
+// completions in a row, it shrinks by the smallest slack seen. The limit settles near
+// the fewest bytes that keep the CHIP busy between two completions.
+struct host_bql_config {
+    uint32_t min_limit;      // Bytes
+    uint32_t max_limit;
+    uint32_t slack_hold;     // Completions with slack before the limit shrinks
+};
+
+#define HOST_BQL_DEFAULT_CONFIG     { 0, TX_BUFFER_SIZE - 1, 16 }
+
+struct host_bql {
+    int enabled;
+    struct host_bql_config cfg;
+    uint32_t limit;          // Current in-flight limit
+    uint32_t adj_limit;      // limit + num_completed: sends stop once num_queued passes it
+    uint32_t num_queued;     // Bytes queued, ever (wraps)
+    uint32_t num_completed;  // Bytes completed, ever (wraps)
+    uint32_t prev_num_queued;
+    uint32_t prev_ovlimit;   // How far num_queued was over the limit at the last completion
+    uint32_t last_obj_cnt;   // Size of the last frame queued
+    uint32_t prev_last_obj_cnt;
+    uint32_t lowest_slack;
+    uint32_t slack_events;
+    uint32_t completed_tail; // TX tail at the last completion
+    uint64_t increases;
+    uint64_t decreases;
+};
+
+// --- Scatter-Gather TX ---
+#define HOST_TX_FRAGS_MAX           8
+
+struct host_tx_frag {
+    const uint8_t *data;
+    uint32_t len;            // May be 0
+};
+
+// --- Software TX Queue ---
+// Optional HOST queue in front of the TX ring (qdisc-like). While it is enabled,
+// host_chip_send_packet() parks a frame that finds the ring full (or the BQL limit
+// reached) instead of failing, and parks later frames behind it to keep their order.
+// Parked frames move to the ring in bulk, with one doorbell per drain: on
+// CHIP_INT_TX_SPACE_AVAIL_BIT in host_chip_irq_handler(), after TX completions are
+// reaped (a full completion ring parks frames too), on the next send, or from
+// host_chip_txq_drain(). The queue lives in caller-supplied HOST memory, so bursts
+// are absorbed without a larger ring in shared RAM.
+enum host_txq_policy {
+    HOST_TXQ_DROP_NEW,       // Queue full: reject the arriving frame (tail drop)
+    HOST_TXQ_DROP_OLDEST,    // Queue full: drop parked frames from the head until it fits
+};
+
+struct host_txq_config {
+    uint32_t max_frames;     // 0: no frame limit
+    uint32_t max_bytes;      // Payload bytes; 0: bounded by the storage only
+    enum host_txq_policy policy;
+};
+
+#define HOST_TXQ_DEFAULT_CONFIG     { 1000, 0, HOST_TXQ_DROP_NEW }
+
+struct host_txq {
+    int enabled;
+    struct host_txq_config cfg;
+    uint8_t *buf;            // Records of 2-byte length + payload, never split at the end
+    uint32_t size;
+    uint32_t head;           // Oldest record
+    uint32_t tail;           // Where the next record goes
+    uint32_t frames;
+    uint32_t bytes;          // Payload bytes parked
+    uint32_t peak_frames;
+};
+
+// --- HOST Driver Instance ---
+// Where one CHIP sits on the HOST's bus
+struct host_chip_bus {
+    uintptr_t regs;          // Register block base (CHIP_BASE_ADDR on a real SoC)
+    uint8_t *tx_ring;        // CPU mapping of the TX ring at TX_BUFFER_START_ADDR
+    uint8_t *rx_ring;        // CPU mapping of the RX ring at RX_BUFFER_START_ADDR
+    uint32_t *tx_compl_cookies;          // CPU mapping of TX_COMPL_COOKIE_START_ADDR
+    struct tx_completion *tx_compl_ring; // CPU mapping of TX_COMPL_RING_START_ADDR
+    struct rx_split_entry *rx_split_ring; // CPU mapping of RX_SPLIT_RING_START_ADDR
+    uint16_t *rx_split_fill;             // CPU mapping of RX_SPLIT_FILL_START_ADDR
+    uint8_t *rx_split_pool;              // CPU mapping of RX_SPLIT_POOL_START_ADDR
+    void *dcache_ctx;        // Passed to the D-cache maintenance routines
+};
+
+// All state of the driver for one CHIP. Instances are independent, so one process
+// can drive several CHIPs, from one thread or one thread per instance.
+struct host_chip {
+    struct host_chip_bus bus;
+
+    // --- HOST Local Ring Buffer Pointers ---
+    uint32_t tx_head;        // Where HOST will write next
+    uint32_t rx_tail;        // Where HOST last read from
+    uint32_t tx_head_pub;    // TX head last published to the CHIP (doorbell)
+    uint32_t rx_seen_head;   // RX head up to which the cache was already invalidated
+    uint32_t rx_drop_seen;   // CHIP_REG_RX_DROP_COUNT at the last overflow interrupt
+
+    // Pending D-cache maintenance, flushed once per doorbell / RX drain
+    struct dcache_batch tx_clean_batch;
+    struct dcache_batch rx_inval_batch;
+
+    // RX delivery to the upper stack (none: frames are consumed and counted only)
+    host_rx_deliver_fn rx_deliver;
+    void *rx_deliver_ctx;
+    unsigned rx_batch;
+    unsigned rx_desc_count;
+    struct host_rx_desc rx_descs[HOST_RX_BATCH_MAX];
+    uint8_t rx_bounce[RX_BUFFER_SIZE]; // Contiguous copy of the (single) wrapped frame of a batch
+
+    struct host_bql bql;
+    struct host_txq txq;
+    struct host_tx_compl txc;
+    struct host_gro gro;
+    struct host_rx_split rxs;
+
+    struct host_chip_stats stats;
+};
+
+// --- HOST Driver API ---
+void host_chip_driver_init(struct host_chip *host, const struct host_chip_bus *bus);
+int host_chip_send_packet(struct host_chip *host, const uint8_t *data, uint32_t len);
+// Batched TX: queue several frames, then publish them with one clean pass and one doorbell
+int host_chip_queue_packet(struct host_chip *host, const uint8_t *data, uint32_t len);
+void host_chip_tx_kick(struct host_chip *host);
+// Scatter-gather TX: one frame gathered from 1..HOST_TX_FRAGS_MAX fragments straight
+// into the ring (or the software TX queue), e.g. a header and a payload kept apart by
+// the caller; returns -1 for an invalid fragment list. The queue variant takes a
+// completion cookie, used only while TX completions are enabled.
+int host_chip_send_packetv(struct host_chip *host, const struct host_tx_frag *frags, unsigned count);
+int host_chip_queue_packetv(struct host_chip *host, const struct host_tx_frag *frags, unsigned count,
+                            uint32_t cookie);
+// Segmentation offload: one super-frame (up to what the TX ring holds) that the CHIP
+// cuts into frames of tso->hdr_len + tso->mss bytes, see struct tx_tso_desc. Returns -1
+// for parameters the CHIP could not follow; the send variant does not park frames in
+// the software TX queue. A super-frame completes (TX completions) as one frame.
+int host_chip_queue_packet_tso(struct host_chip *host, const struct host_tx_frag *frags, unsigned count,
+                               const struct tx_tso_params *tso, uint32_t cookie);
+int host_chip_send_packet_tso(struct host_chip *host, const struct host_tx_frag *frags, unsigned count,
+                              const struct tx_tso_params *tso);
+// TX ring bytes (headers included) written by the HOST and not yet consumed by the CHIP
+uint32_t host_chip_tx_inflight(const struct host_chip *host);
+void host_chip_irq_handler(struct host_chip *host);
+void host_chip_process_received_data(struct host_chip *host);
+// Installs (fn != NULL) or removes the RX delivery callback after host_chip_driver_init();
+// batch is 1..HOST_RX_BATCH_MAX
+int host_chip_set_rx_handler(struct host_chip *host, host_rx_deliver_fn fn, void *ctx, unsigned batch);
+// Enables BQL (cfg NULL: HOST_BQL_DEFAULT_CONFIG) after host_chip_driver_init(), with the
+// limit starting at min_limit; returns -1 on an invalid config. host_chip_disable_bql()
+// removes the limit.
+int host_chip_enable_bql(struct host_chip *host, const struct host_bql_config *cfg);
+void host_chip_disable_bql(struct host_chip *host);
+// Enables the software TX queue (cfg NULL: HOST_TXQ_DEFAULT_CONFIG) in storage of size
+// bytes (at least TX_BUFFER_SIZE); returns -1 on an invalid config. With it,
+// host_chip_send_packet() returns 0 for parked frames and -2 only for frames the
+// policy drops. host_chip_disable_txq() drops whatever is still parked.
+int host_chip_enable_txq(struct host_chip *host, const struct host_txq_config *cfg, uint8_t *storage, uint32_t size);
+void host_chip_disable_txq(struct host_chip *host);
+// Moves parked frames into the TX ring while they fit and rings the doorbell once;
+// returns the number moved
+unsigned host_chip_txq_drain(struct host_chip *host);
+// Enables GRO (cfg NULL: HOST_GRO_DEFAULT_CONFIG) with storage of at least
+// HOST_GRO_FLOWS * max_bytes bytes; returns -1 on an invalid config. It only acts
+// while an RX handler is installed.
+int host_chip_enable_gro(struct host_chip *host, const struct host_gro_config *cfg, uint8_t *storage, uint32_t size);
+void host_chip_disable_gro(struct host_chip *host);
+// Enables header split with hdr_len (1..RX_SPLIT_HDR_MAX) header bytes per entry;
+// returns -1 while frames are waiting in the RX ring. Frames longer than
+// hdr_len + RX_SPLIT_BUF_SIZE cannot be received while it is enabled.
+// host_chip_disable_rx_split() receives the entries still waiting first.
+int host_chip_enable_rx_split(struct host_chip *host, uint32_t hdr_len);
+void host_chip_disable_rx_split(struct host_chip *host);
+// From a delivery callback: keeps the pool buffer of one of its descriptors past the
+// callback; returns -1 if buf is not in the batch. host_chip_rx_split_release() hands
+// taken buffers back to the CHIP with one publish; returns -1 if any of them was not
+// taken (the others are still released).
+int host_chip_rx_split_take(struct host_chip *host, uint32_t buf);
+int host_chip_rx_split_release(struct host_chip *host, const uint32_t *bufs, unsigned count);
+// Enables TX completions (fn NULL: reap with host_chip_reap_tx_completions() only);
+// returns -1 while TX frames are in flight. Frames queued without a cookie (including
+// those the software TX queue moves) complete with cookie 0.
+int host_chip_enable_tx_completions(struct host_chip *host, host_tx_complete_fn fn, void *ctx);
+void host_chip_disable_tx_completions(struct host_chip *host);
+// host_chip_queue_packet() / host_chip_send_packet() with a completion cookie. The
+// send variant does not park frames in the software TX queue.
+int host_chip_queue_packet_cookie(struct host_chip *host, const uint8_t *data, uint32_t len, uint32_t cookie);
+int host_chip_send_packet_cookie(struct host_chip *host, const uint8_t *data, uint32_t len, uint32_t cookie);
+// Copies up to max completions to out, oldest first, and releases their slots;
+// returns the number copied
+unsigned host_chip_reap_tx_completions(struct host_chip *host, struct tx_completion *out, unsigned max);
+
+#endif // HOST_H
@@ -0,0 +1,227 @@
+#include "shared.h"
+#include "host.h"
+#include "chip_emulator.h"
+#include "idle_report.h"
+#include "sim_device.h"
+#include "report_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define IDLE_DEFAULT_PACKETS        1000
+#define IDLE_MAX_PACKETS            100000
+#define IDLE_DEFAULT_GAP_US         500
+#define IDLE_DEFAULT_WAKE_US        200
+#define IDLE_PAYLOAD_LEN            64
+#define IDLE_MAX_DELAYS             8
+
+// How the HOST rings the doorbell and how the CHIP notices it
+struct idle_strategy {
+    const char *name;
+    int idle_enabled;          // 0 = CHIP never sleeps (reference)
+    int doorbell_wake;         // A HEAD_PUB write wakes the CHIP
+    uint32_t poll_interval_ns; // CHIP self wake-up period (0 = never)
+    unsigned kick_batch;       // Frames queued per doorbell
+    uint32_t kick_timeout_ns;  // Ring for a partial batch after this long
+};
+
+static const struct idle_strategy idle_strategies[] = {
+    { "always-on",       0, 1,       0, 1,      0 },
+    { "doorbell",        1, 1,       0, 1,      0 },
+    { "doorbell-b8",     1, 1,       0, 8, 100000 },
+    { "poll-100us",      1, 0,  100000, 1,      0 },
+    { "poll-1ms",        1, 0, 1000000, 1,      0 },
+};
+
+struct idle_config {
+    unsigned packets;
+    uint32_t gap_ns;           // Mean inter-arrival gap
+    uint32_t wake_latency_ns;
+    uint32_t delays_ns[IDLE_MAX_DELAYS];
+    unsigned delay_count;
+    unsigned seed;
+};
+
+struct idle_result {
+    double lat_mean_us;
+    double lat_p99_us;
+    double sleep_pct;
+    double wakeups_per_pkt;
+};
+
+// report_next_gap(), at least one CHIP cycle
+static uint64_t idle_next_gap(uint32_t mean_ns) {
+    uint64_t gap = report_next_gap(mean_ns);
+    return (gap < CHIP_CYCLE_NS) ? CHIP_CYCLE_NS : gap;
+}
+
+static void idle_run(const struct idle_strategy *st, uint32_t entry_delay_ns,
+                     const struct idle_config *cfg, uint64_t *enqueued, uint64_t *latency,
+                     struct idle_result *res) {
+    static struct sim_device dev;
+    static struct host_chip host;
+    static struct chip_emulator chip;
+
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_gen_percent = 0; // TX only: any RX arrival would keep the CHIP awake
+    chip_cfg.idle.enabled = st->idle_enabled;
+    chip_cfg.idle.entry_delay_ns = entry_delay_ns;
+    chip_cfg.idle.wake_latency_ns = cfg->wake_latency_ns;
+    chip_cfg.idle.poll_interval_ns = st->poll_interval_ns;
+    chip_cfg.idle.doorbell_wake = st->doorbell_wake;
+
+    struct host_chip_bus bus;
+    sim_device_init(&dev);
+    sim_device_host_bus(&dev, &bus);
+    host_chip_driver_init(&host, &bus);
+    chip_emulator_init(&chip, &dev, &chip_cfg);
+    srand(cfg->seed);
+
+    uint8_t payload[IDLE_PAYLOAD_LEN];
+    memset(payload, 0x5A, sizeof(payload));
+
+    unsigned queued = 0, done = 0, pending = 0;
+    uint64_t next_arrival = idle_next_gap(cfg->gap_ns);
+    uint64_t first_pending = 0;
+    uint32_t last_tail = BUS_READ_REG(bus.regs, CHIP_REG_TX_TAIL_PTR);
+
+    while (done < cfg->packets) {
+        // HOST: enqueue arrivals, ring the doorbell per strategy
+        while (queued < cfg->packets && next_arrival <= dev.time_ns) {
+            if (host_chip_queue_packet(&host, payload, sizeof(payload)) != 0) {
+                break; // Ring full: retry next cycle
+            }
+            enqueued[queued++] = dev.time_ns;
+            if (pending++ == 0) {
+                first_pending = dev.time_ns;
+            }
+            next_arrival += idle_next_gap(cfg->gap_ns);
+        }
+        if (pending > 0 && (pending >= st->kick_batch || queued == cfg->packets ||
+                            dev.time_ns - first_pending >= st->kick_timeout_ns)) {
+            host_chip_tx_kick(&host);
+            pending = 0;
+        }
+
+        chip_emulator_run_cycle(&chip);
+
+        // The CHIP consumes at most one frame per cycle
+        uint32_t tail = BUS_READ_REG(bus.regs, CHIP_REG_TX_TAIL_PTR);
+        if (tail != last_tail) {
+            latency[done] = dev.time_ns - enqueued[done];
+            done++;
+            last_tail = tail;
+        }
+    }
+
+    uint64_t sum = 0;
+    for (unsigned i = 0; i < done; i++) {
+        sum += latency[i];
+    }
+    qsort(latency, done, sizeof(latency[0]), report_cmp_u64);
+    res->lat_mean_us = sum / (double)done / 1000.0;
+    res->lat_p99_us = latency[(done * 99) / 100] / 1000.0;
+    res->sleep_pct = 100.0 * chip.power.residency_ns[CHIP_PWR_SLEEP] / (double)dev.time_ns;
+    res->wakeups_per_pkt = (chip.power.doorbell_wakeups + chip.power.poll_wakeups) / (double)done;
+}
+
+static void idle_usage(void) {
+    fprintf(stderr,
+            "usage: wifi_ring_buffer_sim --idle-report [--packets N] [--gap-us US] [--wake-us US]\n"
+            "                                          [--entry-delay-us US[,US...]] [--seed N]\n");
+}
+
+// Parses a comma-separated list of microsecond values
+static int idle_parse_delays(const char *val, struct idle_config *cfg) {
+    cfg->delay_count = 0;
+    while (*val != '\0') {
+        char *end;
+        unsigned long us = strtoul(val, &end, 10);
+        if (end == val || cfg->delay_count == IDLE_MAX_DELAYS || us > 4000000UL) {
+            return -1;
+        }
+        cfg->delays_ns[cfg->delay_count++] = (uint32_t)(us * 1000);
+        val = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return -1;
+        }
+    }
+    return (cfg->delay_count > 0) ? 0 : -1;
+}
+
+int idle_report_main(int argc, char **argv) {
+    struct idle_config cfg = {
+        .packets = IDLE_DEFAULT_PACKETS,
+        .gap_ns = IDLE_DEFAULT_GAP_US * 1000,
+        .wake_latency_ns = IDLE_DEFAULT_WAKE_US * 1000,
+        .delays_ns = { 10000, 100000, 1000000 },
+        .delay_count = 3,
+        .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (val == NULL) {
+            idle_usage();
+            return 2;
+        }
+        if (strcmp(arg, "--packets") == 0) {
+            cfg.packets = (unsigned)atoi(val);
+        } else if (strcmp(arg, "--gap-us") == 0) {
+            cfg.gap_ns = (uint32_t)atoi(val) * 1000;
+        } else if (strcmp(arg, "--wake-us") == 0) {
+            cfg.wake_latency_ns = (uint32_t)atoi(val) * 1000;
+        } else if (strcmp(arg, "--entry-delay-us") == 0) {
+            if (idle_parse_delays(val, &cfg) != 0) {
+                idle_usage();
+                return 2;
+            }
+        } else if (strcmp(arg, "--seed") == 0) {
+            cfg.seed = (unsigned)atoi(val);
+        } else {
+            idle_usage();
+            return 2;
+        }
+        i++;
+    }
+    if (cfg.packets == 0 || cfg.packets > IDLE_MAX_PACKETS || cfg.gap_ns == 0 || cfg.gap_ns > 100000000) {
+        idle_usage();
+        return 2;
+    }
+
+    uint64_t *enqueued = malloc(cfg.packets * sizeof(uint64_t));
+    uint64_t *latency = malloc(cfg.packets * sizeof(uint64_t));
+    if (enqueued == NULL || latency == NULL) {
+        free(enqueued);
+        free(latency);
+        return 2;
+    }
+
+    sim_log_enabled = 0;
+    printf("IDLE: %u packets, mean gap %u us, wake latency %u us, %u ns/cycle\n", cfg.packets,
+           cfg.gap_ns / 1000, cfg.wake_latency_ns / 1000, CHIP_CYCLE_NS);
+    printf("%-12s %10s %12s %12s %10s %12s\n", "strategy", "entry_us", "lat_mean_us", "lat_p99_us",
+           "sleep_%", "wakeups/pkt");
+
+    for (size_t s = 0; s < sizeof(idle_strategies) / sizeof(idle_strategies[0]); s++) {
+        const struct idle_strategy *st = &idle_strategies[s];
+        // The reference strategy does not depend on the entry delay
+        unsigned delays = st->idle_enabled ? cfg.delay_count : 1;
+        for (unsigned d = 0; d < delays; d++) {
+            struct idle_result res;
+            idle_run(st, cfg.delays_ns[d], &cfg, enqueued, latency, &res);
+            if (st->idle_enabled) {
+                printf("%-12s %10u", st->name, cfg.delays_ns[d] / 1000);
+            } else {
+                printf("%-12s %10s", st->name, "-");
+            }
+            printf(" %12.2f %12.2f %10.1f %12.3f\n", res.lat_mean_us, res.lat_p99_us, res.sleep_pct,
+                   res.wakeups_per_pkt);
+        }
+    }
+
+    free(enqueued);
+    free(latency);
+    return 0;
+}
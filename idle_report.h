@@ -0,0 +1,14 @@
+#ifndef IDLE_REPORT_H
+#define IDLE_REPORT_H
+
+// --- Idle / Doorbell Trade-off Report ---
+// Entry point for "wifi_ring_buffer_sim --idle-report [options]". argv[0] is
+// "--idle-report".
+//
+// Feeds sparse TX traffic (exponential inter-arrival gaps) through the driver while
+// the CHIP idle model is enabled, and prints, per doorbell strategy and idle entry
+// delay, the queue-to-CHIP latency against the fraction of time the CHIP slept.
+// Returns 0 on success, 2 on usage errors.
+int idle_report_main(int argc, char **argv);
+
+#endif // IDLE_REPORT_H
@@ -0,0 +1,166 @@
+#include "phy_model.h"
+#include <stdio.h>
+#include <string.h>
+
+// --- Rate Tables ---
+// Modulation and coding per MCS: coded bits per subcarrier, code rate num/den
+struct phy_mcs {
+    uint32_t bpscs;
+    uint32_t rate_num;
+    uint32_t rate_den;
+};
+
+static const struct phy_mcs phy_mcs_table[] = {
+    {  1, 1, 2 }, // 0: BPSK 1/2
+    {  2, 1, 2 }, // 1: QPSK 1/2
+    {  2, 3, 4 }, // 2: QPSK 3/4
+    {  4, 1, 2 }, // 3: 16-QAM 1/2
+    {  4, 3, 4 }, // 4: 16-QAM 3/4
+    {  6, 2, 3 }, // 5: 64-QAM 2/3
+    {  6, 3, 4 }, // 6: 64-QAM 3/4
+    {  6, 5, 6 }, // 7: 64-QAM 5/6
+    {  8, 3, 4 }, // 8: 256-QAM 3/4
+    {  8, 5, 6 }, // 9: 256-QAM 5/6
+    { 10, 3, 4 }, // 10: 1024-QAM 3/4
+    { 10, 5, 6 }, // 11: 1024-QAM 5/6
+    { 12, 3, 4 }, // 12: 4096-QAM 3/4 (EHT)
+    { 12, 5, 6 }, // 13: 4096-QAM 5/6 (EHT)
+};
+
+#define PHY_MCS_COUNT               (sizeof(phy_mcs_table) / sizeof(phy_mcs_table[0]))
+#define PHY_HE_MAX_MCS              11U
+#define PHY_MAX_NSS                 8U
+
+#define PHY_SYMBOL_NS               12800U // HE/EHT data symbol without GI
+#define PHY_LTF_NS                  6400U  // 2x HE-/EHT-LTF without GI
+#define PHY_HE_SU_PREAMBLE_NS       36000U // L-STF, L-LTF, L-SIG, RL-SIG, HE-SIG-A, HE-STF
+#define PHY_EHT_MU_PREAMBLE_NS      40000U // L-STF, L-LTF, L-SIG, RL-SIG, U-SIG, EHT-SIG (1 sym), EHT-STF
+#define PHY_SERVICE_BITS            16U
+
+// Non-HT 24 Mb/s control response (BlockAck/Ack)
+#define PHY_LEGACY_PREAMBLE_NS      20000U
+#define PHY_LEGACY_SYMBOL_NS        4000U
+#define PHY_LEGACY_DBPS             96U
+#define PHY_LEGACY_TAIL_BITS        6U
+#define PHY_BLOCK_ACK_LEN           32U    // Compressed BlockAck, 64-frame bitmap
+#define PHY_ACK_LEN                 14U
+
+// A-MPDU framing per frame
+#define PHY_MAC_HEADER_LEN          26U    // QoS data, 3 addresses
+#define PHY_FCS_LEN                 4U
+#define PHY_DELIMITER_LEN           4U
+
+static const uint32_t phy_gi_ns[] = { 800, 1600, 3200 };
+
+// Data subcarriers of a full-width RU
+static uint32_t phy_data_subcarriers(uint32_t bw_mhz) {
+    switch (bw_mhz) {
+    case 20:  return 234;
+    case 40:  return 468;
+    case 80:  return 980;
+    case 160: return 1960;
+    case 320: return 3920;
+    default:  return 0;
+    }
+}
+
+// HE-/EHT-LTF symbols for nss streams: 1, 2, 4, 4, 6, 6, 8, 8
+static uint32_t phy_ltf_count(uint32_t nss) {
+    return (nss == 1) ? 1 : (nss + 1) & ~1U;
+}
+
+static uint64_t phy_symbol_ns(const struct phy_config *cfg) {
+    return PHY_SYMBOL_NS + phy_gi_ns[cfg->gi];
+}
+
+// Coded data bits per symbol times rate_den, which keeps every rate an integer
+static uint64_t phy_dbps_scaled(const struct phy_config *cfg) {
+    const struct phy_mcs *m = &phy_mcs_table[cfg->mcs];
+    return (uint64_t)phy_data_subcarriers(cfg->bw_mhz) * m->bpscs * m->rate_num * cfg->nss;
+}
+
+// --- Link Configuration ---
+int phy_config_check(const struct phy_config *cfg) {
+    int eht = (cfg->standard == PHY_EHT);
+    if (cfg->standard != PHY_HE && !eht) {
+        return -1;
+    }
+    if (phy_data_subcarriers(cfg->bw_mhz) == 0 || (cfg->bw_mhz == 320 && !eht)) {
+        return -1;
+    }
+    if (cfg->mcs >= PHY_MCS_COUNT || (cfg->mcs > PHY_HE_MAX_MCS && !eht)) {
+        return -1;
+    }
+    if (cfg->nss == 0 || cfg->nss > PHY_MAX_NSS || (unsigned)cfg->gi > PHY_GI_3_2) {
+        return -1;
+    }
+    if (cfg->ampdu_max_frames == 0 || cfg->ampdu_max_frames > PHY_MAX_AMPDU_FRAMES ||
+        cfg->ampdu_max_bytes < phy_mpdu_len(0)) {
+        return -1;
+    }
+    return 0;
+}
+
+int phy_config_parse(const char *name, struct phy_config *cfg) {
+    static const struct phy_config defaults = PHY_DEFAULT_CONFIG;
+    char std[3];
+    unsigned bw, mcs, nss;
+    int used = 0;
+
+    *cfg = defaults;
+    if (sscanf(name, "%2[a-z]%u-mcs%u-%uss%n", std, &bw, &mcs, &nss, &used) != 4 || used == 0) {
+        return -1;
+    }
+    if (strcmp(std, "ax") == 0) {
+        cfg->standard = PHY_HE;
+    } else if (strcmp(std, "be") == 0) {
+        cfg->standard = PHY_EHT;
+    } else {
+        return -1;
+    }
+    const char *rest = name + used;
+    if (strcmp(rest, "-gi1.6") == 0) {
+        cfg->gi = PHY_GI_1_6;
+    } else if (strcmp(rest, "-gi3.2") == 0) {
+        cfg->gi = PHY_GI_3_2;
+    } else if (*rest != '\0' && strcmp(rest, "-gi0.8") != 0) {
+        return -1;
+    }
+    cfg->enabled = 1;
+    cfg->bw_mhz = bw;
+    cfg->mcs = mcs;
+    cfg->nss = nss;
+    return phy_config_check(cfg);
+}
+
+uint64_t phy_rate_kbps(const struct phy_config *cfg) {
+    uint64_t den = phy_mcs_table[cfg->mcs].rate_den * phy_symbol_ns(cfg);
+    return phy_dbps_scaled(cfg) * 1000000ULL / den;
+}
+
+// --- Airtime ---
+uint32_t phy_mpdu_len(uint32_t payload_len) {
+    uint32_t len = PHY_DELIMITER_LEN + PHY_MAC_HEADER_LEN + payload_len + PHY_FCS_LEN;
+    return (len + 3U) & ~3U;
+}
+
+uint64_t phy_ppdu_ns(const struct phy_config *cfg, uint32_t psdu_len) {
+    uint64_t preamble = (cfg->standard == PHY_EHT) ? PHY_EHT_MU_PREAMBLE_NS : PHY_HE_SU_PREAMBLE_NS;
+    preamble += phy_ltf_count(cfg->nss) * (uint64_t)(PHY_LTF_NS + phy_gi_ns[cfg->gi]);
+
+    uint64_t bits_scaled = (PHY_SERVICE_BITS + 8ULL * psdu_len) * phy_mcs_table[cfg->mcs].rate_den;
+    uint64_t dbps_scaled = phy_dbps_scaled(cfg);
+    uint64_t symbols = (bits_scaled + dbps_scaled - 1) / dbps_scaled;
+    return preamble + symbols * phy_symbol_ns(cfg);
+}
+
+uint64_t phy_ack_ns(uint32_t frames) {
+    uint32_t len = (frames > 1) ? PHY_BLOCK_ACK_LEN : PHY_ACK_LEN;
+    uint32_t bits = PHY_SERVICE_BITS + 8U * len + PHY_LEGACY_TAIL_BITS;
+    uint32_t symbols = (bits + PHY_LEGACY_DBPS - 1) / PHY_LEGACY_DBPS;
+    return PHY_SIFS_NS + PHY_LEGACY_PREAMBLE_NS + (uint64_t)symbols * PHY_LEGACY_SYMBOL_NS;
+}
+
+uint64_t phy_contention_ns(const struct phy_config *cfg, uint32_t backoff_slots) {
+    return PHY_SIFS_NS + (uint64_t)(cfg->aifsn + backoff_slots) * PHY_SLOT_NS;
+}
@@ -0,0 +1,67 @@
+#ifndef PHY_MODEL_H
+#define PHY_MODEL_H
+
+#include <stdint.h>
+
+// --- 802.11ax/be Link and Airtime Model ---
+// Airtime of a single-user PPDU and of the frame exchange around it, as the CHIP would
+// spend it on the medium. Used by the emulator to pace TX consumption in virtual time
+// (struct chip_emulator_config.phy), so TX ring occupancy builds up at the real drain
+// rate of the link instead of one frame per cycle.
+//
+// Modelled: HE SU / EHT MU preamble with the HE-/EHT-LTFs for nss streams, LDPC data
+// symbols (16 service bits, no tail) for the MCS, channel width and guard interval,
+// A-MPDU framing (QoS MAC header, FCS, delimiter, 4-byte padding), EDCA contention
+// (AIFS plus a random backoff from cw_min) and a SIFS + BlockAck at 24 Mb/s.
+// Not modelled: collisions and retries, RTS/CTS, packet extension, OFDMA/MU-MIMO,
+// rate adaptation, TXOP bursting.
+
+enum phy_standard {
+    PHY_HE,                    // 802.11ax
+    PHY_EHT,                   // 802.11be
+};
+
+enum phy_gi {
+    PHY_GI_0_8,
+    PHY_GI_1_6,
+    PHY_GI_3_2,
+};
+
+struct phy_config {
+    int enabled;
+    enum phy_standard standard;
+    uint32_t bw_mhz;           // 20, 40, 80, 160; 320 with PHY_EHT
+    uint32_t mcs;              // 0-11; 0-13 with PHY_EHT
+    uint32_t nss;              // Spatial streams, 1-8
+    enum phy_gi gi;
+    uint32_t ampdu_max_frames; // MPDUs per A-MPDU (1 = no aggregation)
+    uint32_t ampdu_max_bytes;  // A-MPDU length limit
+    uint32_t aifsn;            // EDCA parameters of the access category (AC_BE: 3, 15)
+    uint32_t cw_min;
+};
+
+#define PHY_DEFAULT_CONFIG { 0, PHY_HE, 80, 11, 2, PHY_GI_0_8, 64, 65535, 3, 15 }
+
+#define PHY_SLOT_NS                 9000U
+#define PHY_SIFS_NS                 16000U
+#define PHY_MAX_PPDU_NS             5484000U  // aPPDUMaxTime
+#define PHY_MAX_AMPDU_FRAMES        1024U     // EHT BlockAck window (HE: 256)
+
+// Returns 0 if cfg describes a valid rate (enabled or not), -1 otherwise
+int phy_config_check(const struct phy_config *cfg);
+// PHY data rate in kb/s
+uint64_t phy_rate_kbps(const struct phy_config *cfg);
+// Bytes one frame of payload_len bytes adds to an A-MPDU (MPDU, delimiter, padding)
+uint32_t phy_mpdu_len(uint32_t payload_len);
+// Duration of a PPDU carrying psdu_len bytes, preamble included
+uint64_t phy_ppdu_ns(const struct phy_config *cfg, uint32_t psdu_len);
+// SIFS plus the BlockAck (or Ack, for a single MPDU) that ends the exchange
+uint64_t phy_ack_ns(uint32_t frames);
+// Time the medium must be idle before transmitting: AIFS plus backoff_slots slots
+uint64_t phy_contention_ns(const struct phy_config *cfg, uint32_t backoff_slots);
+
+// Parses a link name "<ax|be><bw>-mcs<N>-<nss>ss[-gi<0.8|1.6|3.2>]", e.g. "ax80-mcs11-2ss",
+// into an enabled cfg (other fields from PHY_DEFAULT_CONFIG); returns -1 if invalid
+int phy_config_parse(const char *name, struct phy_config *cfg);
+
+#endif // PHY_MODEL_H
@@ -0,0 +1,254 @@
+#include "shared.h"
+#include "host.h"
+#include "chip_emulator.h"
+#include "phy_model.h"
+#include "phy_report.h"
+#include "sim_device.h"
+#include "report_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define PHY_DEFAULT_PACKETS         5000
+#define PHY_MAX_PACKETS             1000000
+#define PHY_DEFAULT_LOAD_MBPS       300
+#define PHY_DEFAULT_PAYLOAD         1500
+#define PHY_MAX_LINKS               8
+#define PHY_TRACE_INTERVAL_NS       100000 // BQL limit sample period of --bql-trace
+
+static const char *const phy_default_links[] = {
+    "ax20-mcs7-1ss",
+    "ax80-mcs7-1ss",
+    "ax80-mcs11-2ss",
+    "ax160-mcs11-2ss",
+    "be320-mcs13-2ss",
+};
+
+struct phy_report_config {
+    unsigned packets;
+    uint32_t load_mbps;        // Offered payload rate
+    uint32_t payload_len;
+    const char *links[PHY_MAX_LINKS];
+    unsigned link_count;
+    unsigned seed;
+    int bql;                   // Also run every link with BQL on the HOST
+    FILE *trace;               // BQL limit over time (CSV), or NULL
+};
+
+struct phy_result {
+    double goodput_mbps;
+    double busy_pct;           // Medium time spent on this link's exchanges
+    double frames_per_ppdu;
+    double occ_mean;           // TX ring bytes in use, sampled every cycle
+    uint32_t occ_max;
+    double delay_mean_us;
+    double delay_p99_us;
+    double limit_mean;         // BQL limit, sampled every cycle
+};
+
+// Frames the CHIP acknowledged, in ring order
+struct phy_run {
+    const uint64_t *arrival;
+    uint64_t *delay;
+    unsigned done;
+};
+
+// TX completions carry the frame's index as cookie and the BlockAck time
+static void phy_on_tx_complete(void *ctx, const struct tx_completion *compl, unsigned count) {
+    struct phy_run *run = ctx;
+    for (unsigned i = 0; i < count; i++) {
+        run->delay[run->done++] = compl[i].done_ns - run->arrival[compl[i].cookie];
+    }
+}
+
+static void phy_run_link(const char *name, const struct phy_config *phy, const struct phy_report_config *cfg,
+                         int bql, uint64_t *arrival, uint64_t *delay, struct phy_result *res) {
+    static struct sim_device dev;
+    static struct host_chip host;
+    static struct chip_emulator chip;
+    static uint8_t payload[TX_BUFFER_SIZE];
+
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_gen_percent = 0;
+    chip_cfg.seed = cfg->seed;
+    chip_cfg.phy = *phy;
+
+    struct host_chip_bus bus;
+    sim_device_init(&dev);
+    sim_device_host_bus(&dev, &bus);
+    host_chip_driver_init(&host, &bus);
+    chip_emulator_init(&chip, &dev, &chip_cfg);
+    if (bql) {
+        host_chip_enable_bql(&host, NULL);
+    }
+    srand(cfg->seed);
+
+    struct phy_run run = { arrival, delay, 0 };
+    host_chip_enable_tx_completions(&host, phy_on_tx_complete, &run);
+
+    // Arrival times are drawn up front so blocked frames keep theirs
+    double mean_gap_ns = cfg->payload_len * 8.0 * 1000.0 / cfg->load_mbps;
+    uint64_t t = 0;
+    for (unsigned i = 0; i < cfg->packets; i++) {
+        t += report_next_gap(mean_gap_ns);
+        arrival[i] = t;
+    }
+
+    unsigned queued = 0;
+    uint64_t occ_sum = 0, limit_sum = 0, cycles = 0;
+    uint32_t occ_max = 0;
+    uint64_t next_trace = 0;
+    while (run.done < cfg->packets) {
+        // HOST: hand every arrived frame to the ring, blocking while it is full
+        while (queued < cfg->packets && arrival[queued] <= dev.time_ns) {
+            if (host_chip_send_packet_cookie(&host, payload, cfg->payload_len, queued) != 0) {
+                break;
+            }
+            queued++;
+        }
+
+        chip_emulator_run_cycle(&chip);
+        // TX completions reach the driver (and BQL) through the interrupt
+        if (BUS_READ_REG(bus.regs, CHIP_REG_INT_STATUS) != 0) {
+            host_chip_irq_handler(&host);
+        }
+
+        uint32_t occ = tx_ring_used(host.tx_head, BUS_READ_REG(bus.regs, CHIP_REG_TX_TAIL_PTR));
+        occ_sum += occ;
+        occ_max = (occ > occ_max) ? occ : occ_max;
+        limit_sum += host.bql.limit;
+        cycles++;
+        if (bql && cfg->trace != NULL && dev.time_ns >= next_trace) {
+            fprintf(cfg->trace, "%s,%llu,%u,%u\n", name, (unsigned long long)(dev.time_ns / 1000), host.bql.limit, occ);
+            next_trace += PHY_TRACE_INTERVAL_NS;
+        }
+    }
+
+    uint64_t sum = 0;
+    for (unsigned i = 0; i < run.done; i++) {
+        sum += delay[i];
+    }
+    qsort(delay, run.done, sizeof(delay[0]), report_cmp_u64);
+    res->goodput_mbps = (double)run.done * cfg->payload_len * 8.0 * 1000.0 / dev.time_ns;
+    res->busy_pct = 100.0 * chip.phy.busy_ns / (double)dev.time_ns;
+    res->frames_per_ppdu = chip.phy.mpdus / (double)chip.phy.ppdus;
+    res->occ_mean = occ_sum / (double)cycles;
+    res->occ_max = occ_max;
+    res->delay_mean_us = sum / (double)run.done / 1000.0;
+    res->delay_p99_us = delay[(run.done * 99) / 100] / 1000.0;
+    res->limit_mean = limit_sum / (double)cycles;
+}
+
+static void phy_usage(void) {
+    fprintf(stderr,
+            "usage: wifi_ring_buffer_sim --phy-report [--packets N] [--load-mbps N] [--payload BYTES]\n"
+            "                                         [--link NAME] ... [--seed N] [--bql] [--bql-trace FILE]\n"
+            "  NAME: <ax|be><bw>-mcs<N>-<nss>ss[-gi<0.8|1.6|3.2>], e.g. ax80-mcs11-2ss\n");
+}
+
+int phy_report_main(int argc, char **argv) {
+    const char *trace_path = NULL;
+    struct phy_report_config cfg = {
+        .packets = PHY_DEFAULT_PACKETS,
+        .load_mbps = PHY_DEFAULT_LOAD_MBPS,
+        .payload_len = PHY_DEFAULT_PAYLOAD,
+        .link_count = 0,
+        .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--bql") == 0) {
+            cfg.bql = 1; // Takes no value
+            continue;
+        }
+        if (val == NULL) {
+            phy_usage();
+            return 2;
+        }
+        if (strcmp(arg, "--packets") == 0) {
+            cfg.packets = (unsigned)atoi(val);
+        } else if (strcmp(arg, "--load-mbps") == 0) {
+            cfg.load_mbps = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--payload") == 0) {
+            cfg.payload_len = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--link") == 0 && cfg.link_count < PHY_MAX_LINKS) {
+            cfg.links[cfg.link_count++] = val;
+        } else if (strcmp(arg, "--seed") == 0) {
+            cfg.seed = (unsigned)atoi(val);
+        } else if (strcmp(arg, "--bql-trace") == 0) {
+            cfg.bql = 1;
+            trace_path = val;
+        } else {
+            phy_usage();
+            return 2;
+        }
+        i++;
+    }
+    if (cfg.link_count == 0) {
+        for (size_t l = 0; l < sizeof(phy_default_links) / sizeof(phy_default_links[0]); l++) {
+            cfg.links[cfg.link_count++] = phy_default_links[l];
+        }
+    }
+    // A frame and its length header must fit the ring with the full/empty gap
+    if (cfg.packets == 0 || cfg.packets > PHY_MAX_PACKETS || cfg.load_mbps == 0 || cfg.payload_len == 0 ||
+        cfg.payload_len + PACKET_LENGTH_FIELD_SIZE >= TX_BUFFER_SIZE) {
+        phy_usage();
+        return 2;
+    }
+
+    struct phy_config links[PHY_MAX_LINKS];
+    for (unsigned l = 0; l < cfg.link_count; l++) {
+        if (phy_config_parse(cfg.links[l], &links[l]) != 0) {
+            fprintf(stderr, "PHY: invalid link %s\n", cfg.links[l]);
+            phy_usage();
+            return 2;
+        }
+    }
+
+    if (trace_path != NULL) {
+        cfg.trace = fopen(trace_path, "w");
+        if (cfg.trace == NULL) {
+            perror("PHY: --bql-trace");
+            return 2;
+        }
+        fprintf(cfg.trace, "link,time_us,bql_limit,tx_inflight\n");
+    }
+
+    uint64_t *arrival = malloc(cfg.packets * sizeof(uint64_t));
+    uint64_t *delay = malloc(cfg.packets * sizeof(uint64_t));
+    if (arrival == NULL || delay == NULL) {
+        free(arrival);
+        free(delay);
+        return 2;
+    }
+
+    sim_log_enabled = 0;
+    printf("PHY: %u packets of %u bytes, offered %u Mb/s, TX ring %lu bytes, %u ns/cycle\n", cfg.packets,
+           cfg.payload_len, cfg.load_mbps, TX_BUFFER_SIZE, CHIP_CYCLE_NS);
+    printf("%-18s %4s %9s %10s %7s %11s %9s %8s %13s %13s %10s\n", "link", "bql", "phy_mbps", "goodput",
+           "busy_%", "frames/ppdu", "occ_mean", "occ_max", "delay_mean_us", "delay_p99_us", "limit_mean");
+
+    for (unsigned l = 0; l < cfg.link_count; l++) {
+        for (int bql = 0; bql <= cfg.bql; bql++) {
+            struct phy_result res;
+            phy_run_link(cfg.links[l], &links[l], &cfg, bql, arrival, delay, &res);
+            printf("%-18s %4s %9.1f %10.1f %7.1f %11.2f %9.0f %8u %13.1f %13.1f", cfg.links[l], bql ? "on" : "off",
+                   phy_rate_kbps(&links[l]) / 1000.0, res.goodput_mbps, res.busy_pct, res.frames_per_ppdu,
+                   res.occ_mean, res.occ_max, res.delay_mean_us, res.delay_p99_us);
+            if (bql) {
+                printf(" %10.0f\n", res.limit_mean);
+            } else {
+                printf(" %10s\n", "-");
+            }
+        }
+    }
+
+    if (cfg.trace != NULL) {
+        fclose(cfg.trace);
+    }
+    free(arrival);
+    free(delay);
+    return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef PHY_REPORT_H
+#define PHY_REPORT_H
+
+// --- TX Queueing at Link Rate Report ---
+// Entry point for "wifi_ring_buffer_sim --phy-report [options]". argv[0] is
+// "--phy-report".
+//
+// Offers Poisson TX traffic at a fixed rate to the driver while the CHIP drains the
+// TX ring at the airtime of an 802.11ax/be link, and prints per link the goodput,
+// medium utilization, A-MPDU size, TX ring occupancy and the arrival-to-BlockAck
+// delay of the frames. Arrivals that find the ring full wait on the HOST and their
+// wait counts into the delay. With --bql every link also runs with the HOST's BQL
+// limit, optionally traced to a CSV file. Returns 0 on success, 2 on usage errors.
+int phy_report_main(int argc, char **argv);
+
+#endif // PHY_REPORT_H
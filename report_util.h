@@ -0,0 +1,24 @@
+#ifndef REPORT_UTIL_H
+#define REPORT_UTIL_H
+
+#include <stdint.h>
+#include <stdlib.h> // For rand()
+#include <math.h>
+
+// --- Report Helpers ---
+// Shared by the virtual-time reports and the benchmark runner. Traffic is drawn from
+// rand(), so a report seeded with srand() produces the same run every time.
+
+// qsort() comparator for uint64_t samples
+static inline int report_cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Exponentially distributed gap of the given mean (Poisson arrivals)
+static inline uint64_t report_next_gap(double mean_ns) {
+    double u = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    return (uint64_t)(-log(u) * mean_ns);
+}
+
+#endif // REPORT_UTIL_H
@@ -0,0 +1,122 @@
+#ifndef RING_H
+#define RING_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h> // For memcpy
+
+// --- Header-only Byte Ring Primitives ---
+// Shared by the HOST driver and the CHIP emulator so both sides agree on the
+// occupancy math, the wrap handling and the on-ring framing.
+//
+// Offsets are byte offsets in [0, size). size must be a power of two; one byte is
+// always left unused so that head == tail means "empty".
+//
+// Every function takes the ring size as a parameter. When it is a compile-time
+// constant (e.g. TX_BUFFER_SIZE) the calls inline and the masks fold into
+// immediates; RING_DEFINE_FIXED() below generates such specializations and rejects
+// other sizes at compile time. A runtime size works with the same functions at the
+// cost of a register mask, but it too must be a power of two: the masking functions
+// assert it (the check folds away for constant sizes and with NDEBUG).
+
+// Nonzero if size is usable as a ring size
+static inline int ring_size_valid(uint32_t size) {
+    return size != 0 && (size & (size - 1)) == 0;
+}
+
+static inline uint32_t ring_wrap(uint32_t off, uint32_t size) {
+    assert(ring_size_valid(size));
+    return off & (size - 1);
+}
+
+// Bytes written by the producer (head) and not yet consumed (tail)
+static inline uint32_t ring_used(uint32_t head, uint32_t tail, uint32_t size) {
+    assert(ring_size_valid(size));
+    return (head - tail) & (size - 1);
+}
+
+// Bytes the producer may still write without overtaking the consumer
+static inline uint32_t ring_free(uint32_t head, uint32_t tail, uint32_t size) {
+    assert(ring_size_valid(size));
+    return (tail - head - 1) & (size - 1);
+}
+
+// Bytes that can be accessed at off before the ring wraps (capped at len)
+static inline uint32_t ring_contig(uint32_t off, uint32_t len, uint32_t size) {
+    uint32_t to_end = size - off;
+    return (len < to_end) ? len : to_end;
+}
+
+// Copies len bytes into the ring at off, wrapping as needed. Returns the offset after the data.
+static inline uint32_t ring_write(uint8_t *base, uint32_t size, uint32_t off, const void *src, uint32_t len) {
+    uint32_t first = ring_contig(off, len, size);
+    memcpy(base + off, src, first);
+    if (first < len) {
+        memcpy(base, (const uint8_t *)src + first, len - first);
+    }
+    return ring_wrap(off + len, size);
+}
+
+// Copies len bytes out of the ring at off, wrapping as needed. Returns the offset after the data.
+static inline uint32_t ring_read(const uint8_t *base, uint32_t size, uint32_t off, void *dst, uint32_t len) {
+    uint32_t first = ring_contig(off, len, size);
+    memcpy(dst, base + off, first);
+    if (first < len) {
+        memcpy((uint8_t *)dst + first, base, len - first);
+    }
+    return ring_wrap(off + len, size);
+}
+
+// Writes the 16-bit little-endian length header at off. Returns the offset after it.
+static inline uint32_t ring_write_len16(uint8_t *base, uint32_t size, uint32_t off, uint16_t len) {
+    if (off + 2 > size) {
+        base[off] = (uint8_t)(len & 0xFF);
+        base[0] = (uint8_t)(len >> 8);
+    } else {
+        memcpy(base + off, &len, 2); // Assuming little-endian, as the split path
+    }
+    return ring_wrap(off + 2, size);
+}
+
+static inline uint16_t ring_read_len16(const uint8_t *base, uint32_t size, uint32_t off) {
+    uint16_t len;
+    if (off + 2 > size) {
+        len = (uint16_t)base[off] | ((uint16_t)base[0] << 8);
+    } else {
+        memcpy(&len, base + off, 2);
+    }
+    return len;
+}
+
+// --- Compile-time Specialization ---
+// RING_DEFINE_FIXED(tx_ring, 4096) generates tx_ring_wrap(), tx_ring_used(), ...
+// with the size baked in, and rejects sizes that are not a power of two.
+#define RING_DEFINE_FIXED(prefix, SIZE)                                                         \
+    _Static_assert((SIZE) != 0 && ((SIZE) & ((SIZE) - 1)) == 0,                                \
+                   #prefix " size must be a power of two");                                    \
+    static inline uint32_t prefix##_wrap(uint32_t off) {                                        \
+        return ring_wrap(off, (SIZE));                                                          \
+    }                                                                                           \
+    static inline uint32_t prefix##_used(uint32_t head, uint32_t tail) {                        \
+        return ring_used(head, tail, (SIZE));                                                   \
+    }                                                                                           \
+    static inline uint32_t prefix##_free(uint32_t head, uint32_t tail) {                        \
+        return ring_free(head, tail, (SIZE));                                                   \
+    }                                                                                           \
+    static inline uint32_t prefix##_contig(uint32_t off, uint32_t len) {                        \
+        return ring_contig(off, len, (SIZE));                                                   \
+    }                                                                                           \
+    static inline uint32_t prefix##_write(uint8_t *base, uint32_t off, const void *src, uint32_t len) { \
+        return ring_write(base, (SIZE), off, src, len);                                         \
+    }                                                                                           \
+    static inline uint32_t prefix##_read(const uint8_t *base, uint32_t off, void *dst, uint32_t len) { \
+        return ring_read(base, (SIZE), off, dst, len);                                          \
+    }                                                                                           \
+    static inline uint32_t prefix##_write_len16(uint8_t *base, uint32_t off, uint16_t len) {    \
+        return ring_write_len16(base, (SIZE), off, len);                                        \
+    }                                                                                           \
+    static inline uint16_t prefix##_read_len16(const uint8_t *base, uint32_t off) {             \
+        return ring_read_len16(base, (SIZE), off);                                              \
+    }
+
+#endif // RING_H
@@ -0,0 +1,241 @@
+#ifndef RING_HPP
+#define RING_HPP
+
+// --- Header-only C++ Binding over ring.h ---
+// For C++ consumers of the ring protocol. Ring<Size, Align> keeps the ring size and
+// base alignment as compile-time constants so the occupancy math and copies inline
+// into the caller fully specialized, and hands out std::span views into the ring
+// instead of copying. The C primitives in ring.h remain the single implementation
+// of the framing; this header only adds types around them. Requires C++20.
+//
+// Each side of a ring owns one Ring object holding its local index (head for the
+// producer, tail for the consumer). Publishing that index to the peer (e.g. writing
+// CHIP_REG_HOST_TX_HEAD_PUB) and the barriers around it stay with the caller.
+//
+// A side has at most one guard outstanding: reserve*() / peek*() return an empty
+// guard until the previous one is committed / released (or cancelled / kept), since
+// both would cover the same bytes. Note that in g = ring.reserve(...) the right side
+// runs while g still holds its reservation; commit g first.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+
+#include "ring.h"
+
+namespace ring {
+
+template <std::size_t Size, std::size_t Align = 64>
+class Ring {
+    static_assert(Size >= 4 && (Size & (Size - 1)) == 0, "Ring size must be a power of two");
+    static_assert(Size <= (std::size_t{1} << 31), "Ring offsets are 32-bit");
+    static_assert(Align != 0 && (Align & (Align - 1)) == 0, "Ring alignment must be a power of two");
+
+public:
+    static constexpr std::uint32_t size = static_cast<std::uint32_t>(Size);
+    static constexpr std::uint32_t mask = size - 1;
+    static constexpr std::uint32_t capacity = size - 1; // One byte kept free: head == tail means empty
+    static constexpr std::size_t alignment = Align;
+    static constexpr std::uint32_t header_size = 2;     // PACKET_LENGTH_FIELD_SIZE
+
+    // Up to two contiguous pieces of the ring; second is empty unless the range wraps
+    template <typename Byte>
+    struct Region {
+        std::span<Byte> first;
+        std::span<Byte> second;
+
+        constexpr std::size_t size() const noexcept { return first.size() + second.size(); }
+        constexpr bool empty() const noexcept { return size() == 0; }
+        constexpr explicit operator bool() const noexcept { return !empty(); }
+    };
+
+    // Producer reservation: the caller fills the region, the destructor commits it by
+    // advancing the local head. cancel() drops the reservation without committing.
+    class CommitGuard {
+    public:
+        CommitGuard() noexcept = default;
+        CommitGuard(const CommitGuard &) = delete;
+        CommitGuard &operator=(const CommitGuard &) = delete;
+        CommitGuard(CommitGuard &&other) noexcept
+            : ring_(std::exchange(other.ring_, nullptr)), end_(other.end_), region_(other.region_) {}
+        CommitGuard &operator=(CommitGuard &&other) noexcept {
+            if (this != &other) {
+                commit();
+                ring_ = std::exchange(other.ring_, nullptr);
+                end_ = other.end_;
+                region_ = other.region_;
+            }
+            return *this;
+        }
+        ~CommitGuard() { commit(); }
+
+        const Region<std::uint8_t> &region() const noexcept { return region_; }
+        explicit operator bool() const noexcept { return ring_ != nullptr; }
+
+        // Copies src into the reserved region (src must not be larger than it)
+        void write(std::span<const std::uint8_t> src) noexcept {
+            std::uint32_t off = static_cast<std::uint32_t>(region_.first.data() - ring_->base_);
+            ring_write(ring_->base_, size, off, src.data(), static_cast<std::uint32_t>(src.size()));
+        }
+
+        void commit() noexcept {
+            if (ring_ != nullptr) {
+                ring_->head_ = end_;
+                ring_->reserved_ = false;
+                ring_ = nullptr;
+            }
+        }
+        void cancel() noexcept {
+            if (ring_ != nullptr) {
+                ring_->reserved_ = false;
+                ring_ = nullptr;
+            }
+        }
+
+    private:
+        friend class Ring;
+        CommitGuard(Ring *ring, std::uint32_t end, Region<std::uint8_t> region) noexcept
+            : ring_(ring), end_(end), region_(region) {
+            ring_->reserved_ = true;
+        }
+
+        Ring *ring_ = nullptr;
+        std::uint32_t end_ = 0; // Head after the commit
+        Region<std::uint8_t> region_{};
+    };
+
+    // Consumer view: the region stays valid until the destructor releases it by
+    // advancing the local tail. keep() leaves the bytes in the ring.
+    class ReleaseGuard {
+    public:
+        ReleaseGuard() noexcept = default;
+        ReleaseGuard(const ReleaseGuard &) = delete;
+        ReleaseGuard &operator=(const ReleaseGuard &) = delete;
+        ReleaseGuard(ReleaseGuard &&other) noexcept
+            : ring_(std::exchange(other.ring_, nullptr)), end_(other.end_), region_(other.region_) {}
+        ReleaseGuard &operator=(ReleaseGuard &&other) noexcept {
+            if (this != &other) {
+                release();
+                ring_ = std::exchange(other.ring_, nullptr);
+                end_ = other.end_;
+                region_ = other.region_;
+            }
+            return *this;
+        }
+        ~ReleaseGuard() { release(); }
+
+        const Region<const std::uint8_t> &region() const noexcept { return region_; }
+        explicit operator bool() const noexcept { return ring_ != nullptr; }
+
+        // Copies the region into dst (dst must be at least region().size() bytes)
+        void read(std::span<std::uint8_t> dst) const noexcept {
+            std::uint32_t off = static_cast<std::uint32_t>(region_.first.data() - ring_->base_);
+            ring_read(ring_->base_, size, off, dst.data(), static_cast<std::uint32_t>(region_.size()));
+        }
+
+        void release() noexcept {
+            if (ring_ != nullptr) {
+                ring_->tail_ = end_;
+                ring_->peeked_ = false;
+                ring_ = nullptr;
+            }
+        }
+        void keep() noexcept {
+            if (ring_ != nullptr) {
+                ring_->peeked_ = false;
+                ring_ = nullptr;
+            }
+        }
+
+    private:
+        friend class Ring;
+        ReleaseGuard(Ring *ring, std::uint32_t end, Region<const std::uint8_t> region) noexcept
+            : ring_(ring), end_(end), region_(region) {
+            ring_->peeked_ = true;
+        }
+
+        Ring *ring_ = nullptr;
+        std::uint32_t end_ = 0; // Tail after the release
+        Region<const std::uint8_t> region_{};
+    };
+
+    // base must point at Size bytes of ring memory aligned to Align
+    explicit Ring(std::uint8_t *base, std::uint32_t head = 0, std::uint32_t tail = 0) noexcept
+        : base_(std::assume_aligned<Align>(base)), head_(head & mask), tail_(tail & mask) {}
+
+    static constexpr std::uint32_t wrap(std::uint32_t off) noexcept { return off & mask; }
+    static constexpr std::uint32_t used(std::uint32_t head, std::uint32_t tail) noexcept { return (head - tail) & mask; }
+    static constexpr std::uint32_t free(std::uint32_t head, std::uint32_t tail) noexcept { return (tail - head - 1) & mask; }
+
+    std::uint32_t head() const noexcept { return head_; }
+    std::uint32_t tail() const noexcept { return tail_; }
+
+    // --- Producer ---
+    // Reserves len raw bytes at the local head given the consumer's published tail.
+    // Returns an empty guard when there is not enough space or a reservation is pending.
+    CommitGuard reserve(std::uint32_t len, std::uint32_t peer_tail) noexcept {
+        if (reserved_ || len == 0 || free(head_, peer_tail) < len) {
+            return CommitGuard();
+        }
+        return CommitGuard(this, wrap(head_ + len), region(head_, len));
+    }
+
+    // Writes the length header and reserves the payload behind it; the guard commits
+    // header and payload together.
+    CommitGuard reserve_frame(std::uint16_t payload_len, std::uint32_t peer_tail) noexcept {
+        std::uint32_t total = header_size + payload_len;
+        if (reserved_ || free(head_, peer_tail) < total) {
+            return CommitGuard();
+        }
+        std::uint32_t payload_off = ring_write_len16(base_, size, head_, payload_len);
+        return CommitGuard(this, wrap(head_ + total), region(payload_off, payload_len));
+    }
+
+    // --- Consumer ---
+    // Peeks len raw bytes at the local tail given the producer's published head.
+    // Returns an empty guard when fewer bytes are available or a view is pending.
+    ReleaseGuard peek(std::uint32_t len, std::uint32_t peer_head) noexcept {
+        if (peeked_ || len == 0 || used(peer_head, tail_) < len) {
+            return ReleaseGuard();
+        }
+        return ReleaseGuard(this, wrap(tail_ + len), const_region(tail_, len));
+    }
+
+    // Peeks the next complete frame; the region covers its payload and the guard
+    // releases header and payload together.
+    ReleaseGuard peek_frame(std::uint32_t peer_head) noexcept {
+        std::uint32_t avail = used(peer_head, tail_);
+        if (peeked_ || avail < header_size) {
+            return ReleaseGuard();
+        }
+        std::uint16_t payload_len = ring_read_len16(base_, size, tail_);
+        std::uint32_t total = header_size + payload_len;
+        if (avail < total) {
+            return ReleaseGuard();
+        }
+        return ReleaseGuard(this, wrap(tail_ + total), const_region(wrap(tail_ + header_size), payload_len));
+    }
+
+private:
+    Region<std::uint8_t> region(std::uint32_t off, std::uint32_t len) const noexcept {
+        std::uint32_t first = ring_contig(off, len, size);
+        return { std::span<std::uint8_t>(base_ + off, first), std::span<std::uint8_t>(base_, len - first) };
+    }
+
+    Region<const std::uint8_t> const_region(std::uint32_t off, std::uint32_t len) const noexcept {
+        Region<std::uint8_t> r = region(off, len);
+        return { r.first, r.second };
+    }
+
+    std::uint8_t *base_;
+    std::uint32_t head_;
+    std::uint32_t tail_;
+    bool reserved_ = false; // A CommitGuard is outstanding
+    bool peeked_ = false;   // A ReleaseGuard is outstanding
+};
+
+} // namespace ring
+
+#endif // RING_HPP
@@ -0,0 +1,125 @@
+// --- ring.hpp Checks ---
+// Instantiates ring::Ring<4096> and drives it the way a producer and a consumer
+// would: framed round trips across the wrap, raw reservations, and the guard rules
+// (one outstanding guard per side, commit/release on move-assignment and scope exit).
+// Built and run by `make check-cxx`; exits 1 on the first failed check.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "ring.hpp"
+
+using Ring = ring::Ring<4096>;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            std::fprintf(stderr, "ring_hpp_test:%d: check failed: %s\n", __LINE__, #cond); \
+            std::exit(1);                                                           \
+        }                                                                           \
+    } while (0)
+
+alignas(64) static std::uint8_t ring_mem[Ring::size];
+
+// Frames of varying length through the ring, several laps, checked byte by byte
+static void check_frame_round_trip() {
+    Ring prod(ring_mem), cons(ring_mem);
+    std::uint8_t frame[1500];
+    std::uint8_t out[1500];
+    unsigned wrapped = 0;
+
+    for (std::uint32_t n = 0; n < 200; n++) {
+        std::uint16_t len = static_cast<std::uint16_t>(1 + (n * 337) % sizeof(frame));
+        for (std::uint16_t i = 0; i < len; i++) {
+            frame[i] = static_cast<std::uint8_t>(n + i);
+        }
+        {
+            auto g = prod.reserve_frame(len, cons.tail());
+            CHECK(g);
+            CHECK(g.region().size() == len);
+            wrapped += !g.region().second.empty();
+            g.write(std::span<const std::uint8_t>(frame, len));
+        } // Commits
+
+        auto r = cons.peek_frame(prod.head());
+        CHECK(r);
+        CHECK(r.region().size() == len);
+        r.read(std::span<std::uint8_t>(out, len));
+        CHECK(std::memcmp(frame, out, len) == 0);
+        r.release();
+        CHECK(cons.tail() == prod.head());
+        CHECK(!cons.peek_frame(prod.head())); // Empty again
+    }
+    CHECK(wrapped > 0);
+}
+
+// Raw reservations: capacity, the split region at the wrap, and refusal when full
+static void check_raw_reserve() {
+    Ring prod(ring_mem, Ring::size - 8, Ring::size - 8), cons(ring_mem, Ring::size - 8, Ring::size - 8);
+    {
+        auto g = prod.reserve(16, cons.tail());
+        CHECK(g);
+        CHECK(g.region().first.size() == 8 && g.region().second.size() == 8);
+    }
+    CHECK(prod.head() == 8);
+    CHECK(!prod.reserve(Ring::capacity, cons.tail())); // Only capacity - 16 left
+
+    auto r = cons.peek(16, prod.head());
+    CHECK(r && r.region().second.size() == 8);
+    r.keep();
+    CHECK(cons.tail() == Ring::size - 8);
+    CHECK(!cons.peek(17, prod.head()));
+}
+
+// One guard per side: a second reservation waits for the first, and move-assignment
+// commits the old reservation exactly once
+static void check_guard_rules() {
+    Ring prod(ring_mem), cons(ring_mem);
+
+    auto a = prod.reserve(4, cons.tail());
+    CHECK(a);
+    CHECK(!prod.reserve(4, cons.tail()));        // Would overlap a
+    CHECK(!prod.reserve_frame(4, cons.tail()));
+    a.commit();
+    CHECK(prod.head() == 4);
+
+    auto g = prod.reserve(8, cons.tail());
+    CHECK(g);
+    g = prod.reserve(8, cons.tail());            // Refused while g is pending; g commits
+    CHECK(!g);
+    CHECK(prod.head() == 12);
+    g = prod.reserve(8, cons.tail());
+    CHECK(g);
+    {
+        auto h = std::move(g);                   // The reservation moves, g is empty
+        CHECK(!g && h);
+    }
+    CHECK(prod.head() == 20);
+
+    g = prod.reserve(8, cons.tail());
+    g.cancel();
+    CHECK(prod.head() == 20);
+    CHECK(prod.reserve(8, cons.tail()));         // Cancel ended the reservation (commits at once)
+    CHECK(prod.head() == 28);
+
+    auto r = cons.peek(4, prod.head());
+    CHECK(r);
+    CHECK(!cons.peek(4, prod.head()));
+    r = cons.peek(4, prod.head());               // Refused while r is pending; r releases
+    CHECK(!r);
+    CHECK(cons.tail() == 4);
+    r = cons.peek(24, prod.head());
+    CHECK(r);
+    r = Ring::ReleaseGuard();
+    CHECK(cons.tail() == 28);
+}
+
+int main() {
+    check_frame_round_trip();
+    check_raw_reserve();
+    check_guard_rules();
+    std::printf("ring_hpp_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include "shared.h"
+#include "host.h"
+#include "chip_emulator.h"
+#include "phy_model.h"
+#include "ring_sampler.h"
+#include "ring_report.h"
+#include "sim_device.h"
+#include "report_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define RING_DEFAULT_LINK           "ax80-mcs11-2ss"
+#define RING_DEFAULT_DURATION_MS    200
+#define RING_DEFAULT_TX_MBPS        300
+#define RING_DEFAULT_PAYLOAD        1500
+#define RING_DEFAULT_RX_PERCENT     20
+#define RING_DEFAULT_IRQ_NS         2000
+#define RING_DEFAULT_HOST_NS        150
+#define RING_DEFAULT_INTERVAL_US    10
+#define RING_DEFAULT_TARGET_PCT     0.1
+
+struct ring_config {
+    const char *link;
+    struct phy_config phy;
+    uint32_t duration_ms;
+    uint32_t tx_mbps;
+    uint32_t payload_len;
+    uint32_t rx_percent;
+    uint32_t irq_ns;           // HOST cost per RX interrupt
+    uint32_t host_ns;          // HOST cost per RX frame
+    uint32_t interval_us;
+    double target_pct;
+    const char *csv_path;
+    unsigned seed;
+};
+
+static void ring_print_advice(const char *name, uint32_t size, const struct ring_advice *a, uint64_t events,
+                              uint64_t frames) {
+    printf("%-4s %7u %7u %7u %7u %7u %7u %8.2f %12llu %8.3f ", name, size, a->p50, a->p90, a->p99, a->p999,
+           a->max, a->full_pct, (unsigned long long)events, frames ? 100.0 * events / frames : 0.0);
+    if (a->recommended != 0) {
+        printf("%11u\n", a->recommended);
+    } else {
+        printf("%10s%u\n", ">", size); // Censored: rerun with a larger ring
+    }
+}
+
+static void ring_usage(void) {
+    fprintf(stderr,
+            "usage: wifi_ring_buffer_sim --ring-report [--link NAME] [--duration-ms MS] [--tx-mbps N] [--payload BYTES]\n"
+            "                                          [--rx-percent P] [--irq-ns NS] [--host-ns NS]\n"
+            "                                          [--interval-us US] [--target-pct PCT] [--csv FILE] [--seed N]\n");
+}
+
+int ring_report_main(int argc, char **argv) {
+    struct ring_config cfg = {
+        .link = RING_DEFAULT_LINK,
+        .duration_ms = RING_DEFAULT_DURATION_MS,
+        .tx_mbps = RING_DEFAULT_TX_MBPS,
+        .payload_len = RING_DEFAULT_PAYLOAD,
+        .rx_percent = RING_DEFAULT_RX_PERCENT,
+        .irq_ns = RING_DEFAULT_IRQ_NS,
+        .host_ns = RING_DEFAULT_HOST_NS,
+        .interval_us = RING_DEFAULT_INTERVAL_US,
+        .target_pct = RING_DEFAULT_TARGET_PCT,
+        .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (val == NULL) {
+            ring_usage();
+            return 2;
+        }
+        if (strcmp(arg, "--link") == 0) {
+            cfg.link = val;
+        } else if (strcmp(arg, "--duration-ms") == 0) {
+            cfg.duration_ms = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--tx-mbps") == 0) {
+            cfg.tx_mbps = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--payload") == 0) {
+            cfg.payload_len = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--rx-percent") == 0) {
+            cfg.rx_percent = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--irq-ns") == 0) {
+            cfg.irq_ns = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--host-ns") == 0) {
+            cfg.host_ns = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--interval-us") == 0) {
+            cfg.interval_us = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--target-pct") == 0) {
+            cfg.target_pct = atof(val);
+        } else if (strcmp(arg, "--csv") == 0) {
+            cfg.csv_path = val;
+        } else if (strcmp(arg, "--seed") == 0) {
+            cfg.seed = (unsigned)atoi(val);
+        } else {
+            ring_usage();
+            return 2;
+        }
+        i++;
+    }
+    if (phy_config_parse(cfg.link, &cfg.phy) != 0) {
+        fprintf(stderr, "RING: invalid link %s\n", cfg.link);
+        ring_usage();
+        return 2;
+    }
+    if (cfg.duration_ms == 0 || cfg.duration_ms > 60000 || cfg.tx_mbps == 0 || cfg.payload_len == 0 ||
+        cfg.payload_len + PACKET_LENGTH_FIELD_SIZE > TX_BUFFER_SIZE - 1 || cfg.rx_percent > 100 ||
+        cfg.irq_ns > 1000000 || cfg.host_ns > 1000000 || cfg.interval_us == 0 ||
+        cfg.target_pct < 0.0 || cfg.target_pct >= 100.0) {
+        ring_usage();
+        return 2;
+    }
+
+    sim_log_enabled = 0;
+    static struct sim_device dev;
+    static struct host_chip host;
+    static struct chip_emulator chip;
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_gen_percent = cfg.rx_percent;
+    chip_cfg.seed = cfg.seed;
+    chip_cfg.phy = cfg.phy;
+
+    struct host_chip_bus bus;
+    sim_device_init(&dev);
+    sim_device_host_bus(&dev, &bus);
+    host_chip_driver_init(&host, &bus);
+    chip_emulator_init(&chip, &dev, &chip_cfg);
+
+    struct ring_sampler sampler;
+    if (ring_sampler_init(&sampler, &dev, cfg.interval_us * 1000ULL) != 0) {
+        return 2;
+    }
+
+    uint8_t *payload = calloc(1, cfg.payload_len);
+    if (payload == NULL) {
+        ring_sampler_free(&sampler);
+        return 2;
+    }
+
+    srand(cfg.seed);
+    double tx_gap_ns = cfg.payload_len * 8.0 * 1000.0 / cfg.tx_mbps;
+    uint64_t next_tx = report_next_gap(tx_gap_ns);
+    uint64_t end_ns = cfg.duration_ms * 1000000ULL;
+    uint64_t tx_frames = 0, tx_stalls = 0, backlog = 0, busy_until = 0;
+    int stalled = 0;
+
+    while (dev.time_ns < end_ns) {
+        // HOST TX: arrivals wait on the HOST while the ring is full
+        while (next_tx <= dev.time_ns) {
+            backlog++;
+            next_tx += report_next_gap(tx_gap_ns);
+        }
+        while (backlog > 0) {
+            if (host_chip_send_packet(&host, payload, cfg.payload_len) != 0) {
+                tx_stalls += !stalled; // Once per frame that found the ring full
+                stalled = 1;
+                break;
+            }
+            stalled = 0;
+            backlog--;
+            tx_frames++;
+        }
+
+        chip_emulator_run_cycle(&chip);
+        ring_sampler_poll(&sampler);
+
+        // HOST RX: interrupt driven, busy for the cost of what it processed
+        if (dev.time_ns >= busy_until && BUS_READ_REG(bus.regs, CHIP_REG_INT_STATUS) != 0) {
+            uint64_t before = host.stats.rx_packets;
+            host_chip_irq_handler(&host);
+            busy_until = dev.time_ns + cfg.irq_ns + (host.stats.rx_packets - before) * cfg.host_ns;
+        }
+    }
+    tx_frames += backlog;
+
+    printf("RING: link %s (%.1f Mb/s), TX %u Mb/s of %u-byte frames, RX chance %u%% per cycle, HOST %u ns/irq + "
+           "%u ns/frame, %u ms, sample every %u us\n", cfg.link, phy_rate_kbps(&cfg.phy) / 1000.0, cfg.tx_mbps,
+           cfg.payload_len, cfg.rx_percent, cfg.irq_ns, cfg.host_ns, cfg.duration_ms, cfg.interval_us);
+    printf("%-4s %7s %7s %7s %7s %7s %7s %8s %12s %8s %11s\n", "ring", "size", "p50", "p90", "p99", "p99.9",
+           "max", "full_%", "stalls/drops", "events_%", "recommended");
+
+    struct ring_advice advice;
+    ring_sampler_advise(&sampler, RING_SAMPLER_TX, TX_BUFFER_SIZE, cfg.payload_len + PACKET_LENGTH_FIELD_SIZE,
+                        cfg.target_pct, &advice);
+    ring_print_advice("tx", TX_BUFFER_SIZE, &advice, tx_stalls, tx_frames);
+    ring_sampler_advise(&sampler, RING_SAMPLER_RX, RX_BUFFER_SIZE, CHIP_RX_GEN_MAX_LEN + PACKET_LENGTH_FIELD_SIZE,
+                        cfg.target_pct, &advice);
+    ring_print_advice("rx", RX_BUFFER_SIZE, &advice, chip.rx.dropped, chip.rx.arrived);
+    printf("RING: recommended = smallest power-of-two size with at most %.3f%% of samples short of room for a "
+           "frame (\">\": the ring was full too often to tell; rebuild larger)\n", cfg.target_pct);
+
+    int rc = 0;
+    if (cfg.csv_path != NULL) {
+        FILE *f = fopen(cfg.csv_path, "w");
+        if (f == NULL || ring_sampler_write_csv(&sampler, f) != 0) {
+            perror("RING: --csv");
+            rc = 2;
+        }
+        if (f != NULL) {
+            fclose(f);
+        }
+    }
+    free(payload);
+    ring_sampler_free(&sampler);
+    return rc;
+}
@@ -0,0 +1,16 @@
+#ifndef RING_REPORT_H
+#define RING_REPORT_H
+
+// --- Ring Sizing Report ---
+// Entry point for "wifi_ring_buffer_sim --ring-report [options]". argv[0] is
+// "--ring-report".
+//
+// Runs Poisson TX traffic to a CHIP paced at an 802.11ax/be link together with random
+// RX traffic drained by an interrupt-driven HOST of a given processing cost, samples
+// the occupancy of both rings at a fixed device-time interval (optionally written to a
+// CSV file) and prints per ring the occupancy percentiles, the TX stalls and RX drops
+// of the run, and the smallest ring size that keeps stalls/drops within a target.
+// Returns 0 on success, 2 on usage errors.
+int ring_report_main(int argc, char **argv);
+
+#endif // RING_REPORT_H
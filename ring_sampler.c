@@ -0,0 +1,130 @@
+#include "shared.h"
+#include "ring_sampler.h"
+#include <stdlib.h>
+
+#define RING_SAMPLER_INITIAL_CAP    4096
+#define RING_SAMPLER_MIN_SIZE       64
+#define RING_SAMPLER_MAX_SIZE       65536  // Largest ring the 16-bit pointers allow
+
+// --- Sampling ---
+static int ring_sampler_grow(struct ring_sampler *s) {
+    uint32_t cap = s->cap ? s->cap * 2 : RING_SAMPLER_INITIAL_CAP;
+    struct ring_sample *samples = realloc(s->samples, cap * sizeof(*samples));
+    if (samples == NULL) {
+        return -1;
+    }
+    s->samples = samples;
+    s->cap = cap;
+    return 0;
+}
+
+int ring_sampler_init(struct ring_sampler *s, struct sim_device *dev, uint64_t interval_ns) {
+    memset(s, 0, sizeof(*s));
+    if (interval_ns == 0 || ring_sampler_grow(s) != 0) {
+        return -1;
+    }
+    s->regs = sim_device_regs(dev);
+    s->time_ns = &dev->time_ns;
+    s->interval_ns = interval_ns;
+    s->start_ns = dev->time_ns;
+    s->next_ns = dev->time_ns;
+    ring_sampler_poll(s);
+    return 0;
+}
+
+void ring_sampler_free(struct ring_sampler *s) {
+    free(s->samples);
+    s->samples = NULL;
+    s->count = 0;
+    s->cap = 0;
+}
+
+void ring_sampler_poll(struct ring_sampler *s) {
+    if (*s->time_ns < s->next_ns) {
+        return;
+    }
+    struct ring_sample now = {
+        (uint16_t)tx_ring_used(BUS_READ_REG(s->regs, CHIP_REG_HOST_TX_HEAD_PUB), BUS_READ_REG(s->regs, CHIP_REG_TX_TAIL_PTR)),
+        (uint16_t)rx_ring_used(BUS_READ_REG(s->regs, CHIP_REG_RX_HEAD_PTR), BUS_READ_REG(s->regs, CHIP_REG_HOST_RX_TAIL_PUB)),
+    };
+    // Samples missed between two polls repeat the current state
+    while (*s->time_ns >= s->next_ns) {
+        if (s->count == s->cap && ring_sampler_grow(s) != 0) {
+            s->next_ns = UINT64_MAX; // Out of memory: the series ends here
+            return;
+        }
+        s->samples[s->count++] = now;
+        s->next_ns += s->interval_ns;
+    }
+}
+
+int ring_sampler_write_csv(const struct ring_sampler *s, FILE *f) {
+    if (fprintf(f, "time_us,tx_used,rx_used\n") < 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < s->count; i++) {
+        uint64_t t = s->start_ns + i * s->interval_ns;
+        if (fprintf(f, "%llu.%03u,%u,%u\n", (unsigned long long)(t / 1000), (unsigned)(t % 1000),
+                    s->samples[i].tx_used, s->samples[i].rx_used) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// --- Sizing Advisor ---
+static uint16_t ring_sampler_used(const struct ring_sampler *s, enum ring_sampler_ring ring, uint32_t i) {
+    return (ring == RING_SAMPLER_TX) ? s->samples[i].tx_used : s->samples[i].rx_used;
+}
+
+void ring_sampler_advise(const struct ring_sampler *s, enum ring_sampler_ring ring, uint32_t ring_size,
+                         uint32_t headroom, double target_pct, struct ring_advice *out) {
+    memset(out, 0, sizeof(*out));
+    if (s->count == 0) {
+        return;
+    }
+
+    // Counting sort: occupancies are 16-bit
+    uint32_t *hist = calloc(RING_SAMPLER_MAX_SIZE, sizeof(uint32_t));
+    if (hist == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < s->count; i++) {
+        hist[ring_sampler_used(s, ring, i)]++;
+    }
+
+    // Percentiles: the smallest occupancy that covers pct of the samples
+    static const double pcts[] = { 50.0, 90.0, 99.0, 99.9, 100.0 };
+    uint32_t *dst[] = { &out->p50, &out->p90, &out->p99, &out->p999, &out->max };
+    uint64_t seen = 0;
+    unsigned p = 0;
+    for (uint32_t used = 0; used < RING_SAMPLER_MAX_SIZE && p < 5; used++) {
+        seen += hist[used];
+        while (p < 5 && seen * 100.0 >= pcts[p] * s->count && seen > 0) {
+            *dst[p++] = used;
+        }
+    }
+
+    // Samples without room for a frame in a ring of each size (suffix sums of the histogram)
+    uint64_t above = 0;
+    uint32_t limit_used = RING_SAMPLER_MAX_SIZE; // hist[limit_used..] already summed in above
+    uint64_t allowed = (uint64_t)(target_pct / 100.0 * s->count);
+    for (uint32_t size = RING_SAMPLER_MAX_SIZE; size >= RING_SAMPLER_MIN_SIZE; size /= 2) {
+        // A sample is short of room once used > size - 1 - headroom
+        uint32_t first_short = (size > headroom) ? size - headroom : 0;
+        while (limit_used > first_short) {
+            above += hist[--limit_used];
+        }
+        if (size == ring_size) {
+            out->full_pct = 100.0 * above / s->count;
+        }
+        if (above <= allowed) {
+            out->recommended = size;
+        }
+    }
+    // Demand beyond the sampled ring is unknown once that ring itself ran out of room
+    if (out->full_pct > target_pct) {
+        out->recommended = 0;
+    }
+    free(hist);
+}
@@ -0,0 +1,63 @@
+#ifndef RING_SAMPLER_H
+#define RING_SAMPLER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "sim_device.h"
+
+// --- Ring Occupancy Sampler ---
+// Records the occupancy of both rings of one device every interval_ns of device
+// time, as the registers show it: TX bytes published by the HOST and not yet consumed
+// by the CHIP, RX bytes published by the CHIP and not yet released by the HOST.
+// Samples are 4 bytes each and carry no timestamp (sample i is at start + i * interval),
+// so long runs stay small in memory.
+struct ring_sample {
+    uint16_t tx_used;
+    uint16_t rx_used;
+};
+
+struct ring_sampler {
+    uintptr_t regs;            // Device register block
+    const uint64_t *time_ns;   // Device clock
+    uint64_t interval_ns;
+    uint64_t start_ns;         // Time of the first sample
+    uint64_t next_ns;
+    struct ring_sample *samples;
+    uint32_t count;
+    uint32_t cap;
+};
+
+enum ring_sampler_ring {
+    RING_SAMPLER_TX,
+    RING_SAMPLER_RX,
+};
+
+// --- Ring Sizing Advisor ---
+// A frame of headroom bytes (largest frame + length header) does not fit a ring of
+// size S while used + headroom > S - 1: for TX the HOST stalls, for RX the CHIP drops.
+// The advisor counts the samples where that would have happened for each power-of-two
+// size and recommends the smallest size at which they stay within target_pct. Samples
+// at which the sampled ring itself was that full mean the demand above it is unknown
+// (censored): the recommendation is then only "larger than the current ring".
+struct ring_advice {
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t p999;
+    uint32_t max;
+    double full_pct;           // Samples at which the sampled ring had no room for a frame
+    uint32_t recommended;      // Smallest sufficient ring size (0: censored)
+};
+
+// Binds the sampler to dev and takes the first sample at the current device time;
+// returns -1 if interval_ns is 0 or the buffer cannot be allocated
+int ring_sampler_init(struct ring_sampler *s, struct sim_device *dev, uint64_t interval_ns);
+void ring_sampler_free(struct ring_sampler *s);
+// Call once per cycle: records every sample that fell due since the last call
+void ring_sampler_poll(struct ring_sampler *s);
+// Writes "time_us,tx_used,rx_used" rows; returns -1 on a write error
+int ring_sampler_write_csv(const struct ring_sampler *s, FILE *f);
+void ring_sampler_advise(const struct ring_sampler *s, enum ring_sampler_ring ring, uint32_t ring_size,
+                         uint32_t headroom, double target_pct, struct ring_advice *out);
+
+#endif // RING_SAMPLER_H
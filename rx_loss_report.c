@@ -0,0 +1,177 @@
+#include "shared.h"
+#include "host.h"
+#include "chip_emulator.h"
+#include "rx_loss_report.h"
+#include "sim_device.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RXL_DEFAULT_FRAMES          100000
+#define RXL_MAX_FRAMES              10000000
+#define RXL_DEFAULT_RX_PERCENT      50
+#define RXL_DEFAULT_IRQ_NS          2000
+#define RXL_MAX_COSTS               8
+
+static const char *const rxl_policy_names[] = { "drop", "fifo" };
+
+struct rxl_config {
+    unsigned frames;
+    uint32_t rx_percent;
+    uint32_t irq_ns;           // HOST cost per RX interrupt
+    uint32_t frame_ns[RXL_MAX_COSTS]; // HOST cost per frame, one run each
+    unsigned cost_count;
+    uint32_t fifo_frames;
+    unsigned seed;
+};
+
+struct rxl_result {
+    uint64_t arrived;
+    uint64_t delivered;
+    uint64_t dropped;          // As counted by the HOST
+    uint64_t irqs;
+    uint32_t fifo_peak;
+    uint32_t occ_max;
+    int counted_ok;            // HOST count matches the CHIP's own
+};
+
+static void rxl_run(enum chip_rx_overflow_policy policy, uint32_t frame_ns, const struct rxl_config *cfg,
+                    struct rxl_result *res) {
+    static struct sim_device dev;
+    static struct host_chip host;
+    static struct chip_emulator chip;
+
+    struct chip_emulator_config chip_cfg = CHIP_EMULATOR_DEFAULT_CONFIG;
+    chip_cfg.rx_gen_percent = cfg->rx_percent;
+    chip_cfg.seed = cfg->seed;
+    chip_cfg.rx_overflow = policy;
+    chip_cfg.rx_fifo_frames = cfg->fifo_frames;
+
+    struct host_chip_bus bus;
+    sim_device_init(&dev);
+    sim_device_host_bus(&dev, &bus);
+    host_chip_driver_init(&host, &bus);
+    chip_emulator_init(&chip, &dev, &chip_cfg);
+
+    uint64_t busy_until = 0;
+    memset(res, 0, sizeof(*res));
+    while (chip.rx.arrived < cfg->frames) {
+        chip_emulator_run_cycle(&chip);
+
+        uint32_t occ = rx_ring_used(BUS_READ_REG(bus.regs, CHIP_REG_RX_HEAD_PTR), host.rx_tail);
+        res->occ_max = (occ > res->occ_max) ? occ : res->occ_max;
+
+        // HOST: takes the interrupt once done with the previous one, then stays busy
+        // for the cost of what it processed
+        if (dev.time_ns >= busy_until && BUS_READ_REG(bus.regs, CHIP_REG_INT_STATUS) != 0) {
+            uint64_t before = host.stats.rx_packets;
+            host_chip_irq_handler(&host);
+            busy_until = dev.time_ns + cfg->irq_ns + (host.stats.rx_packets - before) * frame_ns;
+            res->irqs++;
+        }
+    }
+
+    // Pick up drops the HOST has not been interrupted for yet
+    if (BUS_READ_REG(bus.regs, CHIP_REG_INT_STATUS) & CHIP_INT_RX_OVERFLOW_BIT) {
+        host_chip_irq_handler(&host);
+    }
+
+    res->arrived = chip.rx.arrived;
+    res->delivered = host.stats.rx_packets;
+    res->dropped = host.stats.rx_dropped;
+    res->fifo_peak = chip.rx.fifo_peak;
+    res->counted_ok = (host.stats.rx_dropped == chip.rx.dropped);
+}
+
+static void rxl_usage(void) {
+    fprintf(stderr,
+            "usage: wifi_ring_buffer_sim --rx-loss-report [--frames N] [--rx-percent P] [--irq-ns NS]\n"
+            "                                             [--host-ns NS[,NS...]] [--fifo-frames N] [--seed N]\n");
+}
+
+// Parses a comma-separated list of per-frame costs in ns
+static int rxl_parse_costs(const char *val, struct rxl_config *cfg) {
+    cfg->cost_count = 0;
+    while (*val != '\0') {
+        char *end;
+        unsigned long ns = strtoul(val, &end, 10);
+        if (end == val || cfg->cost_count == RXL_MAX_COSTS || ns > 1000000UL) {
+            return -1;
+        }
+        cfg->frame_ns[cfg->cost_count++] = (uint32_t)ns;
+        val = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return -1;
+        }
+    }
+    return (cfg->cost_count > 0) ? 0 : -1;
+}
+
+int rx_loss_report_main(int argc, char **argv) {
+    struct rxl_config cfg = {
+        .frames = RXL_DEFAULT_FRAMES,
+        .rx_percent = RXL_DEFAULT_RX_PERCENT,
+        .irq_ns = RXL_DEFAULT_IRQ_NS,
+        .frame_ns = { 100, 150, 170, 200 },
+        .cost_count = 4,
+        .fifo_frames = CHIP_RX_FIFO_SLOTS,
+        .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (val == NULL) {
+            rxl_usage();
+            return 2;
+        }
+        if (strcmp(arg, "--frames") == 0) {
+            cfg.frames = (unsigned)atoi(val);
+        } else if (strcmp(arg, "--rx-percent") == 0) {
+            cfg.rx_percent = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--irq-ns") == 0) {
+            cfg.irq_ns = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--host-ns") == 0) {
+            if (rxl_parse_costs(val, &cfg) != 0) {
+                rxl_usage();
+                return 2;
+            }
+        } else if (strcmp(arg, "--fifo-frames") == 0) {
+            cfg.fifo_frames = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--seed") == 0) {
+            cfg.seed = (unsigned)atoi(val);
+        } else {
+            rxl_usage();
+            return 2;
+        }
+        i++;
+    }
+    if (cfg.frames == 0 || cfg.frames > RXL_MAX_FRAMES || cfg.rx_percent == 0 || cfg.rx_percent > 100 ||
+        cfg.irq_ns > 1000000 || cfg.fifo_frames == 0 || cfg.fifo_frames > CHIP_RX_FIFO_SLOTS) {
+        rxl_usage();
+        return 2;
+    }
+
+    sim_log_enabled = 0;
+    printf("RX LOSS: %u frames of %u-%u bytes, arrival chance %u%% per %u ns cycle, RX ring %lu bytes, "
+           "HOST %u ns per interrupt\n", cfg.frames, CHIP_RX_GEN_MIN_LEN, CHIP_RX_GEN_MAX_LEN, cfg.rx_percent,
+           CHIP_CYCLE_NS, RX_BUFFER_SIZE, cfg.irq_ns);
+    printf("%-8s %8s %10s %10s %10s %8s %10s %9s %8s\n", "policy", "host_ns", "arrived", "delivered",
+           "dropped", "loss_%", "irqs", "fifo_peak", "occ_max");
+
+    int counted_ok = 1;
+    for (int p = CHIP_RX_OVERFLOW_DROP; p <= CHIP_RX_OVERFLOW_FIFO; p++) {
+        for (unsigned c = 0; c < cfg.cost_count; c++) {
+            struct rxl_result res;
+            rxl_run((enum chip_rx_overflow_policy)p, cfg.frame_ns[c], &cfg, &res);
+            printf("%-8s %8u %10llu %10llu %10llu %8.2f %10llu %9u %8u\n", rxl_policy_names[p], cfg.frame_ns[c],
+                   (unsigned long long)res.arrived, (unsigned long long)res.delivered,
+                   (unsigned long long)res.dropped, 100.0 * res.dropped / res.arrived,
+                   (unsigned long long)res.irqs, res.fifo_peak, res.occ_max);
+            counted_ok &= res.counted_ok;
+        }
+    }
+    if (!counted_ok) {
+        printf("RX LOSS: HOST drop count differs from the CHIP's\n");
+    }
+    return 0;
+}
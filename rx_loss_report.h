@@ -0,0 +1,15 @@
+#ifndef RX_LOSS_REPORT_H
+#define RX_LOSS_REPORT_H
+
+// --- RX Overflow Loss Report ---
+// Entry point for "wifi_ring_buffer_sim --rx-loss-report [options]". argv[0] is
+// "--rx-loss-report".
+//
+// Lets the CHIP receive random frames from the air while an interrupt-driven HOST
+// drains the RX ring at a given processing cost per interrupt and per frame, and
+// prints, per RX overflow policy and HOST cost, how many frames the CHIP dropped
+// (as the HOST counted them from CHIP_REG_RX_DROP_COUNT) for the built RX_BUFFER_SIZE.
+// Returns 0 on success, 2 on usage errors.
+int rx_loss_report_main(int argc, char **argv);
+
+#endif // RX_LOSS_REPORT_H
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <string.h> // For memcpy
+#include "ring.h"
 
 // --- Shared Memory & Ring Buffer Definitions ---
 
@@ -10,85 +11,302 @@
 #define SHARED_RAM_BASE_ADDR        0x20000000UL // Using UL for unsigned long
 
 // Size of the ring buffers (must be power of 2 for easy modulo arithmetic)
-// These sizes impact performance vs. memory footprint. Tune based on needs.
+// These sizes impact performance vs. memory footprint. Tune based on needs, e.g.
+// "make SIM_FLAGS=-DTX_BUFFER_SIZE=65536UL" (at most 64KB: 16-bit frame lengths).
+#ifndef TX_BUFFER_SIZE
 #define TX_BUFFER_SIZE              (4096UL) // Example: 4KB
+#endif
+#ifndef RX_BUFFER_SIZE
 #define RX_BUFFER_SIZE              (4096UL) // Example: 4KB
+#endif
+
+// Size-specialized ring helpers (tx_ring_used(), rx_ring_write(), ...) from ring.h
+RING_DEFINE_FIXED(tx_ring, TX_BUFFER_SIZE)
+RING_DEFINE_FIXED(rx_ring, RX_BUFFER_SIZE)
 
 // Pointers to the start of the ring buffers within shared RAM
 #define TX_BUFFER_START_ADDR        (SHARED_RAM_BASE_ADDR)
 #define RX_BUFFER_START_ADDR        (SHARED_RAM_BASE_ADDR + TX_BUFFER_SIZE)
 
+// --- TX Completion Ring ---
+// With completions enabled (CHIP_REG_TX_COMPL_CTRL) the HOST writes a 32-bit cookie
+// per TX frame to a cookie table indexed by frame number, and the CHIP writes one
+// struct tx_completion per frame it has finished with to the completion ring, in TX
+// order. Both are TX_COMPL_RING_ENTRIES long; CHIP_REG_TX_COMPL_HEAD (CHIP, entries
+// written) and CHIP_REG_HOST_TX_COMPL_TAIL_PUB (HOST, entries reaped) are free-running
+// counters, entry i sitting at slot i % TX_COMPL_RING_ENTRIES of both tables.
+#define TX_COMPL_RING_ENTRIES       256U // Power of two; at most this many frames in flight
+
+#define TX_COMPL_STATUS_OK          0
+
+struct tx_completion {
+    uint32_t cookie;           // As queued with the frame
+    uint16_t len;              // Payload length
+    uint16_t status;           // TX_COMPL_STATUS_*
+    uint64_t done_ns;          // Device time at which the CHIP released the frame
+};
+
+#define TX_COMPL_ENTRY_SIZE         16U
+_Static_assert(sizeof(struct tx_completion) == TX_COMPL_ENTRY_SIZE, "tx_completion layout");
+
+#define TX_COMPL_COOKIE_START_ADDR  (RX_BUFFER_START_ADDR + RX_BUFFER_SIZE)
+#define TX_COMPL_COOKIE_SIZE        (TX_COMPL_RING_ENTRIES * 4U)
+#define TX_COMPL_RING_START_ADDR    (TX_COMPL_COOKIE_START_ADDR + TX_COMPL_COOKIE_SIZE)
+#define TX_COMPL_RING_SIZE          (TX_COMPL_RING_ENTRIES * TX_COMPL_ENTRY_SIZE)
+
+// --- RX Header Split ---
+// With header split enabled (CHIP_REG_RX_SPLIT_CTRL) the CHIP no longer writes RX
+// frames to the RX ring. The first hdr_len bytes of each frame (at most
+// RX_SPLIT_HDR_MAX) go to a one-line struct rx_split_entry in the header ring, and the
+// rest to a RX_SPLIT_BUF_SIZE buffer of the payload pool, named by index in the entry.
+// The HOST hands free buffers to the CHIP by index through the fill ring. All three
+// positions are free-running counters: CHIP_REG_RX_SPLIT_HEAD (entries written),
+// CHIP_REG_HOST_RX_SPLIT_TAIL_PUB (entries consumed) and CHIP_REG_HOST_RX_FILL_HEAD_PUB
+// (buffers given); the CHIP's own fill position is internal, as there are never more
+// buffers to give than fill ring slots.
+#define RX_SPLIT_ENTRIES            64U   // Power of two
+#define RX_SPLIT_HDR_MAX            56U
+#define RX_SPLIT_BUFS               32U   // Power of two, at most 64
+#define RX_SPLIT_BUF_SIZE           2048U
+#define RX_SPLIT_NO_BUF             0xFFFFU // Entry buf: the frame fitted in the header
+
+struct rx_split_entry {
+    uint16_t len;              // Frame length
+    uint16_t hdr_len;          // Bytes in hdr; the other len - hdr_len are in buffer buf
+    uint16_t buf;              // Payload pool index, or RX_SPLIT_NO_BUF
+    uint16_t reserved;
+    uint8_t hdr[RX_SPLIT_HDR_MAX];
+};
+
+#define RX_SPLIT_ENTRY_SIZE         64U
+_Static_assert(sizeof(struct rx_split_entry) == RX_SPLIT_ENTRY_SIZE, "rx_split_entry layout");
+#define RX_SPLIT_MAX_FRAME          (RX_SPLIT_HDR_MAX + RX_SPLIT_BUF_SIZE) // With hdr_len RX_SPLIT_HDR_MAX
+
+#define RX_SPLIT_RING_START_ADDR    (TX_COMPL_RING_START_ADDR + TX_COMPL_RING_SIZE)
+#define RX_SPLIT_RING_SIZE          (RX_SPLIT_ENTRIES * RX_SPLIT_ENTRY_SIZE)
+#define RX_SPLIT_FILL_START_ADDR    (RX_SPLIT_RING_START_ADDR + RX_SPLIT_RING_SIZE)
+#define RX_SPLIT_FILL_SIZE          64U   // RX_SPLIT_BUFS 16-bit indices, rounded up to a line
+#define RX_SPLIT_POOL_START_ADDR    (RX_SPLIT_FILL_START_ADDR + RX_SPLIT_FILL_SIZE)
+#define RX_SPLIT_POOL_SIZE          (RX_SPLIT_BUFS * RX_SPLIT_BUF_SIZE)
+_Static_assert(RX_SPLIT_BUFS * 2 <= RX_SPLIT_FILL_SIZE, "fill ring size");
+
+// Total shared memory: both rings, the TX cookie table and completion ring, then the
+// RX header ring, fill ring and payload pool
+#define TOTAL_SHARED_MEMORY_SIZE    (TX_BUFFER_SIZE + RX_BUFFER_SIZE + TX_COMPL_COOKIE_SIZE + TX_COMPL_RING_SIZE + \
+                                     RX_SPLIT_RING_SIZE + RX_SPLIT_FILL_SIZE + RX_SPLIT_POOL_SIZE)
+
 // A minimum amount of space/data required to trigger an operation (e.g., DMA)
 // This helps prevent excessive small transfers.
 #define TX_LOW_WATERMARK_THRESHOLD  (TX_BUFFER_SIZE / 4) // Example: refill when 1/4 full
 #define RX_HIGH_WATERMARK_THRESHOLD (RX_BUFFER_SIZE / 4) // Example: process when 1/4 full
+#define RX_SPLIT_HIGH_WATERMARK     (RX_SPLIT_ENTRIES / 4) // Header entries, with header split
 
-// --- CHIP Register Addresses (Conceptual BUS-mapped) ---
-// These addresses would be defined by the hardware team integrating the CHIP IP.
-// Replace with actual addresses from your SoC's memory map.
-#define CHIP_BASE_ADDR              0x50000000UL
+// --- CHIP Register Offsets (Conceptual BUS-mapped) ---
+// Offsets within one CHIP's register block. A driver instance addresses its CHIP as
+// regs base + offset, so several CHIPs can sit at different bases.
+// These offsets would be defined by the hardware team integrating the CHIP IP.
+#define CHIP_BASE_ADDR              0x50000000UL // Register block of the first CHIP on a real SoC
 
 // Registers for HOST to read CHIP's pointer status
-#define CHIP_REG_TX_TAIL_PTR        (CHIP_BASE_ADDR + 0x00) // CHIP's current Tx consumption pointer
-#define CHIP_REG_RX_HEAD_PTR        (CHIP_BASE_ADDR + 0x04) // CHIP's current Rx production pointer
+#define CHIP_REG_TX_TAIL_PTR        0x00 // CHIP's current Tx consumption pointer
+#define CHIP_REG_RX_HEAD_PTR        0x04 // CHIP's current Rx production pointer
 
 // Registers for HOST to write its pointer updates for CHIP to read
-#define CHIP_REG_HOST_TX_HEAD_PUB   (CHIP_BASE_ADDR + 0x08) // HOST's current Tx production pointer
-#define CHIP_REG_HOST_RX_TAIL_PUB   (CHIP_BASE_ADDR + 0x0C) // HOST's current Rx consumption pointer
+#define CHIP_REG_HOST_TX_HEAD_PUB   0x08 // HOST's current Tx production pointer
+#define CHIP_REG_HOST_RX_TAIL_PUB   0x0C // HOST's current Rx consumption pointer
 
 // Interrupt related registers
-#define CHIP_REG_INT_STATUS         (CHIP_BASE_ADDR + 0x10) // Read current interrupt status
-#define CHIP_REG_INT_CLEAR          (CHIP_BASE_ADDR + 0x14) // Write to clear interrupts
-#define CHIP_REG_INT_ENABLE         (CHIP_BASE_ADDR + 0x18) // Write to enable/disable interrupts
+#define CHIP_REG_INT_STATUS         0x10 // Read current interrupt status
+#define CHIP_REG_INT_CLEAR          0x14 // Write to clear interrupts
+#define CHIP_REG_INT_ENABLE         0x18 // Write to enable/disable interrupts
+
+// RX loss accounting
+#define CHIP_REG_RX_DROP_COUNT      0x1C // RX frames the CHIP dropped for lack of room (wraps)
+
+// TX completions (see TX Completion Ring above)
+#define CHIP_REG_TX_COMPL_HEAD      0x20 // Completions the CHIP has written (free-running)
+#define CHIP_REG_HOST_TX_COMPL_TAIL_PUB 0x24 // Completions the HOST has reaped (free-running)
+#define CHIP_REG_TX_COMPL_CTRL      0x28 // CHIP_TX_COMPL_CTRL_* bits
+
+#define CHIP_TX_COMPL_CTRL_ENABLE   (1U << 0) // Set with the TX ring idle, after publishing the tail
+
+// RX header split (see RX Header Split above)
+#define CHIP_REG_RX_SPLIT_HEAD      0x2C // Header entries the CHIP has written (free-running)
+#define CHIP_REG_HOST_RX_SPLIT_TAIL_PUB 0x30 // Header entries the HOST has consumed (free-running)
+#define CHIP_REG_HOST_RX_FILL_HEAD_PUB 0x34 // Buffers the HOST has put in the fill ring (free-running)
+#define CHIP_REG_RX_SPLIT_CTRL      0x38 // CHIP_RX_SPLIT_CTRL_* bits
+
+#define CHIP_RX_SPLIT_CTRL_ENABLE   (1U << 0) // Set with the RX ring drained, after filling
+#define CHIP_RX_SPLIT_CTRL_HDR_SHIFT 8        // Bits 8..15: hdr_len, 1..RX_SPLIT_HDR_MAX
+
+#define CHIP_NUM_REGS               15   // 32-bit registers in the block
 
 // Define specific interrupt bits (example)
 #define CHIP_INT_RX_DATA_READY_BIT  (1U << 0)
 #define CHIP_INT_TX_SPACE_AVAIL_BIT (1U << 1)
 #define CHIP_INT_ERROR_BIT          (1U << 2)
+#define CHIP_INT_RX_OVERFLOW_BIT    (1U << 3) // An RX frame was dropped
+#define CHIP_INT_TX_COMPLETE_BIT    (1U << 4) // TX completions were written
 
 // Generic BUS memory-mapped register access macros
 // In a real project, these might be wrapper functions provided by an SoC HAL.
-// For simulation, these will simply access global variables that simulate memory-mapped registers.
-#ifdef SIMULATION_MODE
-// ...
-extern uint8_t *tx_buffer_ptr; // Declare as extern
-extern uint8_t *rx_buffer_ptr; // Declare as extern
-
-// In simulation mode, use a simulated memory-mapped register block
-// This needs to be defined in both host.c and chip_emulator.c
-extern uint32_t simulated_chip_registers[7]; // 7 registers as defined above
-
-#define BUS_READ_REG(addr)          (simulated_chip_registers[((addr) - CHIP_BASE_ADDR) / 4])
-#define BUS_WRITE_REG(addr, val)    (simulated_chip_registers[((addr) - CHIP_BASE_ADDR) / 4] = (val))
-#else
-#define BUS_READ_REG(addr)          (*(volatile uint32_t *)(addr))
-#define BUS_WRITE_REG(addr, val)    (*(volatile uint32_t *)(addr) = (val))
-#endif
+// base is the CHIP's register block: its BUS address on hardware, the address of the
+// device's simulated register array (struct sim_device) in simulation.
+#define BUS_READ_REG(base, reg)         (*(volatile uint32_t *)((base) + (reg)))
+#define BUS_WRITE_REG(base, reg, val)   (*(volatile uint32_t *)((base) + (reg)) = (val))
 
 
 // --- Cache Coherency / Memory Barrier Macros ---
-// In a simulation, these might not do anything unless you have a memory model.
-#ifndef SIMULATION_MODE
-#ifdef __ARM_ARCH_7M__ // Or specific for HOST like __HOST_ARCH__ if available
-#define DMB() __asm volatile ("dmb" ::: "memory") // Data Memory Barrier
-#define DSB() __asm volatile ("dsb" ::: "memory") // Data Synchronization Barrier
-#define ISB() __asm volatile ("isb" ::: "memory") // Instruction Synchronization Barrier
+// ARCH_*() are the raw fence instructions of the build architecture:
+//   ARCH_DMB()    full data memory barrier (all prior accesses before all later ones)
+//   ARCH_DSB()    data synchronization barrier (prior accesses complete before continuing)
+//   ARCH_ISB()    instruction synchronization barrier
+//   ARCH_DMB_ST() store -> store ordering only
+//   ARCH_DMB_LD() load -> load and load -> store ordering only
+// x86-64 is TSO: stores are not reordered with stores, loads not with loads or later
+// stores, so the one-way fences only need to stop the compiler.
+#define COMPILER_BARRIER() __asm volatile ("" ::: "memory")
+
+#if defined(__ARM_ARCH_7M__) // Or specific for HOST like __HOST_ARCH__ if available
+#define ARCH_DMB()    __asm volatile ("dmb" ::: "memory") // Data Memory Barrier
+#define ARCH_DSB()    __asm volatile ("dsb" ::: "memory") // Data Synchronization Barrier
+#define ARCH_ISB()    __asm volatile ("isb" ::: "memory") // Instruction Synchronization Barrier
+#define ARCH_DMB_ST() ARCH_DMB() // M-profile only implements the full-system DMB
+#define ARCH_DMB_LD() ARCH_DMB()
+#elif defined(__aarch64__)
+#define ARCH_DMB()    __asm volatile ("dmb sy" ::: "memory")
+#define ARCH_DSB()    __asm volatile ("dsb sy" ::: "memory")
+#define ARCH_ISB()    __asm volatile ("isb" ::: "memory")
+#define ARCH_DMB_ST() __asm volatile ("dmb oshst" ::: "memory") // Outer shareable: covers the CHIP's bus master
+#define ARCH_DMB_LD() __asm volatile ("dmb oshld" ::: "memory")
+#elif defined(__x86_64__)
+#define ARCH_DMB()    __asm volatile ("mfence" ::: "memory")
+#define ARCH_DSB()    __asm volatile ("mfence" ::: "memory")
+#define ARCH_ISB()    __asm volatile ("lfence" ::: "memory") // Closest equivalent: waits for prior instructions
+#define ARCH_DMB_ST() COMPILER_BARRIER()
+#define ARCH_DMB_LD() COMPILER_BARRIER()
 #else
-#define DMB() do {} while (0)
-#define DSB() do {} while (0)
-#define ISB() do {} while (0)
+#define ARCH_DMB()    do {} while (0)
+#define ARCH_DSB()    do {} while (0)
+#define ARCH_ISB()    do {} while (0)
+#define ARCH_DMB_ST() do {} while (0)
+#define ARCH_DMB_LD() do {} while (0)
 #endif // __ARM_ARCH_7M__
+
+#ifndef SIMULATION_MODE
+#define DMB()    ARCH_DMB()
+#define DSB()    ARCH_DSB()
+#define ISB()    ARCH_ISB()
+#define DMB_ST() ARCH_DMB_ST()
+#define DMB_LD() ARCH_DMB_LD()
 #else // SIMULATION_MODE
-#define DMB() do {} while (0)
-#define DSB() do {} while (0)
-#define ISB() do {} while (0)
-// Mock cache functions for simulation
-extern void mock_dcache_clean_range(uint32_t addr, uint32_t len);
-extern void mock_dcache_invalidate_range(uint32_t addr, uint32_t len);
+// Barrier audit: every barrier is counted by kind so the benchmark can report
+// barriers per packet. Host and CHIP share one address space here, so the fences
+// are only executed when building with -DSIM_EXEC_BARRIERS (to measure their cost).
+enum sim_barrier_kind {
+    SIM_BARRIER_DMB,
+    SIM_BARRIER_DSB,
+    SIM_BARRIER_ISB,
+    SIM_BARRIER_DMB_ST,
+    SIM_BARRIER_DMB_LD,
+    SIM_BARRIER_KINDS,
+};
+// Per thread, so HOST threads driving different CHIPs do not share the counters.
+extern _Thread_local uint64_t sim_barrier_counts[SIM_BARRIER_KINDS];
+
+#ifdef SIM_EXEC_BARRIERS
+#define SIM_BARRIER(kind, fence) do { sim_barrier_counts[kind]++; fence(); } while (0)
+#else
+#define SIM_BARRIER(kind, fence) do { sim_barrier_counts[kind]++; } while (0)
+#endif
+
+#define DMB()    SIM_BARRIER(SIM_BARRIER_DMB, ARCH_DMB)
+#define DSB()    SIM_BARRIER(SIM_BARRIER_DSB, ARCH_DSB)
+#define ISB()    SIM_BARRIER(SIM_BARRIER_ISB, ARCH_ISB)
+#define DMB_ST() SIM_BARRIER(SIM_BARRIER_DMB_ST, ARCH_DMB_ST)
+#define DMB_LD() SIM_BARRIER(SIM_BARRIER_DMB_LD, ARCH_DMB_LD)
+
+// Mock cache functions for simulation (ctx is the device's cache_sim model)
+extern void mock_dcache_clean_range(void *ctx, uint32_t addr, uint32_t len);
+extern void mock_dcache_invalidate_range(void *ctx, uint32_t addr, uint32_t len);
 #endif // SIMULATION_MODE
 
+// D-cache line size of the HOST (and the granularity of cache maintenance)
+#define DCACHE_LINE_SIZE            32U
+
+// Applies a D-cache maintenance routine to len bytes at off of the ring at BUS address
+// base, split in two calls where the range wraps past the end of the ring.
+// ctx is passed through to op (the simulated cache of the device).
+static inline void dcache_ring_range(void (*op)(void *ctx, uint32_t addr, uint32_t len), void *ctx,
+                                     uint32_t base, uint32_t size, uint32_t off, uint32_t len) {
+    uint32_t first = ring_contig(off, len, size);
+    op(ctx, base + off, first);
+    if (first < len) {
+        op(ctx, base, len - first);
+    }
+}
+
+// --- Ring Publish/Observe Barriers ---
+// Each ring pointer exchange needs one ordering guarantee; these name it so the
+// policy can pick the fence:
+//   BARRIER_RING_PUBLISH()  ring data stores (and cache clean) -> producer pointer store
+//   BARRIER_RING_OBSERVE()  peer pointer load (and cache invalidate) -> ring data loads
+//   BARRIER_RING_RELEASE()  ring data loads -> consumer pointer store
+//   BARRIER_DOORBELL()      after a pointer store to a CHIP register
+// The default (full) policy keeps the conservative DMB / DSB+ISB sequences.
+// BARRIER_POLICY_MINIMAL uses the weakest fence that is still correct: one-way
+// DMBs, and nothing after the doorbell since a posted device write needs no
+// completion before the driver continues. Cache maintenance routines are expected
+// to complete their own operations (as the SoC D-Cache APIs do with a trailing DSB).
+#ifdef BARRIER_POLICY_MINIMAL
+#define BARRIER_RING_PUBLISH() DMB_ST()
+#define BARRIER_RING_OBSERVE() DMB_LD()
+#define BARRIER_RING_RELEASE() DMB_LD()
+#define BARRIER_DOORBELL()     COMPILER_BARRIER()
+#else
+#define BARRIER_RING_PUBLISH() DMB()
+#define BARRIER_RING_OBSERVE() DMB()
+#define BARRIER_RING_RELEASE() DMB()
+#define BARRIER_DOORBELL()     do { DSB(); ISB(); } while (0)
+#endif // BARRIER_POLICY_MINIMAL
+
 
 // --- Packet Framing Assumptions ---
 #define PACKET_LENGTH_FIELD_SIZE    2 // Bytes
 
+// --- TX Segmentation Offload ---
+// A TX ring record whose length field holds TX_LEN_TSO carries a super-frame: a
+// struct tx_tso_desc follows, then desc.len bytes of frame. The CHIP cuts it into
+// segments of hdr_len header bytes (replicated) plus up to mss payload bytes, adjusting
+// two big-endian header fields per segment: the 32-bit sequence number at seq_off
+// advances by the segment's payload offset, and the 16-bit length at len_off becomes
+// the segment length minus len_adj (for IPv4 behind Ethernet: len_off 16, len_adj 14).
+// No ring can hold a frame of 0xFFFF bytes, so the marker is never a real length.
+#define TX_LEN_TSO                  0xFFFFU
+#define TX_TSO_NO_FIELD             0xFFU    // seq_off / len_off: no such field
+
+struct tx_tso_params {
+    uint16_t mss;            // Payload bytes per segment, > 0
+    uint8_t hdr_len;         // Header bytes at the front of the super-frame
+    uint8_t seq_off;         // Offset of the sequence number in the header, or TX_TSO_NO_FIELD
+    uint8_t len_off;         // Offset of the length field in the header, or TX_TSO_NO_FIELD
+    uint8_t len_adj;         // Header bytes the length field does not cover
+};
+
+struct tx_tso_desc {
+    uint16_t len;            // Super-frame bytes, header included
+    struct tx_tso_params p;
+};
+
+#define TX_TSO_DESC_SIZE            8U
+_Static_assert(sizeof(struct tx_tso_desc) == TX_TSO_DESC_SIZE, "tx_tso_desc layout");
+// Ring bytes taken by the marker and descriptor in front of a super-frame
+#define TX_TSO_RECORD_OVERHEAD      (PACKET_LENGTH_FIELD_SIZE + TX_TSO_DESC_SIZE)
+
+// --- Simulation Logging ---
+// Per-packet trace output is on by default for the interactive demo. The benchmark
+// runner turns it off so printf() does not dominate the measured driver cost.
+extern int sim_log_enabled;
+#define SIM_LOG(...) do { if (sim_log_enabled) printf(__VA_ARGS__); } while (0)
+
 #endif // SHARED_H
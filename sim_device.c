@@ -0,0 +1,23 @@
+#include "sim_device.h"
+#include "host.h"
+
+void sim_device_init(struct sim_device *dev) {
+    memset(dev->regs, 0, sizeof(dev->regs));
+    memset(dev->shared_ram, 0, sizeof(dev->shared_ram));
+    dev->time_ns = 0;
+    if (dev->cache.enabled) {
+        cache_sim_reset(&dev->cache);
+    }
+}
+
+void sim_device_host_bus(struct sim_device *dev, struct host_chip_bus *bus) {
+    bus->regs = sim_device_regs(dev);
+    bus->tx_ring = sim_device_tx_ring(dev);
+    bus->rx_ring = sim_device_rx_ring(dev);
+    bus->tx_compl_cookies = sim_device_tx_compl_cookies(dev);
+    bus->tx_compl_ring = sim_device_tx_compl_ring(dev);
+    bus->rx_split_ring = sim_device_rx_split_ring(dev);
+    bus->rx_split_fill = sim_device_rx_split_fill(dev);
+    bus->rx_split_pool = sim_device_rx_split_pool(dev);
+    bus->dcache_ctx = &dev->cache;
+}
@@ -0,0 +1,66 @@
+#ifndef SIM_DEVICE_H
+#define SIM_DEVICE_H
+
+#include <stdint.h>
+#include "shared.h"
+#include "cache_sim.h"
+
+struct host_chip_bus;
+
+// --- Simulated CHIP Hardware ---
+// Everything one CHIP contributes to the simulated system: its register block, the
+// shared RAM holding both rings, the cache model in front of that RAM and the
+// virtual clock. A process can simulate any number of devices; the HOST driver
+// (struct host_chip) and the emulator (struct chip_emulator) keep their own state
+// and are bound to one device each. Every device sees its shared RAM at the same
+// BUS window (SHARED_RAM_BASE_ADDR), like CHIPs on separate buses.
+
+// Virtual time advanced per chip_emulator_run_cycle(). Timing models (idle states,
+// ...) use the device clock instead of wall-clock time.
+#define CHIP_CYCLE_NS               100U
+
+struct sim_device {
+    uint32_t regs[CHIP_NUM_REGS];                 // Register block (BUS_READ_REG base)
+    _Alignas(DCACHE_LINE_SIZE) uint8_t shared_ram[TOTAL_SHARED_MEMORY_SIZE]; // Rings, TX completions, RX split
+    uint64_t time_ns;                             // Virtual clock
+    struct cache_sim cache;                       // Disabled unless cache_sim_enable()d
+};
+
+// Clears registers, shared RAM and clock; resets (but keeps enabled) the cache model
+void sim_device_init(struct sim_device *dev);
+// Bus resources for host_chip_driver_init()
+void sim_device_host_bus(struct sim_device *dev, struct host_chip_bus *bus);
+
+static inline uintptr_t sim_device_regs(struct sim_device *dev) {
+    return (uintptr_t)dev->regs;
+}
+
+static inline uint8_t *sim_device_tx_ring(struct sim_device *dev) {
+    return dev->shared_ram + (TX_BUFFER_START_ADDR - SHARED_RAM_BASE_ADDR);
+}
+
+static inline uint8_t *sim_device_rx_ring(struct sim_device *dev) {
+    return dev->shared_ram + (RX_BUFFER_START_ADDR - SHARED_RAM_BASE_ADDR);
+}
+
+static inline uint32_t *sim_device_tx_compl_cookies(struct sim_device *dev) {
+    return (uint32_t *)(dev->shared_ram + (TX_COMPL_COOKIE_START_ADDR - SHARED_RAM_BASE_ADDR));
+}
+
+static inline struct tx_completion *sim_device_tx_compl_ring(struct sim_device *dev) {
+    return (struct tx_completion *)(dev->shared_ram + (TX_COMPL_RING_START_ADDR - SHARED_RAM_BASE_ADDR));
+}
+
+static inline struct rx_split_entry *sim_device_rx_split_ring(struct sim_device *dev) {
+    return (struct rx_split_entry *)(dev->shared_ram + (RX_SPLIT_RING_START_ADDR - SHARED_RAM_BASE_ADDR));
+}
+
+static inline uint16_t *sim_device_rx_split_fill(struct sim_device *dev) {
+    return (uint16_t *)(dev->shared_ram + (RX_SPLIT_FILL_START_ADDR - SHARED_RAM_BASE_ADDR));
+}
+
+static inline uint8_t *sim_device_rx_split_pool(struct sim_device *dev) {
+    return dev->shared_ram + (RX_SPLIT_POOL_START_ADDR - SHARED_RAM_BASE_ADDR);
+}
+
+#endif // SIM_DEVICE_H